@@ -116,6 +116,9 @@ namespace golos {
                     }
 
                     _block_log.open(data_dir / "block_log");
+                    if (_store_virtual_operations) {
+                        _virtual_op_log.open(data_dir / "virtual_op_log");
+                    }
 
                     auto log_head = _block_log.head();
 
@@ -135,6 +138,11 @@ namespace golos {
 
                         _fork_db.start_block(*head_block);
                     }
+
+                    if (_store_virtual_operations && _virtual_op_log.head_block_num() < head_block_num()) {
+                        wlog("Virtual operation log ends at block ${n}, replay the blockchain to fill it",
+                             ("n", _virtual_op_log.head_block_num()));
+                    }
                     end = fc::time_point::now();
                     wlog("Done opening block log, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
                 }
@@ -196,6 +204,9 @@ namespace golos {
                     apply_block(itr.first, skip_flags);
                     set_reserved_memory(0);
                     set_revision(head_block_num());
+
+                    // all blocks of the block log are irreversible
+                    write_virtual_operations(head_block_num());
                 });
 
                 if (_block_log.head()->block_num()) {
@@ -210,6 +221,90 @@ namespace golos {
 
         }
 
+        uint32_t database::import_blocks(const fc::path &block_log_file) {
+            try {
+                block_log source;
+                source.open(block_log_file);
+                if (!source.head() || source.head()->block_num() <= head_block_num()) {
+                    ilog("No blocks after ${n} in ${f}", ("n", head_block_num())("f", block_log_file));
+                    return 0;
+                }
+
+                auto log_head = _block_log.head();
+                FC_ASSERT((log_head ? log_head->block_num() : 0) == head_block_num(),
+                          "Block log doesn't end at the head block, can't import blocks",
+                          ("log_head", log_head ? log_head->block_num() : 0)("head_block", head_block_num()));
+                if (head_block_num()) {
+                    auto block = source.read_block_by_num(head_block_num());
+                    FC_ASSERT(block.valid() && block->id() == head_block_id(),
+                              "Blocks in ${f} are on another chain", ("f", block_log_file));
+                }
+
+                auto start = fc::time_point::now();
+                auto first_block_num = head_block_num() + 1;
+                auto last_block_num = source.head()->block_num();
+                ilog("Importing blocks ${first} - ${last} from ${f}",
+                     ("first", first_block_num)("last", last_block_num)("f", block_log_file));
+
+                // unlike on replay the blocks come from an untrusted source, so they are checked
+                // as blocks from the network, only the block log is appended below
+                uint64_t skip_flags = skip_block_log;
+
+                with_strong_write_lock([&]() {
+                    _fork_db.reset();
+
+                    // blocks are applied without undo sessions, so a failed block leaves its changes in the state,
+                    // the revision doesn't match the head block until the import succeeds and open() fails on it,
+                    // which makes the chain plugin replay the blockchain
+                    set_revision(std::numeric_limits<int64_t>::max());
+
+                    try {
+                        auto itr = source.read_block(source.get_block_pos(first_block_num));
+                        set_reserved_memory(1024*1024*1024); // protect from memory fragmentations ...
+                        while (true) {
+                            auto cur_block_num = itr.first.block_num();
+                            if (cur_block_num % 100000 == 0) {
+                                std::cerr
+                                    << "   " << double(cur_block_num * 100) / last_block_num << "%   "
+                                    << cur_block_num << " of " << last_block_num
+                                    << "   ("  << (free_memory() / (1024 * 1024)) << "M free"
+                                    << ", elapsed " << double((fc::time_point::now() - start).count()) / 1000000.0 << " sec)\n";
+                            }
+                            apply_block(itr.first, skip_flags);
+                            _block_log.append(itr.first);
+                            check_free_memory(true, cur_block_num);
+                            if (cur_block_num == last_block_num) {
+                                break;
+                            }
+                            itr = source.read_block(itr.second);
+                        }
+                    } catch (...) {
+                        set_reserved_memory(0);
+                        // blocks applied before the failed one are kept for the replay
+                        _block_log.flush();
+                        elog("Failed to import block ${n} from ${f}, the state is inconsistent, "
+                             "the blockchain will be replayed on the next start",
+                             ("n", head_block_num() + 1)("f", block_log_file));
+                        throw;
+                    }
+                    set_reserved_memory(0);
+                    _block_log.flush();
+                    set_revision(head_block_num());
+
+                    // all imported blocks are in the block log
+                    write_virtual_operations(head_block_num());
+
+                    _fork_db.start_block(*_block_log.head());
+                });
+
+                auto end = fc::time_point::now();
+                ilog("Done importing ${n} blocks, elapsed time: ${t} sec",
+                     ("n", head_block_num() - first_block_num + 1)("t", double((end - start).count()) / 1000000.0));
+                return head_block_num() - first_block_num + 1;
+            }
+            FC_CAPTURE_AND_RETHROW((block_log_file))
+        }
+
         void database::set_min_free_shared_memory_size(size_t value) {
             _min_free_shared_memory_size = value;
         }
@@ -234,6 +329,14 @@ namespace golos {
             _skip_virtual_ops = true;
         }
 
+        void database::set_store_virtual_operations(bool value) {
+            _store_virtual_operations = value;
+        }
+
+        bool database::store_virtual_operations() const {
+            return _store_virtual_operations;
+        }
+
         bool database::_resize(uint32_t current_block_num) {
             if (_inc_shared_memory_size == 0) {
                 elog("Auto-scaling of shared file size is not configured!. Do it immediately!");
@@ -304,6 +407,8 @@ namespace golos {
             if (include_blocks) {
                 fc::remove_all(data_dir / "block_log");
                 fc::remove_all(data_dir / "block_log.index");
+                fc::remove_all(data_dir / "virtual_op_log");
+                fc::remove_all(data_dir / "virtual_op_log.index");
             }
         }
 
@@ -319,6 +424,9 @@ namespace golos {
 
                 _block_log.close();
 
+                _virtual_op_log.close();
+                _reversible_virtual_ops.clear();
+
                 _fork_db.reset();
             }
             FC_CAPTURE_AND_RETHROW()
@@ -1160,11 +1268,87 @@ namespace golos {
             }
 
             FC_ASSERT(is_virtual_operation(op));
+            if (_applying_virtual_ops != nullptr) {
+                logged_virtual_operation logged;
+                logged.trx_in_block = _current_trx_in_block;
+                logged.op_in_trx = _current_op_in_trx;
+                logged.op = op;
+                _applying_virtual_ops->operations.push_back(std::move(logged));
+            }
+
             operation_notification note(op);
             notify_pre_apply_operation(note);
             notify_post_apply_operation(note);
         }
 
+        void database::write_virtual_operations(uint32_t last_block_num) {
+            auto itr = _reversible_virtual_ops.begin();
+            for (; itr != _reversible_virtual_ops.end() && itr->first <= last_block_num; ++itr) {
+                // a gap in the log can be filled only by a replay
+                if (itr->first == _virtual_op_log.head_block_num() + 1) {
+                    _virtual_op_log.append(itr->second);
+                }
+            }
+            if (itr != _reversible_virtual_ops.begin()) {
+                _reversible_virtual_ops.erase(_reversible_virtual_ops.begin(), itr);
+                _virtual_op_log.flush();
+            }
+        }
+
+        optional<block_virtual_operations> database::fetch_virtual_operations_by_number(uint32_t num) const {
+            try {
+                auto itr = _reversible_virtual_ops.find(num);
+                if (itr != _reversible_virtual_ops.end() && itr->second.block_num <= head_block_num()) {
+                    return itr->second;
+                }
+                if (_store_virtual_operations) {
+                    return _virtual_op_log.read_block_by_num(num);
+                }
+                return optional<block_virtual_operations>();
+            } FC_CAPTURE_AND_RETHROW((num))
+        }
+
+        std::vector<block_virtual_operations> database::fetch_virtual_operations_in_range(
+                uint32_t first, uint32_t last) const {
+            try {
+                std::vector<block_virtual_operations> result;
+                last = std::min(last, head_block_num());
+                if (first > last) {
+                    return result;
+                }
+                if (_store_virtual_operations) {
+                    result = _virtual_op_log.read_range(first, last);
+                    if (!result.empty()) {
+                        first = result.back().block_num + 1;
+                    }
+                }
+                for (auto itr = _reversible_virtual_ops.lower_bound(first);
+                     itr != _reversible_virtual_ops.end() && itr->first <= last; ++itr) {
+                    result.push_back(itr->second);
+                }
+                return result;
+            } FC_CAPTURE_AND_RETHROW((first)(last))
+        }
+
+        uint32_t database::first_stored_virtual_operations_block() const {
+            uint32_t first = head_block_num() + 1;
+            if (!_store_virtual_operations) {
+                return first;
+            }
+            // operations of reversible blocks are in memory and the log covers blocks from the first one
+            while (first > 1 && _reversible_virtual_ops.count(first - 1)) {
+                --first;
+            }
+            if (first <= _virtual_op_log.head_block_num() + 1) {
+                first = 1;
+            }
+            return first;
+        }
+
+        void database::notify_pre_apply_block(const signed_block &block) {
+            STEEMIT_TRY_NOTIFY(pre_apply_block, block)
+        }
+
         void database::notify_applied_block(const signed_block &block) {
             STEEMIT_TRY_NOTIFY(applied_block, block)
         }
@@ -3081,11 +3265,21 @@ namespace golos {
 
             // in case of multi-thread application, it's allow to validate transaction in read-thread
             if ((skip & validate_transaction_steps) != validate_transaction_steps) {
+                // stateless checks and recovery of signature keys, the most expensive part, don't need the lock,
+                //  so they don't hold up the writer, only authorities and TaPoS are checked under the read lock
+                if (!(skip & skip_validate_operations)) {
+                    trx.validate();
+                }
+                flat_set<public_key_type> signature_keys;
+                if (!(skip & (skip_transaction_signatures | skip_authority_check))) {
+                    signature_keys = trx.get_signature_keys(STEEMIT_CHAIN_ID);
+                }
+
                 // this method can be used only for push_transaction(),
                 //  because such transactions only added to pending list,
                 //  and they will be rechecked on block generation
                 with_weak_read_lock([&] {
-                    _validate_transaction(trx, skip);
+                    _validate_transaction(trx, skip | skip_validate_operations, &signature_keys);
                 });
 
                 skip |= validate_transaction_steps;
@@ -3102,7 +3296,8 @@ namespace golos {
             return skip;
         }
 
-        void database::_validate_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::_validate_transaction(const signed_transaction &trx, uint32_t skip,
+                const flat_set<public_key_type> *signature_keys) {
             if (!(skip & skip_validate_operations)) {   /* issue #505 explains why this skip_flag is disabled */
                 trx.validate();
             }
@@ -3123,7 +3318,12 @@ namespace golos {
                 };
 
                 try {
-                    trx.verify_authority(chain_id, get_active, get_owner, get_posting, STEEMIT_MAX_SIG_CHECK_DEPTH);
+                    if (signature_keys) {
+                        protocol::verify_authority(trx.operations, *signature_keys,
+                            get_active, get_owner, get_posting, STEEMIT_MAX_SIG_CHECK_DEPTH);
+                    } else {
+                        trx.verify_authority(chain_id, get_active, get_owner, get_posting, STEEMIT_MAX_SIG_CHECK_DEPTH);
+                    }
                 }
                 catch (protocol::tx_missing_active_auth &e) {
                     if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end()) {
@@ -3223,7 +3423,12 @@ namespace golos {
                     }
                 }
 
-                _apply_block(next_block, skip);
+                try {
+                    _apply_block(next_block, skip);
+                } catch (...) {
+                    _applying_virtual_ops = nullptr;
+                    throw;
+                }
 
                 /*try
    {
@@ -3274,6 +3479,16 @@ namespace golos {
                 _current_block_num = next_block_num;
                 _current_trx_in_block = 0;
 
+                if (_store_virtual_operations) {
+                    // the block replaces popped or failed blocks with the same number
+                    _reversible_virtual_ops.erase(
+                        _reversible_virtual_ops.lower_bound(next_block_num), _reversible_virtual_ops.end());
+                    _applying_virtual_ops = &_reversible_virtual_ops[next_block_num];
+                    _applying_virtual_ops->block_num = next_block_num;
+                }
+
+                notify_pre_apply_block(next_block);
+
                 /// modify current witness so transaction evaluators can know who included the transaction,
                 /// this is mostly for POW operations which must pay the current_witness
                 modify(gprops, [&](dynamic_global_property_object &dgp) {
@@ -3333,6 +3548,11 @@ namespace golos {
 
                 process_hardforks();
 
+                if (_store_virtual_operations) {
+                    _applying_virtual_ops = nullptr;
+                    write_virtual_operations(last_non_undoable_block_num());
+                }
+
                 // notify observers that the block has been applied
                 notify_applied_block(next_block);
 
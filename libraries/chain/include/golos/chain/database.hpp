@@ -4,6 +4,7 @@
 #include <golos/chain/node_property_object.hpp>
 #include <golos/chain/fork_database.hpp>
 #include <golos/chain/block_log.hpp>
+#include <golos/chain/virtual_op_log.hpp>
 #include <golos/chain/hardfork.hpp>
 #include <golos/protocol/protocol.hpp>
 
@@ -89,6 +90,21 @@ namespace golos {
             void reindex(const fc::path &data_dir, const fc::path &shared_mem_dir, uint64_t shared_file_size = (
                     1024l * 1024l * 1024l * 8l));
 
+            /**
+             * @brief Apply blocks from a block log file that follow the head block
+             *
+             * Blocks are applied without undo sessions like on replay, but checked as blocks from the network:
+             * signatures, the witness schedule, the merkle roots, TaPoS, duplicate transactions, operations and
+             * invariants, so the file doesn't need to be trusted. Applied blocks are irreversible and are appended
+             * to the block log. The database must be open.
+             *
+             * If a block fails, the exception is rethrown and the state is left inconsistent, the next open
+             * replays the block log, which contains only the blocks applied successfully.
+             *
+             * @return number of applied blocks
+             */
+            uint32_t import_blocks(const fc::path &block_log_file);
+
             void set_min_free_shared_memory_size(size_t);
             void set_inc_shared_memory_size(size_t);
             void set_block_num_check_free_size(uint32_t);
@@ -98,6 +114,14 @@ namespace golos {
             void set_skip_virtual_ops();
             bool clear_votes();
 
+            /**
+             * Write virtual operations of irreversible blocks to the virtual_op_log file in the data dir,
+             * should be called before open()
+             */
+            void set_store_virtual_operations(bool value);
+
+            bool store_virtual_operations() const;
+
             /**
              * @brief wipe Delete database from disk, and potentially the raw chain as well.
              * @param include_blocks If true, delete the raw chain as well as the database.
@@ -130,6 +154,23 @@ namespace golos {
 
             optional<signed_block> fetch_block_by_number(uint32_t num) const;
 
+            /**
+             *  @return virtual operations of the block if they are stored, reversible blocks are served
+             *  from memory and irreversible ones from the virtual operation log
+             */
+            optional<block_virtual_operations> fetch_virtual_operations_by_number(uint32_t num) const;
+
+            /**
+             *  @return virtual operations of stored blocks from first to last inclusive, in the order of blocks
+             */
+            std::vector<block_virtual_operations> fetch_virtual_operations_in_range(uint32_t first, uint32_t last) const;
+
+            /**
+             *  @return the first block from which virtual operations are stored up to the head block,
+             *  the log has a gap after a run without storing them until the blockchain is replayed
+             */
+            uint32_t first_stored_virtual_operations_block() const;
+
             const signed_transaction get_recent_transaction(const transaction_id_type &trx_id) const;
 
             std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
@@ -251,6 +292,8 @@ namespace golos {
             void notify_post_apply_operation(const operation_notification &note);
 
             inline const void push_virtual_operation(const operation &op, bool force = false); // vops are not needed for low mem. Force will push them on low mem.
+            void notify_pre_apply_block(const signed_block &block);
+
             void notify_applied_block(const signed_block &block);
 
             void notify_on_pending_transaction(const signed_transaction &tx);
@@ -263,6 +306,12 @@ namespace golos {
             fc::signal<void(const operation_notification &)> pre_apply_operation;
             fc::signal<void(const operation_notification &)> post_apply_operation;
 
+            /**
+             *  This signal is emitted before operations of a block are applied, operations notified
+             *  between it and applied_block belong to the block (unless the block fails to apply).
+             */
+            fc::signal<void(const signed_block &)> pre_apply_block;
+
             /**
              *  This signal is emitted after all operations and virtual operation for a
              *  block have been applied but before the get_applied_operations() are cleared.
@@ -528,7 +577,9 @@ namespace golos {
 
             void _apply_transaction(const signed_transaction &trx, uint32_t skip);
 
-            void _validate_transaction(const signed_transaction& trx, uint32_t skip);
+            /// signature_keys are the keys recovered from signatures of the transaction, if they are recovered already
+            void _validate_transaction(const signed_transaction& trx, uint32_t skip,
+                const boost::container::flat_set<golos::protocol::public_key_type> *signature_keys = nullptr);
 
             void apply_operation(const operation &op);
 
@@ -579,6 +630,15 @@ namespace golos {
 
             block_log _block_log;
 
+            bool _store_virtual_operations = false;
+            virtual_op_log _virtual_op_log;
+            // virtual operations of reversible blocks, they are written to the log as blocks become irreversible
+            std::map<uint32_t, block_virtual_operations> _reversible_virtual_ops;
+            // operations of the applying block, virtual operations of pending transactions are not stored
+            block_virtual_operations *_applying_virtual_ops = nullptr;
+
+            void write_virtual_operations(uint32_t last_block_num);
+
             // this function needs access to _plugin_index_signal
             template<typename MultiIndexType>
             friend void add_plugin_index(database &db);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <golos/protocol/operations.hpp>
+
+namespace golos {
+    namespace chain {
+
+        using namespace golos::protocol;
+
+        namespace detail { class virtual_op_log_impl; }
+
+        /**
+         *  Virtual operation with its position in the block. Operations of transactions are kept
+         *  in the block itself, a virtual operation follows the operation of the transaction
+         *  which caused it, or all transactions if trx_in_block is the count of transactions.
+         */
+        struct logged_virtual_operation {
+            uint32_t trx_in_block = 0;
+            uint16_t op_in_trx = 0;
+            operation op;
+        };
+
+        struct block_virtual_operations {
+            uint32_t block_num = 0;
+            std::vector<logged_virtual_operation> operations;
+        };
+
+        /* The virtual operation log is an external append only log of virtual operations, which are
+         * emitted while applying blocks. Each block since the first one has an entry, an empty one if
+         * the block has no virtual operations, so the log is written only after blocks become
+         * irreversible, the same as the block log. The layout of the files is the same as of
+         * the block log:
+         *
+         * +-----------------+----------------+-----------------+----------------+-----+
+         * | Block 1 entry   | Pos of entry 1 | Block 2 entry   | Pos of entry 2 | ... |
+         * +-----------------+----------------+-----------------+----------------+-----+
+         *
+         * +----------------+----------------+-----+
+         * | Pos of entry 1 | Pos of entry 2 | ... |
+         * +----------------+----------------+-----+
+         *
+         * The index file can be reconstructed during a linear scan of the main file.
+         */
+        class virtual_op_log {
+        public:
+            virtual_op_log();
+
+            ~virtual_op_log();
+
+            /**
+             * In the read only mode the log can be read while another process appends to it,
+             * blocks appended after the opening aren't visible
+             */
+            void open(const fc::path &file, bool read_only = false);
+
+            void close();
+
+            bool is_open() const;
+
+            uint64_t append(const block_virtual_operations &b);
+
+            void flush();
+
+            std::pair<block_virtual_operations, uint64_t> read_block(uint64_t file_pos) const;
+
+            optional<block_virtual_operations> read_block_by_num(uint32_t block_num) const;
+
+            /// Entries of blocks from first_block to last_block inclusive which are in the log
+            std::vector<block_virtual_operations> read_range(uint32_t first_block, uint32_t last_block) const;
+
+            /**
+             * Return offset of block entry in file, or virtual_op_log::npos if it does not exist.
+             */
+            uint64_t get_block_pos(uint32_t block_num) const;
+
+            /// Number of the last block in the log, 0 if the log is empty
+            uint32_t head_block_num() const;
+
+            static const uint64_t npos = std::numeric_limits<uint64_t>::max();
+
+        private:
+            void construct_index();
+
+            std::unique_ptr<detail::virtual_op_log_impl> my;
+        };
+
+    }
+}
+
+FC_REFLECT((golos::chain::logged_virtual_operation), (trx_in_block)(op_in_trx)(op))
+FC_REFLECT((golos::chain::block_virtual_operations), (block_num)(operations))
@@ -0,0 +1,274 @@
+#include <golos/chain/virtual_op_log.hpp>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+#define LOG_READ  (std::ios::in | std::ios::binary)
+#define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
+
+namespace golos {
+    namespace chain {
+
+        namespace detail {
+            class virtual_op_log_impl {
+            public:
+                uint32_t head_block_num = 0;
+                bool read_only = false;
+                std::fstream log_stream;
+                std::fstream index_stream;
+                fc::path log_file;
+                fc::path index_file;
+                bool log_write;
+                bool index_write;
+                std::mutex mutex;
+
+                inline void check_log_read() {
+                    if (log_write) {
+                        log_stream.close();
+                        log_stream.open(log_file.generic_string().c_str(), LOG_READ);
+                        log_write = false;
+                    }
+                }
+
+                inline void check_log_write() {
+                    if (!log_write) {
+                        log_stream.close();
+                        log_stream.open(log_file.generic_string().c_str(), LOG_WRITE);
+                        log_write = true;
+                    }
+                }
+
+                inline void check_index_read() {
+                    if (index_write) {
+                        index_stream.close();
+                        index_stream.open(index_file.generic_string().c_str(), LOG_READ);
+                        index_write = false;
+                    }
+                }
+
+                inline void check_index_write() {
+                    if (!index_write) {
+                        index_stream.close();
+                        index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+                        index_write = true;
+                    }
+                }
+
+                block_virtual_operations read_entry(uint64_t pos, uint64_t &next_pos) {
+                    block_virtual_operations result;
+                    check_log_read();
+                    log_stream.seekg(pos);
+                    fc::raw::unpack(log_stream, result);
+                    next_pos = uint64_t(log_stream.tellg()) + 8;
+                    return result;
+                }
+            };
+        }
+
+        virtual_op_log::virtual_op_log()
+                : my(new detail::virtual_op_log_impl()) {
+            my->log_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+            my->index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+        }
+
+        virtual_op_log::~virtual_op_log() {
+            flush();
+        }
+
+        void virtual_op_log::open(const fc::path &file, bool read_only) {
+            if (my->log_stream.is_open()) {
+                my->log_stream.close();
+            }
+            if (my->index_stream.is_open()) {
+                my->index_stream.close();
+            }
+
+            my->log_file = file;
+            my->index_file = fc::path(file.generic_string() + ".index");
+            my->read_only = read_only;
+
+            if (read_only) {
+                // entries are written before their positions in the index, so the indexed ones are complete
+                my->log_stream.open(my->log_file.generic_string().c_str(), LOG_READ);
+                my->index_stream.open(my->index_file.generic_string().c_str(), LOG_READ);
+                my->log_write = false;
+                my->index_write = false;
+                my->head_block_num = fc::file_size(my->index_file) / sizeof(uint64_t);
+                return;
+            }
+
+            my->log_stream.open(my->log_file.generic_string().c_str(), LOG_WRITE);
+            my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
+            my->log_write = true;
+            my->index_write = true;
+            my->head_block_num = 0;
+
+            // the same states of files as of the block log are possible, see block_log::open()
+            auto log_size = fc::file_size(my->log_file);
+            auto index_size = fc::file_size(my->index_file);
+
+            if (log_size) {
+                uint64_t entry_pos;
+                uint64_t next_pos;
+                my->check_log_read();
+                my->log_stream.seekg(-sizeof(uint64_t), std::ios::end);
+                my->log_stream.read((char *)&entry_pos, sizeof(entry_pos));
+                my->head_block_num = my->read_entry(entry_pos, next_pos).block_num;
+
+                if (index_size) {
+                    my->check_index_read();
+
+                    uint64_t index_pos;
+                    my->index_stream.seekg(-sizeof(uint64_t), std::ios::end);
+                    my->index_stream.read((char *)&index_pos, sizeof(index_pos));
+
+                    if (entry_pos != index_pos) {
+                        ilog("Virtual operation log index is inconsistent");
+                        construct_index();
+                    }
+                } else {
+                    construct_index();
+                }
+            } else if (index_size) {
+                my->index_stream.close();
+                fc::remove_all(my->index_file);
+                my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
+                my->index_write = true;
+            }
+        }
+
+        void virtual_op_log::close() {
+            my.reset(new detail::virtual_op_log_impl());
+        }
+
+        bool virtual_op_log::is_open() const {
+            return my->log_stream.is_open();
+        }
+
+        uint64_t virtual_op_log::append(const block_virtual_operations &b) {
+            try {
+                auto data = fc::raw::pack(b);
+                uint64_t pos;
+                {
+                    std::lock_guard<std::mutex> lock(my->mutex);
+                    FC_ASSERT(!my->read_only, "Virtual operation log is opened for reading");
+                    my->check_log_write();
+                    my->check_index_write();
+
+                    FC_ASSERT(b.block_num == my->head_block_num + 1,
+                              "Virtual operations of block ${b} are appended after block ${h}",
+                              ("b", b.block_num)("h", my->head_block_num));
+
+                    pos = my->log_stream.tellp();
+                    my->log_stream.write(data.data(), data.size());
+                    my->log_stream.write((char *) &pos, sizeof(pos));
+                    my->index_stream.write((char *) &pos, sizeof(pos));
+                    my->head_block_num = b.block_num;
+                }
+
+                return pos;
+            }
+            FC_LOG_AND_RETHROW()
+        }
+
+        void virtual_op_log::flush() {
+            my->log_stream.flush();
+            my->index_stream.flush();
+        }
+
+        std::pair<block_virtual_operations, uint64_t> virtual_op_log::read_block(uint64_t pos) const {
+            std::pair<block_virtual_operations, uint64_t> result;
+            {
+                std::lock_guard<std::mutex> lock(my->mutex);
+                result.first = my->read_entry(pos, result.second);
+            }
+            return result;
+        }
+
+        optional<block_virtual_operations> virtual_op_log::read_block_by_num(uint32_t block_num) const {
+            try {
+                optional<block_virtual_operations> b;
+                uint64_t pos = get_block_pos(block_num);
+                if (pos != npos) {
+                    b = read_block(pos).first;
+                    FC_ASSERT(b->block_num == block_num,
+                              "Wrong block was read from virtual operation log.",
+                              ("returned", b->block_num)
+                              ("expected", block_num));
+                }
+                return b;
+            }
+            FC_LOG_AND_RETHROW()
+        }
+
+        std::vector<block_virtual_operations> virtual_op_log::read_range(
+                uint32_t first_block, uint32_t last_block) const {
+            std::vector<block_virtual_operations> result;
+            first_block = std::max<uint32_t>(first_block, 1);
+            last_block = std::min(last_block, my->head_block_num);
+            if (first_block > last_block) {
+                return result;
+            }
+            result.reserve(last_block - first_block + 1);
+
+            uint64_t pos = get_block_pos(first_block);
+            {
+                // entries of consecutive blocks follow each other
+                std::lock_guard<std::mutex> lock(my->mutex);
+                for (uint32_t num = first_block; num <= last_block; ++num) {
+                    result.push_back(my->read_entry(pos, pos));
+                    FC_ASSERT(result.back().block_num == num,
+                              "Wrong block was read from virtual operation log.",
+                              ("returned", result.back().block_num)
+                              ("expected", num));
+                }
+            }
+            return result;
+        }
+
+        uint64_t virtual_op_log::get_block_pos(uint32_t block_num) const {
+            uint64_t pos;
+            {
+                std::lock_guard<std::mutex> lock(my->mutex);
+
+                if (block_num > my->head_block_num || block_num == 0) {
+                    return npos;
+                }
+
+                my->check_index_read();
+                my->index_stream.seekg(sizeof(uint64_t) * (block_num - 1));
+                my->index_stream.read((char *) &pos, sizeof(pos));
+            }
+            return pos;
+        }
+
+        uint32_t virtual_op_log::head_block_num() const {
+            return my->head_block_num;
+        }
+
+        void virtual_op_log::construct_index() {
+            ilog("Reconstructing Virtual Operation Log Index...");
+            my->index_stream.close();
+            fc::remove_all(my->index_file);
+            my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
+            my->index_write = true;
+
+            uint64_t pos = 0;
+            uint64_t end_pos;
+            my->check_log_read();
+
+            my->log_stream.seekg(-sizeof(uint64_t), std::ios::end);
+            my->log_stream.read((char *)&end_pos, sizeof(end_pos));
+            block_virtual_operations tmp;
+
+            my->log_stream.seekg(pos);
+
+            while (pos <= end_pos) {
+                fc::raw::unpack(my->log_stream, tmp);
+                my->log_stream.read((char *)&pos, sizeof(pos));
+                my->index_stream.write((char *)&pos, sizeof(pos));
+                pos = my->log_stream.tellg();
+            }
+        }
+    }
+}
@@ -46,6 +46,63 @@ namespace golos {
         const core_message_type_enum check_firewall_reply_message::type = core_message_type_enum::check_firewall_reply_message_type;
         const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
         const core_message_type_enum get_current_connections_reply_message::type = core_message_type_enum::get_current_connections_reply_message_type;
+        const core_message_type_enum compact_block_message::type = core_message_type_enum::compact_block_message_type;
+        const core_message_type_enum fetch_block_transactions_message::type = core_message_type_enum::fetch_block_transactions_message_type;
+        const core_message_type_enum block_transactions_message::type = core_message_type_enum::block_transactions_message_type;
+
+        compact_block_message::compact_block_message(const item_hash_t &block_message_hash, const block_message &message)
+                : block_message_hash(block_message_hash),
+                  block_id(message.block_id),
+                  header(message.block) {
+            short_ids.reserve(message.block.transactions.size());
+            for (const auto &trx : message.block.transactions) {
+                short_ids.push_back(transaction_short_id(trx.id()));
+            }
+        }
+
+        compact_block_reconstruction::compact_block_reconstruction(const compact_block_message &compact_block,
+                const std::function<fc::optional<signed_transaction>(uint64_t)> &find_transaction)
+                : compact_block(compact_block) {
+            transactions.reserve(compact_block.short_ids.size());
+            for (uint64_t short_id : compact_block.short_ids) {
+                transactions.push_back(find_transaction(short_id));
+            }
+        }
+
+        std::vector<uint32_t> compact_block_reconstruction::missing_transactions() const {
+            std::vector<uint32_t> result;
+            for (uint32_t i = 0; i < transactions.size(); ++i) {
+                if (!transactions[i]) {
+                    result.push_back(i);
+                }
+            }
+            return result;
+        }
+
+        bool compact_block_reconstruction::add_missing_transactions(const std::vector<signed_transaction> &received) {
+            auto received_transaction = received.begin();
+            for (auto &transaction : transactions) {
+                if (!transaction) {
+                    if (received_transaction == received.end()) {
+                        return false;
+                    }
+                    transaction = *received_transaction++;
+                }
+            }
+            return received_transaction == received.end();
+        }
+
+        block_message compact_block_reconstruction::to_block_message() {
+            block_message result;
+            static_cast<golos::protocol::signed_block_header &>(result.block) = compact_block.header;
+            result.block.transactions.reserve(transactions.size());
+            for (auto &transaction : transactions) {
+                FC_ASSERT(transaction.valid(), "Transaction of the compact block is missing");
+                result.block.transactions.push_back(std::move(*transaction));
+            }
+            result.block_id = compact_block.block_id;
+            return result;
+        }
 
     }
 } // golos::network
@@ -37,6 +37,19 @@
  * 2MiB
  */
 #define MAX_MESSAGE_SIZE                                     1024*1024*2
+
+/**
+ * Size of the chunks read from a peer's socket, one read usually brings
+ * several messages.  Must be a multiple of 16 (the size of an encrypted block)
+ */
+#define GRAPHENE_NET_READ_BUFFER_SIZE                        (64 * 1024)
+
+/**
+ * Maximum size of a chunk encrypted and written to a peer's socket at once,
+ * bigger chunks mean fewer writes and longer runs of the cipher.
+ * Must be a multiple of 16
+ */
+#define GRAPHENE_NET_WRITE_BUFFER_SIZE                       (64 * 1024)
 #define GRAPHENE_NET_DEFAULT_PEER_CONNECTION_RETRY_TIME      30 // seconds
 
 /**
@@ -79,8 +92,40 @@
 
 #define GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES           2
 
+/**
+ * Each peer has a filter of the transactions it has seen (we advertised them to it or
+ * it advertised them to us), which remembers at least this many recent transactions.
+ * Blocks are tracked exactly.
+ * It takes about 2 bytes per item per generation, there are two generations.
+ */
+#define GRAPHENE_NET_INVENTORY_FILTER_CAPACITY               20000
+
+/**
+ * New transactions are collected for this long before they are advertised
+ * to peers, so each peer gets one inventory message for all of them.
+ * Blocks are advertised at once, along with the collected transactions.
+ */
+#define GRAPHENE_NET_INVENTORY_FLUSH_INTERVAL_MS             100
+
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * During sync, blocks are requested from all peers at once and the number of
+ * outstanding requests to each peer follows its throughput: a peer gets enough
+ * requests to keep it busy for GRAPHENE_NET_SYNC_REQUEST_WINDOW_SECONDS, but no
+ * fewer than GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING and no more than
+ * the maximum above.
+ */
+#define GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING      20
+#define GRAPHENE_NET_SYNC_REQUEST_WINDOW_SECONDS             2
+
+/**
+ * A sync block that holds up processing of the blocks after it and isn't
+ * delivered in this many seconds is requested from another peer as well,
+ * whichever copy arrives first is used.
+ */
+#define GRAPHENE_NET_SYNC_ITEM_REASSIGN_TIMEOUT_SECONDS      5
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -103,3 +148,9 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+/**
+ * No more transactions are fetched from peers while the client is validating
+ * this many, so they can't queue up without bound when the client is busy
+ */
+#define GRAPHENE_NET_MAX_TRANSACTIONS_BEING_VALIDATED        50
@@ -35,8 +35,10 @@
 #include <fc/variant_object.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/io/enum_type.hpp>
+#include <fc/optional.hpp>
 
-
+#include <cstring>
+#include <functional>
 #include <vector>
 
 namespace golos {
@@ -89,6 +91,9 @@ namespace golos {
             check_firewall_reply_message_type = 5015,
             get_current_connections_request_message_type = 5016,
             get_current_connections_reply_message_type = 5017,
+            compact_block_message_type = 5018,
+            fetch_block_transactions_message_type = 5019,
+            block_transactions_message_type = 5020,
             core_message_type_last = 5099
         };
 
@@ -122,6 +127,98 @@ namespace golos {
 
         };
 
+        /**
+         *  First 8 bytes of the transaction id. Short ids of different transactions may coincide,
+         *  so a block assembled by short ids should be checked against its hash.
+         */
+        inline uint64_t transaction_short_id(const transaction_id_type &id) {
+            uint64_t result;
+            memcpy(&result, id.data(), sizeof(result));
+            return result;
+        }
+
+        /**
+         *  Block with short ids of its transactions instead of the transactions themselves.
+         *
+         *  It is sent instead of block_message to peers which announced support of compact blocks
+         *  in the hello message and requested the block with the fetch_items_message of this type.
+         *  The peer takes the transactions it has already received from its message cache
+         *  and requests the rest with fetch_block_transactions_message.
+         */
+        struct compact_block_message {
+            static const core_message_type_enum type;
+
+            item_hash_t block_message_hash; ///< hash of the requested block_message
+            block_id_type block_id;
+            golos::protocol::signed_block_header header;
+            std::vector<uint64_t> short_ids;
+
+            compact_block_message() {
+            }
+
+            compact_block_message(const item_hash_t &block_message_hash, const block_message &message);
+        };
+
+        /// Requests transactions of a compact block by their positions in the block
+        struct fetch_block_transactions_message {
+            static const core_message_type_enum type;
+
+            item_hash_t block_message_hash;
+            std::vector<uint32_t> indexes;
+
+            fetch_block_transactions_message() {
+            }
+
+            fetch_block_transactions_message(const item_hash_t &block_message_hash, const std::vector<uint32_t> &indexes)
+                    :
+                    block_message_hash(block_message_hash),
+                    indexes(indexes) {
+            }
+        };
+
+        /// Transactions of a compact block in the order of the request
+        struct block_transactions_message {
+            static const core_message_type_enum type;
+
+            item_hash_t block_message_hash;
+            std::vector<signed_transaction> transactions;
+
+            block_transactions_message() {
+            }
+
+            block_transactions_message(const item_hash_t &block_message_hash)
+                    :
+                    block_message_hash(block_message_hash) {
+            }
+        };
+
+        /**
+         *  Block being rebuilt from a compact block: transactions found by their short ids
+         *  and the ones received from the peer afterwards.
+         */
+        struct compact_block_reconstruction {
+            compact_block_message compact_block;
+            std::vector<fc::optional<signed_transaction>> transactions;
+
+            compact_block_reconstruction() {
+            }
+
+            compact_block_reconstruction(const compact_block_message &compact_block,
+                    const std::function<fc::optional<signed_transaction>(uint64_t)> &find_transaction);
+
+            /// Positions of transactions which weren't found, in the order they are requested from the peer
+            std::vector<uint32_t> missing_transactions() const;
+
+            /// Takes the missing transactions in the order of the request, false if their number is wrong
+            bool add_missing_transactions(const std::vector<signed_transaction> &received);
+
+            /**
+             *  Block message of the compact block with all its transactions, which are moved into it.
+             *  Its hash should match compact_block.block_message_hash, as short ids may coincide.
+             */
+            block_message to_block_message();
+        };
+
         struct item_ids_inventory_message {
             static const core_message_type_enum type;
 
@@ -444,10 +541,16 @@ FC_REFLECT_ENUM(golos::network::core_message_type_enum,
                 (check_firewall_reply_message_type)
                 (get_current_connections_request_message_type)
                 (get_current_connections_reply_message_type)
+                (compact_block_message_type)
+                (fetch_block_transactions_message_type)
+                (block_transactions_message_type)
                 (core_message_type_last))
 
 FC_REFLECT((golos::network::trx_message), (trx))
 FC_REFLECT((golos::network::block_message), (block)(block_id))
+FC_REFLECT((golos::network::compact_block_message), (block_message_hash)(block_id)(header)(short_ids))
+FC_REFLECT((golos::network::fetch_block_transactions_message), (block_message_hash)(indexes))
+FC_REFLECT((golos::network::block_transactions_message), (block_message_hash)(transactions))
 
 FC_REFLECT((golos::network::item_id), (item_type)
         (item_hash))
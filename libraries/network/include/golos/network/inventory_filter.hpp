@@ -0,0 +1,48 @@
+#pragma once
+
+#include <golos/network/core_messages.hpp>
+
+#include <vector>
+
+namespace golos {
+    namespace network {
+
+        /**
+         * Approximate set of transactions recently seen by a peer, used to not advertise them to the peer again.
+         *
+         * It is a bloom filter of two generations: items are added to the current generation, when it
+         * gets full it becomes the previous one and the old previous one is dropped. So an item is
+         * remembered for at least capacity insertions of other items and the memory used is fixed.
+         * An item which was never inserted is reported as seen with the probability of about 0.1%,
+         * an inserted item is always reported as seen while it is remembered.
+         */
+        class inventory_filter final {
+        public:
+            explicit inventory_filter(uint32_t capacity);
+
+            /// @return false if the item was already (maybe) in the filter
+            bool insert(const item_id &item);
+
+            bool contains(const item_id &item) const;
+
+            void clear();
+
+        private:
+            struct generation {
+                std::vector<uint64_t> bits;
+                uint32_t size = 0;
+
+                bool contains(uint64_t h1, uint64_t h2) const;
+
+                void insert(uint64_t h1, uint64_t h2);
+            };
+
+            void rotate();
+
+            uint32_t _capacity;
+            generation _current;
+            generation _previous;
+        };
+
+    }
+} // golos::network
@@ -74,6 +74,11 @@ namespace golos {
 
             fc::sha512 get_shared_secret() const;
 
+            /// allows the connection to be unencrypted if the peer allows it too, set before accept() or connect_to()
+            void set_plaintext_allowed(bool allowed);
+
+            bool is_plaintext() const;
+
         private:
             std::unique_ptr<detail::message_oriented_connection_impl> my;
         };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <golos/network/message.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace golos {
+    namespace network {
+
+        /**
+         * Splits bytes received from a peer into messages.
+         *
+         * Bytes are read in large chunks and every message that is complete in the buffer is returned
+         * before reading again. Messages are padded to the size of an encrypted block, so reads are
+         * requested in whole blocks, but a read may end anywhere. The buffer is grown for a message
+         * larger than it and shrunk back when the message is returned.
+         */
+        class message_reader final {
+        public:
+            static const size_t block_size = 16;
+
+            /// Reads up to length bytes, length is a positive multiple of block_size
+            using read_function = std::function<size_t(char *buffer, size_t length)>;
+
+            explicit message_reader(read_function read);
+
+            /// Reads until the next message is complete, throws if it is larger than MAX_MESSAGE_SIZE
+            void read_message(message &m);
+
+            size_t buffer_size() const {
+                return _buffer.size();
+            }
+
+        private:
+            read_function _read;
+
+            // [_begin, _end) is what hasn't been returned yet
+            std::vector<char> _buffer;
+            size_t _begin = 0;
+            size_t _end = 0;
+        };
+
+    }
+} // golos::network
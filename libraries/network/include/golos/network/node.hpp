@@ -289,6 +289,13 @@ namespace golos {
 
             void set_total_bandwidth_limit(uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second);
 
+            /**
+             *  Connections with peers at these addresses (e.g. over private links) aren't encrypted
+             *  if the peers list this node too.  Peers that don't support it can't connect, so only
+             *  list upgraded nodes.
+             */
+            void set_plaintext_peers(const std::vector<fc::ip::address> &addresses);
+
             fc::variant_object network_get_info() const;
 
             fc::variant_object network_get_usage_stats() const;
@@ -28,6 +28,7 @@
 #include <golos/network/message_oriented_connection.hpp>
 #include <golos/network/stcp_socket.hpp>
 #include <golos/network/config.hpp>
+#include <golos/network/inventory_filter.hpp>
 
 #include <boost/tuple/tuple.hpp>
 
@@ -215,6 +216,7 @@ namespace golos {
             fc::optional<std::string> platform;
             fc::optional<uint32_t> bitness;
             fc::optional<golos::protocol::chain_id_type> chain_id;
+            bool supports_compact_blocks; /// peer can send and receive compact_block_message
 
             // for inbound connections, these fields record what the peer sent us in
             // its hello message.  For outbound, they record what we sent the peer
@@ -236,6 +238,8 @@ namespace golos {
             fc::optional<boost::tuple<std::vector<item_hash_t>, fc::time_point>> item_ids_requested_from_peer; /// we check this to detect a timed-out request and in busy()
             fc::time_point last_sync_item_received_time; /// the time we received the last sync item or the time we sent the last batch of sync item requests to this peer
             std::set<item_hash_t> sync_items_requested_from_peer; /// ids of blocks we've requested from this peer during sync.  fetch from another peer if this peer disconnects
+            std::set<item_hash_t> sync_items_received_from_other_peers; /// ids of blocks requested from this peer during sync that arrived from another peer first, ignored when they arrive
+            fc::microseconds sync_item_interval; /// moving average of the time it takes this peer to deliver a sync item, zero until the first one arrives
             item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
             fc::time_point_sec last_block_time_delegate_has_seen;
             bool inhibit_fetching_sync_blocks;
@@ -262,9 +266,13 @@ namespace golos {
                             boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
                                     boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp>>>> timestamped_items_set_type;
             timestamped_items_set_type inventory_peer_advertised_to_us;
-            timestamped_items_set_type inventory_advertised_to_peer;
+            timestamped_items_set_type blocks_known_to_peer; /// blocks we advertised to this peer or it advertised to us, they aren't advertised to it again
+            inventory_filter transactions_known_to_peer; /// the same for transactions, they are too many to track exactly
 
             item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+            /// compact blocks waiting for the rest of their transactions from the peer, by hash of the block message
+            std::map<item_hash_t, compact_block_reconstruction> compact_blocks_being_reconstructed;
             /// @}
 
             // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -332,6 +340,11 @@ namespace golos {
 
             fc::sha512 get_shared_secret() const;
 
+            /// allows the connection to be unencrypted if the peer allows it too, set before accepting or connecting
+            void set_plaintext_allowed(bool allowed);
+
+            bool is_plaintext() const;
+
             void clear_old_inventory();
 
             bool is_inventory_advertised_to_us_list_full_for_transactions() const;
@@ -33,6 +33,10 @@ namespace golos {
 /**
  *  Uses ECDH to negotiate a aes key for communicating
  *  with other nodes on the network.
+ *
+ *  If both sides allow it, data isn't encrypted after the key exchange (for trusted
+ *  links, the shared secret is still used to authenticate the nodes).  A side allows
+ *  it by flagging the public key it sends, which nodes without this support reject.
  */
         class stcp_socket : public virtual fc::iostream {
         public:
@@ -74,6 +78,22 @@ namespace golos {
                 return _shared_secret;
             }
 
+            /// must be set before the key exchange (accept() or connect_to())
+            void set_plaintext_allowed(bool allowed) {
+                _plaintext_allowed = allowed;
+            }
+
+            /// true if data isn't encrypted, known after the key exchange
+            bool is_plaintext() const {
+                return _plaintext;
+            }
+
+            /// The public key sent in the key exchange, flagged if plaintext is allowed
+            static fc::ecc::public_key_data key_exchange_data(const fc::ecc::public_key &key, bool plaintext_allowed);
+
+            /// Clears the flag in the key received in the key exchange, true if the remote side allows plaintext
+            static bool take_plaintext_flag(fc::ecc::public_key_data &key_data);
+
         private:
             void do_key_exchange();
 
@@ -84,6 +104,8 @@ namespace golos {
             fc::tcp_socket _sock;
             fc::aes_encoder _send_aes;
             fc::aes_decoder _recv_aes;
+            bool _plaintext_allowed = false;
+            bool _plaintext = false;
             std::shared_ptr<char> _read_buffer;
             std::shared_ptr<char> _write_buffer;
 #ifndef NDEBUG
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace golos {
+    namespace network {
+
+        /**
+         * Limits transactions fetched from peers by the number of transactions the client is still
+         * validating, so they can't queue up without bound when the client is busy. Transactions
+         * requested before the limit was reached may still arrive, so the count can exceed it.
+         */
+        class transaction_fetch_throttle final {
+        public:
+            explicit transaction_fetch_throttle(uint32_t max_being_validated)
+                    : _max_being_validated(max_being_validated) {
+            }
+
+            /// How many transactions can be requested now
+            uint32_t transactions_to_fetch() const {
+                return _max_being_validated - std::min(_being_validated, _max_being_validated);
+            }
+
+            uint32_t being_validated() const {
+                return _being_validated;
+            }
+
+            void validation_started() {
+                ++_being_validated;
+            }
+
+            /// @return true if fetching was stopped by the limit and can go on now
+            bool validation_finished() {
+                return _being_validated-- == _max_being_validated;
+            }
+
+        private:
+            uint32_t _max_being_validated;
+            uint32_t _being_validated = 0;
+        };
+
+    }
+} // golos::network
@@ -0,0 +1,87 @@
+#include <golos/network/inventory_filter.hpp>
+
+#include <algorithm>
+
+namespace golos {
+    namespace network {
+
+        // 15 bits per item and 10 hash functions give about 0.1% of false positives
+        static const uint32_t filter_bits_per_item = 15;
+        static const uint32_t filter_hash_functions = 10;
+
+        inventory_filter::inventory_filter(uint32_t capacity)
+                : _capacity(std::max<uint32_t>(capacity, 1)) {
+        }
+
+        // item hashes are already uniformly distributed, so the hash functions are derived from them
+        // by double hashing, the item type is mixed in to keep blocks and transactions apart
+        static void item_hashes(const item_id &item, uint64_t &h1, uint64_t &h2) {
+            const auto &hash = item.item_hash._hash;
+            h1 = (uint64_t(hash[0]) << 32) | hash[1];
+            h2 = ((uint64_t(hash[2]) << 32) | hash[3]) ^ item.item_type;
+            h2 |= 1;
+        }
+
+        bool inventory_filter::generation::contains(uint64_t h1, uint64_t h2) const {
+            if (bits.empty()) {
+                return false;
+            }
+            const uint64_t size_in_bits = bits.size() * 64;
+            for (uint32_t i = 0; i < filter_hash_functions; ++i) {
+                auto bit = (h1 + i * h2) % size_in_bits;
+                if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void inventory_filter::generation::insert(uint64_t h1, uint64_t h2) {
+            const uint64_t size_in_bits = bits.size() * 64;
+            for (uint32_t i = 0; i < filter_hash_functions; ++i) {
+                auto bit = (h1 + i * h2) % size_in_bits;
+                bits[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+            ++size;
+        }
+
+        bool inventory_filter::insert(const item_id &item) {
+            uint64_t h1, h2;
+            item_hashes(item, h1, h2);
+            if (_current.contains(h1, h2)) {
+                return false;
+            }
+            // an item of the previous generation is moved to the current one, so it is remembered
+            // for capacity insertions from now on, even if it was only a false positive there
+            bool is_new = !_previous.contains(h1, h2);
+
+            if (_current.bits.empty()) {
+                // memory is allocated on the first use, most connections never get to advertising
+                _current.bits.resize((uint64_t(_capacity) * filter_bits_per_item + 63) / 64);
+            } else if (_current.size >= _capacity) {
+                rotate();
+            }
+            _current.insert(h1, h2);
+            return is_new;
+        }
+
+        bool inventory_filter::contains(const item_id &item) const {
+            uint64_t h1, h2;
+            item_hashes(item, h1, h2);
+            return _current.contains(h1, h2) || _previous.contains(h1, h2);
+        }
+
+        void inventory_filter::clear() {
+            _current = generation();
+            _previous = generation();
+        }
+
+        void inventory_filter::rotate() {
+            std::swap(_current, _previous);
+            _current.bits.resize(_previous.bits.size());
+            std::fill(_current.bits.begin(), _current.bits.end(), 0);
+            _current.size = 0;
+        }
+
+    }
+} // golos::network
@@ -27,6 +27,7 @@
 #include <fc/io/enum_type.hpp>
 
 #include <golos/network/message_oriented_connection.hpp>
+#include <golos/network/message_reader.hpp>
 #include <golos/network/stcp_socket.hpp>
 #include <golos/network/config.hpp>
 
@@ -100,6 +101,10 @@ namespace golos {
                 }
 
                 fc::sha512 get_shared_secret() const;
+
+                void set_plaintext_allowed(bool allowed);
+
+                bool is_plaintext() const;
             };
 
             message_oriented_connection_impl::message_oriented_connection_impl(message_oriented_connection *self,
@@ -147,39 +152,20 @@ namespace golos {
 
             void message_oriented_connection_impl::read_loop() {
                 VERIFY_CORRECT_THREAD();
-                const int BUFFER_SIZE = 16;
-                const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
-                static_assert(BUFFER_SIZE >=
-                              sizeof(message_header), "insufficient buffer");
-
                 _connected_time = fc::time_point::now();
 
                 fc::oexception exception_to_rethrow;
                 bool call_on_connection_closed = false;
 
                 try {
+                    message_reader reader([this](char *buffer, size_t length) {
+                        size_t bytes_read = _sock.readsome(buffer, length);
+                        _bytes_received += bytes_read;
+                        return bytes_read;
+                    });
                     message m;
                     while (true) {
-                        char buffer[BUFFER_SIZE];
-                        _sock.read(buffer, BUFFER_SIZE);
-                        _bytes_received += BUFFER_SIZE;
-                        memcpy((char *)&m, buffer, sizeof(message_header));
-
-                        FC_ASSERT(m.size <=
-                                  MAX_MESSAGE_SIZE, "", ("m.size", m.size)("MAX_MESSAGE_SIZE", MAX_MESSAGE_SIZE));
-
-                        size_t remaining_bytes_with_padding =
-                                16 * ((m.size - LEFTOVER + 15) / 16);
-                        m.data.resize(LEFTOVER +
-                                      remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-                        std::copy(
-                                buffer + sizeof(message_header),
-                                buffer + sizeof(buffer), m.data.begin());
-                        if (remaining_bytes_with_padding) {
-                            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
-                            _bytes_received += remaining_bytes_with_padding;
-                        }
-                        m.data.resize(m.size); // truncate off the padding bytes
+                        reader.read_message(m);
 
                         _last_message_received_time = fc::time_point::now();
 
@@ -337,6 +323,16 @@ namespace golos {
                 return _sock.get_shared_secret();
             }
 
+            void message_oriented_connection_impl::set_plaintext_allowed(bool allowed) {
+                VERIFY_CORRECT_THREAD();
+                _sock.set_plaintext_allowed(allowed);
+            }
+
+            bool message_oriented_connection_impl::is_plaintext() const {
+                VERIFY_CORRECT_THREAD();
+                return _sock.is_plaintext();
+            }
+
         } // end namespace golos::network::detail
 
 
@@ -400,5 +396,13 @@ namespace golos {
             return my->get_shared_secret();
         }
 
+        void message_oriented_connection::set_plaintext_allowed(bool allowed) {
+            my->set_plaintext_allowed(allowed);
+        }
+
+        bool message_oriented_connection::is_plaintext() const {
+            return my->is_plaintext();
+        }
+
     }
 } // end namespace golos::network
@@ -0,0 +1,65 @@
+#include <golos/network/message_reader.hpp>
+#include <golos/network/config.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace golos {
+    namespace network {
+
+        static_assert(message_reader::block_size >= sizeof(message_header), "insufficient buffer");
+        static_assert(GRAPHENE_NET_READ_BUFFER_SIZE % message_reader::block_size == 0, "partial encrypted blocks in buffer");
+
+        const size_t message_reader::block_size;
+
+        message_reader::message_reader(read_function read)
+                : _read(std::move(read)),
+                  _buffer(GRAPHENE_NET_READ_BUFFER_SIZE) {
+        }
+
+        void message_reader::read_message(message &m) {
+            while (true) {
+                size_t message_size_with_padding = block_size;
+                if (_end - _begin >= sizeof(message_header)) {
+                    memcpy((char *)&m, &_buffer[_begin], sizeof(message_header));
+
+                    FC_ASSERT(m.size <= MAX_MESSAGE_SIZE, "", ("m.size", m.size)("MAX_MESSAGE_SIZE", MAX_MESSAGE_SIZE));
+
+                    message_size_with_padding =
+                            block_size * ((sizeof(message_header) + m.size + block_size - 1) / block_size);
+                }
+
+                if (_end - _begin >= message_size_with_padding) {
+                    m.data.assign(_buffer.begin() + _begin + sizeof(message_header),
+                            _buffer.begin() + _begin + sizeof(message_header) + m.size);
+                    _begin += message_size_with_padding;
+                    return;
+                }
+
+                // not the whole message yet, make room for the rest of it and read more
+                if (_begin == _end) {
+                    _begin = _end = 0;
+                    if (_buffer.size() > GRAPHENE_NET_READ_BUFFER_SIZE) {
+                        // don't keep the memory of a big message
+                        _buffer.resize(GRAPHENE_NET_READ_BUFFER_SIZE);
+                        _buffer.shrink_to_fit();
+                    }
+                } else if (_buffer.size() - _begin < message_size_with_padding ||
+                           _buffer.size() - _end < block_size) {
+                    std::copy(_buffer.begin() + _begin, _buffer.begin() + _end, _buffer.begin());
+                    _end -= _begin;
+                    _begin = 0;
+                }
+
+                // a read can end in the middle of a block, so the free space isn't always whole blocks,
+                // at least one block is left free to not request a read of nothing
+                _buffer.resize(std::max({_buffer.size(), _begin + message_size_with_padding, _end + block_size}));
+
+                _end += _read(&_buffer[_end], (_buffer.size() - _end) / block_size * block_size);
+            }
+        }
+
+    }
+} // golos::network
@@ -27,6 +27,7 @@
 #include <unordered_set>
 #include <list>
 #include <forward_list>
+#include <algorithm>
 #include <iostream>
 #include <boost/tuple/tuple.hpp>
 #include <boost/circular_buffer.hpp>
@@ -64,6 +65,7 @@
 #include <golos/network/node.hpp>
 #include <golos/network/peer_connection.hpp>
 #include <golos/network/exceptions.hpp>
+#include <golos/network/transaction_fetch_throttle.hpp>
 
 #include <fc/git_revision.hpp>
 
@@ -109,6 +111,14 @@ namespace golos {
         namespace detail {
             namespace bmi = boost::multi_index;
 
+            /**
+             * Messages we have received, kept to serve them to peers for the last few blocks.
+             *
+             * Lookups by message hash, contents hash and transaction short id are done on every item
+             * requested by peers and every compact block, so all indices are hashed. Messages are
+             * cached in the order of the block clock, so they are expired from the front of the
+             * sequenced index.
+             */
             class blockchain_tied_message_cache {
             private:
                 static const uint32_t cache_duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
@@ -117,6 +127,8 @@ namespace golos {
                 };
                 struct message_contents_hash_index {
                 };
+                struct short_id_index {
+                };
                 struct block_clock_index {
                 };
 
@@ -128,28 +140,33 @@ namespace golos {
                     // for network performance stats
                     message_propagation_data propagation_data;
                     fc::uint160_t message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+                    uint64_t short_id; // transaction_short_id() of the contents hash, used to find transactions of compact blocks
 
                     message_info(const message_hash_type &message_hash,
-                            const message &message_body,
+                            message message_body,
                             uint32_t block_clock_when_received,
                             const message_propagation_data &propagation_data,
                             fc::uint160_t message_contents_hash) :
                             message_hash(message_hash),
-                            message_body(message_body),
+                            message_body(std::move(message_body)),
                             block_clock_when_received(block_clock_when_received),
                             propagation_data(propagation_data),
-                            message_contents_hash(message_contents_hash) {
+                            message_contents_hash(message_contents_hash),
+                            short_id(transaction_short_id(message_contents_hash)) {
                     }
                 };
 
                 typedef boost::multi_index_container
                         <message_info,
-                                bmi::indexed_by<bmi::ordered_unique<bmi::tag<message_hash_index>,
-                                        bmi::member<message_info, message_hash_type, &message_info::message_hash>>,
-                                        bmi::ordered_non_unique<bmi::tag<message_contents_hash_index>,
-                                                bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash>>,
-                                        bmi::ordered_non_unique<bmi::tag<block_clock_index>,
-                                                bmi::member<message_info, uint32_t, &message_info::block_clock_when_received>>>
+                                bmi::indexed_by<bmi::hashed_unique<bmi::tag<message_hash_index>,
+                                        bmi::member<message_info, message_hash_type, &message_info::message_hash>,
+                                        std::hash<message_hash_type>>,
+                                        bmi::hashed_non_unique<bmi::tag<message_contents_hash_index>,
+                                                bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash>,
+                                                std::hash<fc::uint160_t>>,
+                                        bmi::hashed_non_unique<bmi::tag<short_id_index>,
+                                                bmi::member<message_info, uint64_t, &message_info::short_id>>,
+                                        bmi::sequenced<bmi::tag<block_clock_index>>>
                         > message_cache_container;
 
                 message_cache_container _message_cache;
@@ -166,10 +183,14 @@ namespace golos {
                 void cache_message(const message &message_to_cache, const message_hash_type &hash_of_message_to_cache,
                         const message_propagation_data &propagation_data, const fc::uint160_t &message_content_hash);
 
-                message get_message(const message_hash_type &hash_of_message_to_lookup);
+                /// The reference is valid until the cache is changed
+                const message &get_message(const message_hash_type &hash_of_message_to_lookup) const;
 
                 message_propagation_data get_message_propagation_data(const fc::uint160_t &hash_of_message_contents_to_lookup) const;
 
+                /// A cached transaction with the short id, see transaction_short_id()
+                fc::optional<signed_transaction> find_transaction(uint64_t short_id) const;
+
                 size_t size() const {
                     return _message_cache.size();
                 }
@@ -178,9 +199,10 @@ namespace golos {
             void blockchain_tied_message_cache::block_accepted() {
                 ++block_clock;
                 if (block_clock > cache_duration_in_blocks) {
-                    _message_cache.get<block_clock_index>().erase(_message_cache.get<block_clock_index>().begin(),
-                            _message_cache.get<block_clock_index>().lower_bound(
-                                    block_clock - cache_duration_in_blocks));
+                    auto &idx = _message_cache.get<block_clock_index>();
+                    while (!idx.empty() && idx.front().block_clock_when_received < block_clock - cache_duration_in_blocks) {
+                        idx.pop_front();
+                    }
                 }
             }
 
@@ -195,9 +217,8 @@ namespace golos {
                         message_content_hash));
             }
 
-            message blockchain_tied_message_cache::get_message(const message_hash_type &hash_of_message_to_lookup) {
-                message_cache_container::index<message_hash_index>::type::const_iterator iter =
-                        _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup);
+            const message &blockchain_tied_message_cache::get_message(const message_hash_type &hash_of_message_to_lookup) const {
+                auto iter = _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup);
                 if (iter != _message_cache.get<message_hash_index>().end()) {
                     return iter->message_body;
                 }
@@ -206,8 +227,7 @@ namespace golos {
 
             message_propagation_data blockchain_tied_message_cache::get_message_propagation_data(const fc::uint160_t &hash_of_message_contents_to_lookup) const {
                 if (hash_of_message_contents_to_lookup != fc::uint160_t()) {
-                    message_cache_container::index<message_contents_hash_index>::type::const_iterator iter =
-                            _message_cache.get<message_contents_hash_index>().find(hash_of_message_contents_to_lookup);
+                    auto iter = _message_cache.get<message_contents_hash_index>().find(hash_of_message_contents_to_lookup);
                     if (iter !=
                         _message_cache.get<message_contents_hash_index>().end()) {
                             return iter->propagation_data;
@@ -216,6 +236,16 @@ namespace golos {
                 FC_THROW_EXCEPTION(fc::key_not_found_exception, "Requested message not in cache");
             }
 
+            fc::optional<signed_transaction> blockchain_tied_message_cache::find_transaction(uint64_t short_id) const {
+                auto range = _message_cache.get<short_id_index>().equal_range(short_id);
+                for (auto iter = range.first; iter != range.second; ++iter) {
+                    if (iter->message_body.msg_type == trx_message_type) {
+                        return iter->message_body.as<trx_message>().trx;
+                    }
+                }
+                return fc::optional<signed_transaction>();
+            }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
             // This specifies configuration info for the local node.  It's stored as JSON
@@ -463,8 +493,7 @@ namespace golos {
                 typedef std::unordered_map<golos::network::block_id_type, fc::time_point> active_sync_requests_map;
 
                 active_sync_requests_map _active_sync_requests; /// list of sync blocks we've asked for from peers but have not yet received
-                std::list<golos::network::block_message> _new_received_sync_items; /// list of sync blocks we've just received but haven't yet tried to process
-                std::list<golos::network::block_message> _received_sync_items; /// list of sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
+                std::map<item_hash_t, golos::network::block_message> _received_sync_items; /// sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain, by block id
                 // @}
 
                 fc::future<void> _process_backlog_of_sync_blocks_done;
@@ -474,6 +503,7 @@ namespace golos {
                 // @{
                 fc::promise<void>::ptr _retrigger_fetch_item_loop_promise;
                 bool _items_to_fetch_updated;
+                transaction_fetch_throttle _transaction_fetch_throttle; /// by transactions passed to the delegate which it hasn't finished validating
                 fc::future<void> _fetch_item_loop_done;
 
                 struct item_id_index {
@@ -494,6 +524,8 @@ namespace golos {
                 fc::promise<void>::ptr _retrigger_advertise_inventory_loop_promise;
                 fc::future<void> _advertise_inventory_loop_done;
                 std::unordered_set<item_id> _new_inventory; /// list of items we have received but not yet advertised to our peers
+                bool _new_inventory_has_blocks = false; /// blocks in _new_inventory are advertised without waiting for more items
+                peer_connection::timestamped_items_set_type _advertised_inventory; /// items we have advertised to our peers recently, so we have them
                 // @}
 
                 fc::future<void> _terminate_inactive_connections_loop_done;
@@ -547,6 +579,8 @@ namespace golos {
 
                 fc::rate_limiting_group _rate_limiter;
 
+                std::vector<fc::ip::address> _plaintext_peers; /// peers on trusted links, connections with them aren't encrypted if they allow it too
+
                 uint32_t _last_reported_number_of_connections; // number of connections last reported to the client (to avoid sending duplicate messages)
 
                 bool _peer_advertising_disabled;
@@ -607,6 +641,8 @@ namespace golos {
 
                 bool have_already_received_sync_item(const item_hash_t &item_hash);
 
+                uint32_t get_sync_request_window(const peer_connection_ptr &peer) const;
+
                 void request_sync_item_from_peer(const peer_connection_ptr &peer, const item_hash_t &item_to_request);
 
                 void request_sync_items_from_peer(const peer_connection_ptr &peer, const std::vector<item_hash_t> &items_to_request);
@@ -625,6 +661,10 @@ namespace golos {
 
                 void trigger_advertise_inventory_loop();
 
+                void wait_for_new_inventory(const fc::time_point &until);
+
+                bool mark_item_known_to_peer(peer_connection &peer, const item_id &item, const fc::time_point &now);
+
                 void terminate_inactive_connections_loop();
 
                 void fetch_updated_peer_lists_loop();
@@ -715,6 +755,22 @@ namespace golos {
                 void on_get_current_connections_reply_message(peer_connection *originating_peer,
                         const get_current_connections_reply_message &get_current_connections_reply_message_received);
 
+                fc::optional<golos::network::block_message> find_block_message(const item_hash_t &block_message_hash);
+
+                void send_compact_blocks(peer_connection *originating_peer, const std::vector<item_hash_t> &block_message_hashes);
+
+                void on_compact_block_message(peer_connection *originating_peer,
+                        const compact_block_message &compact_block_message_received);
+
+                void on_fetch_block_transactions_message(peer_connection *originating_peer,
+                        const fetch_block_transactions_message &fetch_block_transactions_message_received);
+
+                void on_block_transactions_message(peer_connection *originating_peer,
+                        const block_transactions_message &block_transactions_message_received);
+
+                void process_compact_block(peer_connection *originating_peer,
+                        compact_block_reconstruction &reconstruction);
+
                 void on_connection_closed(peer_connection *originating_peer) override;
 
                 void send_sync_block_to_node_delegate(const golos::network::block_message &block_message_to_send);
@@ -821,6 +877,10 @@ namespace golos {
 
                 void set_total_bandwidth_limit(uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second);
 
+                void set_plaintext_peers(const std::vector<fc::ip::address> &addresses);
+
+                bool is_plaintext_peer(const fc::ip::address &address) const;
+
                 void disable_peer_advertising();
 
                 fc::variant_object get_call_statistics() const;
@@ -876,6 +936,7 @@ namespace golos {
                     _sync_items_to_fetch_updated(false),
                     _suspend_fetching_sync_blocks(false),
                     _items_to_fetch_updated(false),
+                    _transaction_fetch_throttle(GRAPHENE_NET_MAX_TRANSACTIONS_BEING_VALIDATED),
                     _items_to_fetch_sequence_counter(0),
                     _recent_block_interval_in_seconds(STEEMIT_BLOCK_INTERVAL),
                     _user_agent_string(user_agent),
@@ -1056,22 +1117,29 @@ namespace golos {
 
             bool node_impl::have_already_received_sync_item(const item_hash_t &item_hash) {
                 VERIFY_CORRECT_THREAD();
-                return std::find_if(_received_sync_items.begin(), _received_sync_items.end(),
-                        [&item_hash](const golos::network::block_message &message) {
-                            return message.block_id == item_hash;
-                        }) != _received_sync_items.end() ||
-                       std::find_if(_new_received_sync_items.begin(), _new_received_sync_items.end(),
-                               [&item_hash](const golos::network::block_message &message) {
-                                   return message.block_id == item_hash;
-                               }) != _new_received_sync_items.end();;
+                return _received_sync_items.find(item_hash) != _received_sync_items.end();
+            }
+
+            uint32_t node_impl::get_sync_request_window(const peer_connection_ptr &peer) const {
+                // enough requests to keep the peer busy for a while at the rate it has been delivering blocks
+                uint32_t window = GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING;
+                if (peer->sync_item_interval.count() > 0) {
+                    window = static_cast<uint32_t>(
+                            fc::seconds(GRAPHENE_NET_SYNC_REQUEST_WINDOW_SECONDS).count() / peer->sync_item_interval.count());
+                }
+                return std::min<uint32_t>(
+                        std::max<uint32_t>(window, GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING),
+                        std::max<uint32_t>(_maximum_blocks_per_peer_during_syncing, 1));
             }
 
             void node_impl::request_sync_item_from_peer(const peer_connection_ptr &peer, const item_hash_t &item_to_request) {
                 VERIFY_CORRECT_THREAD();
                 dlog("requesting item ${item_hash} from peer ${endpoint}", ("item_hash", item_to_request)("endpoint", peer->get_remote_endpoint()));
                 item_id item_id_to_request(golos::network::block_message_type, item_to_request);
-                _active_sync_requests.insert(active_sync_requests_map::value_type(item_to_request, fc::time_point::now()));
-                peer->last_sync_item_received_time = fc::time_point::now();
+                _active_sync_requests[item_to_request] = fc::time_point::now();
+                if (peer->sync_items_requested_from_peer.empty()) {
+                    peer->last_sync_item_received_time = fc::time_point::now();
+                }
                 peer->sync_items_requested_from_peer.insert(item_to_request);
                 peer->send_message(fetch_items_message(item_id_to_request.item_type, std::vector<item_hash_t>{
                         item_id_to_request.item_hash
@@ -1082,9 +1150,12 @@ namespace golos {
                 VERIFY_CORRECT_THREAD();
                 dlog("requesting ${item_count} item(s) ${items_to_request} from peer ${endpoint}",
                         ("item_count", items_to_request.size())("items_to_request", items_to_request)("endpoint", peer->get_remote_endpoint()));
-                for (const item_hash_t &item_to_request : items_to_request) {
-                    _active_sync_requests.insert(active_sync_requests_map::value_type(item_to_request, fc::time_point::now()));
+                // requests are pipelined, the peer has been making progress on earlier ones if it has any
+                if (peer->sync_items_requested_from_peer.empty()) {
                     peer->last_sync_item_received_time = fc::time_point::now();
+                }
+                for (const item_hash_t &item_to_request : items_to_request) {
+                    _active_sync_requests[item_to_request] = fc::time_point::now();
                     peer->sync_items_requested_from_peer.insert(item_to_request);
                 }
                 peer->send_message(fetch_items_message(golos::network::block_message_type, items_to_request));
@@ -1102,37 +1173,65 @@ namespace golos {
                         {
                             ASSERT_TASK_NOT_PREEMPTED();
                             std::set<item_hash_t> sync_items_to_request;
+                            fc::time_point reassign_threshold = fc::time_point::now() -
+                                    fc::seconds(GRAPHENE_NET_SYNC_ITEM_REASSIGN_TIMEOUT_SECONDS);
 
-                            // for each idle peer that we're syncing with
+                            // blocks are requested from all the peers we're syncing with at once, requests are
+                            // pipelined so a peer gets more before it delivers all it has been asked for
+                            std::vector<peer_connection_ptr> sync_peers;
                             for (const peer_connection_ptr &peer : _active_connections) {
                                 if (peer->we_need_sync_items_from_peer &&
-                                    sync_item_requests_to_send.find(peer) ==
-                                    sync_item_requests_to_send.end() &&
-                                    // if we've already scheduled a request for this peer, don't consider scheduling another
-                                    peer->idle()) {
-                                    if (!peer->inhibit_fetching_sync_blocks) {
-                                        // loop through the items it has that we don't yet have on our blockchain
-                                        for (unsigned i = 0; i <
-                                                             peer->ids_of_items_to_get.size(); ++i) {
-                                            item_hash_t item_to_potentially_request = peer->ids_of_items_to_get[i];
-                                            // if we don't already have this item in our temporary storage and we haven't requested from another syncing peer
-                                            if (!have_already_received_sync_item(item_to_potentially_request) &&
-                                                // already got it, but for some reson it's still in our list of items to fetch
-                                                sync_items_to_request.find(item_to_potentially_request) ==
-                                                sync_items_to_request.end() &&
-                                                // we have already decided to request it from another peer during this iteration
-                                                _active_sync_requests.find(item_to_potentially_request) ==
-                                                _active_sync_requests.end()) // we've requested it in a previous iteration and we're still waiting for it to arrive
-                                            {
-                                                // then schedule a request from this peer
-                                                sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
-                                                sync_items_to_request.insert(item_to_potentially_request);
-                                                if (sync_item_requests_to_send[peer].size() >=
-                                                    _maximum_blocks_per_peer_during_syncing) {
-                                                        break;
-                                                }
-                                            }
+                                    !peer->inhibit_fetching_sync_blocks &&
+                                    peer->items_requested_from_peer.empty() &&
+                                    peer->sync_items_requested_from_peer.size() <=
+                                    get_sync_request_window(peer) / 2) {
+                                    sync_peers.push_back(peer);
+                                }
+                            }
+                            // the fastest peers are considered first, so they get the blocks we need soonest
+                            std::stable_sort(sync_peers.begin(), sync_peers.end(),
+                                    [](const peer_connection_ptr &a, const peer_connection_ptr &b) {
+                                        if (a->sync_item_interval.count() == 0 || b->sync_item_interval.count() == 0) {
+                                            return b->sync_item_interval.count() == 0 && a->sync_item_interval.count() != 0;
+                                        }
+                                        return a->sync_item_interval < b->sync_item_interval;
+                                    });
+
+                            for (const peer_connection_ptr &peer : sync_peers) {
+                                uint32_t requests_to_send = get_sync_request_window(peer) -
+                                        peer->sync_items_requested_from_peer.size();
+                                // loop through the items it has that we don't yet have on our blockchain
+                                for (unsigned i = 0; i < peer->ids_of_items_to_get.size(); ++i) {
+                                    item_hash_t item_to_potentially_request = peer->ids_of_items_to_get[i];
+                                    // if we don't already have this item in our temporary storage
+                                    if (have_already_received_sync_item(item_to_potentially_request) ||
+                                        // we have already decided to request it from another peer during this iteration
+                                        sync_items_to_request.find(item_to_potentially_request) !=
+                                        sync_items_to_request.end()) {
+                                        continue;
+                                    }
+
+                                    auto active_request_iter = _active_sync_requests.find(item_to_potentially_request);
+                                    if (active_request_iter != _active_sync_requests.end()) {
+                                        // we've requested it in a previous iteration and we're still waiting for it to arrive.
+                                        // if it's one of the first blocks we need and it's late, ask this peer as well,
+                                        // later blocks are waiting for it
+                                        if (i >= GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING ||
+                                            _received_sync_items.empty() ||
+                                            active_request_iter->second >= reassign_threshold ||
+                                            peer->sync_items_requested_from_peer.find(item_to_potentially_request) !=
+                                            peer->sync_items_requested_from_peer.end()) {
+                                            continue;
                                         }
+                                        dlog("sync item ${item} is late, requesting it from ${peer} as well",
+                                                ("item", item_to_potentially_request)("peer", peer->get_remote_endpoint()));
+                                    }
+
+                                    // then schedule a request from this peer
+                                    sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
+                                    sync_items_to_request.insert(item_to_potentially_request);
+                                    if (sync_item_requests_to_send[peer].size() >= requests_to_send) {
+                                        break;
                                     }
                                 }
                             }
@@ -1221,6 +1320,9 @@ namespace golos {
                         }
                     }
 
+                    // don't fetch more transactions than the client can take, it will retrigger us when it's done with some
+                    uint32_t transactions_to_fetch = _transaction_fetch_throttle.transactions_to_fetch();
+
                     // now loop over all items we want to fetch
                     for (auto item_iter = _items_to_fetch.begin();
                          item_iter != _items_to_fetch.end();) {
@@ -1246,7 +1348,14 @@ namespace golos {
                                         golos::network::trx_message_type &&
                                         peer->is_transaction_fetching_inhibited()) {
                                             next_peer_unblocked_time = std::min(peer->transaction_fetching_inhibited_until, next_peer_unblocked_time);
+                                    } else if (item_iter->item.item_type ==
+                                               golos::network::trx_message_type &&
+                                               transactions_to_fetch == 0) {
+                                        break;
                                     } else {
+                                        if (item_iter->item.item_type == golos::network::trx_message_type) {
+                                            --transactions_to_fetch;
+                                        }
                                         //dlog("requesting item ${hash} from peer ${endpoint}",
                                         //     ("hash", iter->item.item_hash)("endpoint", peer->get_remote_endpoint()));
                                         item_id item_id_to_fetch = item_iter->item;
@@ -1288,7 +1397,13 @@ namespace golos {
                                     }
                             }
 
-                            peer_and_items.peer->send_message(fetch_items_message(items_by_type.first,
+                            uint32_t item_type_to_request = items_by_type.first;
+                            if (item_type_to_request == core_message_type_enum::block_message_type &&
+                                peer_and_items.peer->supports_compact_blocks) {
+                                    // the peer replies with compact blocks, which are still tracked as block items
+                                    item_type_to_request = core_message_type_enum::compact_block_message_type;
+                            }
+                            peer_and_items.peer->send_message(fetch_items_message(item_type_to_request,
                                     items_by_type.second));
                         }
                     }
@@ -1326,70 +1441,98 @@ namespace golos {
             void node_impl::advertise_inventory_loop() {
                 VERIFY_CORRECT_THREAD();
                 while (!_advertise_inventory_loop_done.canceled()) {
+                    if (_new_inventory.empty()) {
+                        wait_for_new_inventory(fc::time_point::maximum());
+                        continue;
+                    }
+
+                    // transactions are collected for a while to advertise them to each peer in one message,
+                    // a block is advertised at once
+                    fc::time_point flush_time = fc::time_point::now() + fc::milliseconds(GRAPHENE_NET_INVENTORY_FLUSH_INTERVAL_MS);
+                    while (!_new_inventory_has_blocks && fc::time_point::now() < flush_time &&
+                           !_advertise_inventory_loop_done.canceled()) {
+                        wait_for_new_inventory(flush_time);
+                    }
+
                     dlog("beginning an iteration of advertise inventory");
                     // swap inventory into local variable, clearing the node's copy
                     std::unordered_set<item_id> inventory_to_advertise;
                     inventory_to_advertise.swap(_new_inventory);
+                    _new_inventory_has_blocks = false;
+
+                    fc::time_point now = fc::time_point::now();
+                    fc::time_point_sec oldest_inventory_to_keep(now - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
+                    _advertised_inventory.get<peer_connection::timestamp_index>().erase(
+                            _advertised_inventory.get<peer_connection::timestamp_index>().begin(),
+                            _advertised_inventory.get<peer_connection::timestamp_index>().lower_bound(oldest_inventory_to_keep));
+                    for (const item_id &item_to_advertise : inventory_to_advertise) {
+                        _advertised_inventory.insert(peer_connection::timestamped_item_id(item_to_advertise, now));
+                    }
 
                     // process all inventory to advertise and construct the inventory messages we'll send
                     // first, then send them all in a batch (to avoid any fiber interruption points while
                     // we're computing the messages)
-                    std::list<std::pair<peer_connection_ptr, item_ids_inventory_message>> inventory_messages_to_send;
+                    std::vector<std::pair<peer_connection_ptr, item_ids_inventory_message>> inventory_messages_to_send;
 
                     for (const peer_connection_ptr &peer : _active_connections) {
                         // only advertise to peers who are in sync with us
-                        //wdump((peer->peer_needs_sync_items_from_us));
                         if (!peer->peer_needs_sync_items_from_us) {
-                            std::map<uint32_t, std::vector<item_hash_t>> items_to_advertise_by_type;
                             // don't send the peer anything we've already advertised to it
                             // or anything it has advertised to us
                             // group the items we need to send by type, because we'll need to send one inventory message per type
-                            unsigned total_items_to_send_to_this_peer = 0;
-                            //wdump((inventory_to_advertise));
+                            auto first_message_to_peer = inventory_messages_to_send.size();
                             for (const item_id &item_to_advertise : inventory_to_advertise) {
-                                //if (peer->inventory_advertised_to_peer.find(item_to_advertise) != peer->inventory_advertised_to_peer.end() )
-                                //   wdump((*peer->inventory_advertised_to_peer.find(item_to_advertise)));
-                                //if (peer->inventory_peer_advertised_to_us.find(item_to_advertise) != peer->inventory_peer_advertised_to_us.end() )
-                                //   wdump((*peer->inventory_peer_advertised_to_us.find(item_to_advertise)));
-
-                                if (peer->inventory_advertised_to_peer.find(item_to_advertise) ==
-                                    peer->inventory_advertised_to_peer.end() &&
-                                    peer->inventory_peer_advertised_to_us.find(item_to_advertise) ==
-                                    peer->inventory_peer_advertised_to_us.end()) {
-                                    items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
-                                    peer->inventory_advertised_to_peer.insert(peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
-                                    ++total_items_to_send_to_this_peer;
-                                    if (item_to_advertise.item_type ==
-                                        trx_message_type)
-                                        testnetlog("advertising transaction ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
-                                    dlog("advertising item ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
+                                if (!mark_item_known_to_peer(*peer, item_to_advertise, now)) {
+                                    continue;
+                                }
+                                auto message_iter = std::find_if(
+                                        inventory_messages_to_send.begin() + first_message_to_peer, inventory_messages_to_send.end(),
+                                        [&](const std::pair<peer_connection_ptr, item_ids_inventory_message> &message) {
+                                            return message.second.item_type == item_to_advertise.item_type;
+                                        });
+                                if (message_iter == inventory_messages_to_send.end()) {
+                                    inventory_messages_to_send.emplace_back(peer, item_ids_inventory_message(item_to_advertise.item_type, {}));
+                                    message_iter = inventory_messages_to_send.end() - 1;
+                                }
+                                message_iter->second.item_hashes_available.push_back(item_to_advertise.item_hash);
+                                if (item_to_advertise.item_type == trx_message_type) {
+                                    testnetlog("advertising transaction ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
                                 }
                             }
-                            dlog("advertising ${count} new item(s) of ${types} type(s) to peer ${endpoint}",
-                                    ("count", total_items_to_send_to_this_peer)
-                                            ("types", items_to_advertise_by_type.size())
+                            dlog("advertising new items in ${count} message(s) to peer ${endpoint}",
+                                    ("count", inventory_messages_to_send.size() - first_message_to_peer)
                                             ("endpoint", peer->get_remote_endpoint()));
-                            for (auto items_group : items_to_advertise_by_type) {
-                                inventory_messages_to_send.push_back(std::make_pair(peer, item_ids_inventory_message(items_group.first, items_group.second)));
-                            }
                         }
                         peer->clear_old_inventory();
                     }
 
-                    for (auto iter = inventory_messages_to_send.begin();
-                         iter != inventory_messages_to_send.end(); ++iter) {
-                             iter->first->send_message(iter->second);
-                    }
-                    inventory_messages_to_send.clear();
-
-                    if (_new_inventory.empty()) {
-                        _retrigger_advertise_inventory_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("golos::network::retrigger_advertise_inventory_loop"));
-                        _retrigger_advertise_inventory_loop_promise->wait();
-                        _retrigger_advertise_inventory_loop_promise.reset();
+                    for (auto &message_to_send : inventory_messages_to_send) {
+                        message_to_send.first->send_message(message_to_send.second);
                     }
                 } // while(!canceled)
             }
 
+            /// @return false if the peer already knew the item, for a transaction maybe wrongly
+            bool node_impl::mark_item_known_to_peer(peer_connection &peer, const item_id &item, const fc::time_point &now) {
+                VERIFY_CORRECT_THREAD();
+                // a peer never misses a block because of a false positive of the filter
+                if (item.item_type == golos::network::block_message_type) {
+                    return peer.blocks_known_to_peer.insert(peer_connection::timestamped_item_id(item, now)).second;
+                }
+                return peer.transactions_known_to_peer.insert(item);
+            }
+
+            void node_impl::wait_for_new_inventory(const fc::time_point &until) {
+                VERIFY_CORRECT_THREAD();
+                _retrigger_advertise_inventory_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("golos::network::retrigger_advertise_inventory_loop"));
+                try {
+                    _retrigger_advertise_inventory_loop_promise->wait_until(until);
+                }
+                catch (const fc::timeout_exception &) {
+                }
+                _retrigger_advertise_inventory_loop_promise.reset();
+            }
+
             void node_impl::trigger_advertise_inventory_loop() {
                 VERIFY_CORRECT_THREAD();
                 if (_retrigger_advertise_inventory_loop_promise) {
@@ -1943,6 +2086,15 @@ namespace golos {
                     case core_message_type_enum::get_current_connections_reply_message_type:
                         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
                         break;
+                    case core_message_type_enum::compact_block_message_type:
+                        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+                        break;
+                    case core_message_type_enum::fetch_block_transactions_message_type:
+                        on_fetch_block_transactions_message(originating_peer, received_message.as<fetch_block_transactions_message>());
+                        break;
+                    case core_message_type_enum::block_transactions_message_type:
+                        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+                        break;
 
                     default:
                         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1990,6 +2142,7 @@ namespace golos {
                 }
 
                 user_data["chain_id"] = STEEMIT_CHAIN_ID;
+                user_data["compact_blocks"] = true;
 
                 return user_data;
             }
@@ -2021,6 +2174,9 @@ namespace golos {
                 if (user_data.contains("last_known_fork_block_number")) {
                     originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
                 }
+                if (user_data.contains("compact_blocks")) {
+                    originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
+                }
                 if (user_data.contains("chain_id")) {
                     originating_peer->chain_id = user_data["chain_id"].as<golos::protocol::chain_id_type>();
                 }
@@ -2834,12 +2990,17 @@ namespace golos {
                                 ("type", fetch_items_message_received.item_type)
                                 ("endpoint", originating_peer->get_remote_endpoint()));
 
+                if (fetch_items_message_received.item_type == compact_block_message_type) {
+                    send_compact_blocks(originating_peer, fetch_items_message_received.items_to_fetch);
+                    return;
+                }
+
                 fc::optional<message> last_block_message_sent;
 
                 std::list<message> reply_messages;
                 for (const item_hash_t &item_hash : fetch_items_message_received.items_to_fetch) {
                     try {
-                        message requested_message = _message_cache.get_message(item_hash);
+                        const message &requested_message = _message_cache.get_message(item_hash);
                         dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                                 ("endpoint", originating_peer->get_remote_endpoint())
                                         ("id", requested_message.id()));
@@ -2894,6 +3055,8 @@ namespace golos {
             void node_impl::on_item_not_available_message(peer_connection *originating_peer, const item_not_available_message &item_not_available_message_received) {
                 VERIFY_CORRECT_THREAD();
                 const item_id &requested_item = item_not_available_message_received.requested_item;
+                originating_peer->compact_blocks_being_reconstructed.erase(requested_item.item_hash);
+                originating_peer->sync_items_received_from_other_peers.erase(requested_item.item_hash);
                 auto regular_item_iter = originating_peer->items_requested_from_peer.find(requested_item);
                 if (regular_item_iter !=
                     originating_peer->items_requested_from_peer.end()) {
@@ -2927,6 +3090,128 @@ namespace golos {
                 dlog("Peer doesn't have an item we're looking for, which is fine because we weren't looking for it");
             }
 
+            fc::optional<golos::network::block_message> node_impl::find_block_message(const item_hash_t &block_message_hash) {
+                // as with full blocks, the ones not in the cache are asked from the delegate
+                message block = get_message_for_item(item_id(block_message_type, block_message_hash));
+                if (block.msg_type == block_message_type) {
+                    return block.as<golos::network::block_message>();
+                }
+                return fc::optional<golos::network::block_message>();
+            }
+
+            void node_impl::send_compact_blocks(peer_connection *originating_peer, const std::vector<item_hash_t> &block_message_hashes) {
+                VERIFY_CORRECT_THREAD();
+                for (const item_hash_t &block_message_hash : block_message_hashes) {
+                    auto block = find_block_message(block_message_hash);
+                    if (!block) {
+                        dlog("received compact block request from peer ${endpoint} but we don't have it",
+                                ("endpoint", originating_peer->get_remote_endpoint()));
+                        originating_peer->send_message(item_not_available_message(item_id(block_message_type, block_message_hash)));
+                        continue;
+                    }
+                    originating_peer->last_block_delegate_has_seen = block->block_id;
+                    originating_peer->last_block_time_delegate_has_seen = block->block.timestamp;
+                    originating_peer->send_message(compact_block_message(block_message_hash, *block));
+                }
+            }
+
+            void node_impl::on_compact_block_message(peer_connection *originating_peer,
+                    const compact_block_message &compact_block_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const item_hash_t &block_message_hash = compact_block_message_received.block_message_hash;
+                if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, block_message_hash)) ==
+                    originating_peer->items_requested_from_peer.end()) {
+                    wlog("received a compact block ${id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+                            ("id", compact_block_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+                    fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a compact block that I didn't ask for, message_hash: ${message_hash}",
+                            ("message_hash", block_message_hash)));
+                    disconnect_from_peer(originating_peer, "You sent me a compact block that I didn't ask for", true, detailed_error);
+                    return;
+                }
+
+                compact_block_reconstruction reconstruction(compact_block_message_received, [this](uint64_t short_id) {
+                    return _message_cache.find_transaction(short_id);
+                });
+                std::vector<uint32_t> missing_transactions = reconstruction.missing_transactions();
+
+                dlog("received compact block ${id} from peer ${endpoint}, ${missing} of ${count} transactions are missing",
+                        ("id", compact_block_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint())
+                                ("missing", missing_transactions.size())("count", reconstruction.transactions.size()));
+
+                if (missing_transactions.empty()) {
+                    process_compact_block(originating_peer, reconstruction);
+                    return;
+                }
+
+                originating_peer->compact_blocks_being_reconstructed[block_message_hash] = std::move(reconstruction);
+                originating_peer->send_message(fetch_block_transactions_message(block_message_hash, missing_transactions));
+            }
+
+            void node_impl::on_fetch_block_transactions_message(peer_connection *originating_peer,
+                    const fetch_block_transactions_message &fetch_block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const item_hash_t &block_message_hash = fetch_block_transactions_message_received.block_message_hash;
+                auto block = find_block_message(block_message_hash);
+                if (!block) {
+                    originating_peer->send_message(item_not_available_message(item_id(block_message_type, block_message_hash)));
+                    return;
+                }
+
+                block_transactions_message reply(block_message_hash);
+                reply.transactions.reserve(fetch_block_transactions_message_received.indexes.size());
+                for (uint32_t index : fetch_block_transactions_message_received.indexes) {
+                    if (index >= block->block.transactions.size()) {
+                        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You requested transaction ${index} of a block with ${count} transactions",
+                                ("index", index)("count", block->block.transactions.size())));
+                        disconnect_from_peer(originating_peer, "You requested a transaction which isn't in the block", true, detailed_error);
+                        return;
+                    }
+                    reply.transactions.push_back(block->block.transactions[index]);
+                }
+                originating_peer->send_message(reply);
+            }
+
+            void node_impl::on_block_transactions_message(peer_connection *originating_peer,
+                    const block_transactions_message &block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                auto iter = originating_peer->compact_blocks_being_reconstructed.find(block_transactions_message_received.block_message_hash);
+                if (iter == originating_peer->compact_blocks_being_reconstructed.end()) {
+                    dlog("received transactions of a compact block from peer ${endpoint}, which we aren't reconstructing",
+                            ("endpoint", originating_peer->get_remote_endpoint()));
+                    return;
+                }
+                compact_block_reconstruction reconstruction = std::move(iter->second);
+                originating_peer->compact_blocks_being_reconstructed.erase(iter);
+
+                if (!reconstruction.add_missing_transactions(block_transactions_message_received.transactions)) {
+                    fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me ${count} transactions of block ${id}, which isn't what I asked for",
+                            ("count", block_transactions_message_received.transactions.size())("id", reconstruction.compact_block.block_id)));
+                    disconnect_from_peer(originating_peer, "You sent me wrong transactions of a compact block", true, detailed_error);
+                    return;
+                }
+
+                process_compact_block(originating_peer, reconstruction);
+            }
+
+            void node_impl::process_compact_block(peer_connection *originating_peer,
+                    compact_block_reconstruction &reconstruction) {
+                VERIFY_CORRECT_THREAD();
+                const compact_block_message &compact_block = reconstruction.compact_block;
+
+                message message_to_process(reconstruction.to_block_message());
+                message_hash_type message_hash = message_to_process.id();
+                if (message_hash != compact_block.block_message_hash) {
+                    // short ids of different transactions can coincide, so a wrong transaction could be taken
+                    wlog("compact block ${id} from peer ${endpoint} doesn't match the requested block, requesting the full block",
+                            ("id", compact_block.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+                    originating_peer->send_message(fetch_items_message(block_message_type,
+                            std::vector<item_hash_t>{compact_block.block_message_hash}));
+                    return;
+                }
+
+                process_block_message(originating_peer, message_to_process, message_hash);
+            }
+
             void node_impl::on_item_ids_inventory_message(peer_connection *originating_peer, const item_ids_inventory_message &item_ids_inventory_message_received) {
                 VERIFY_CORRECT_THREAD();
 
@@ -2936,12 +3221,15 @@ namespace golos {
                 dlog("received inventory of ${count} items from peer ${endpoint}",
                         ("count", item_ids_inventory_message_received.item_hashes_available.size())("endpoint", originating_peer->get_remote_endpoint()));
                 for (const item_hash_t &item_hash : item_ids_inventory_message_received.item_hashes_available) {
+                    item_id advertised_item_id(item_ids_inventory_message_received.item_type, item_hash);
+                    // the peer has it, don't advertise it back
+                    mark_item_known_to_peer(*originating_peer, advertised_item_id, fc::time_point::now());
+
                     if (_message_ids_currently_being_processed.find(item_hash) !=
                         _message_ids_currently_being_processed.end()) {
                             // we're in the middle of processing this item, no need to fetch it again
                             continue;
                     }
-                    item_id advertised_item_id(item_ids_inventory_message_received.item_type, item_hash);
 
                     if (_new_inventory.find(advertised_item_id) !=
                         _new_inventory.end()) {
@@ -2949,22 +3237,14 @@ namespace golos {
                             continue;
                     }
 
-                    bool we_advertised_this_item_to_a_peer = false;
-                    bool we_requested_this_item_from_a_peer = false;
-                    for (const peer_connection_ptr peer : _active_connections) {
-                        if (peer->inventory_advertised_to_peer.find(advertised_item_id) !=
-                            peer->inventory_advertised_to_peer.end()) {
-                            we_advertised_this_item_to_a_peer = true;
-                            break;
-                        }
-                        if (peer->items_requested_from_peer.find(advertised_item_id) !=
-                            peer->items_requested_from_peer.end()) {
-                                we_requested_this_item_from_a_peer = true;
-                        }
-                    }
-
                     // if we have already advertised it to a peer, we must have it, no need to do anything else
-                    if (!we_advertised_this_item_to_a_peer) {
+                    if (_advertised_inventory.find(advertised_item_id) == _advertised_inventory.end()) {
+                        bool we_requested_this_item_from_a_peer = std::any_of(
+                                _active_connections.begin(), _active_connections.end(),
+                                [&](const peer_connection_ptr &peer) {
+                                    return peer->items_requested_from_peer.find(advertised_item_id) !=
+                                           peer->items_requested_from_peer.end();
+                                });
                         // if the peer has flooded us with transactions, don't add these to the inventory to prevent our
                         // inventory list from growing without bound.  We try to allow fetching blocks even when
                         // we've stopped fetching transactions.
@@ -3097,7 +3377,14 @@ namespace golos {
                 // received yet, reschedule them to be fetched from another peer
                 if (!originating_peer->sync_items_requested_from_peer.empty()) {
                     for (auto sync_item : originating_peer->sync_items_requested_from_peer) {
-                        _active_sync_requests.erase(sync_item);
+                        // unless it was requested from another peer as well
+                        if (std::none_of(_active_connections.begin(), _active_connections.end(),
+                                [&](const peer_connection_ptr &peer) {
+                                    return peer.get() != originating_peer &&
+                                           peer->sync_items_requested_from_peer.count(sync_item);
+                                })) {
+                            _active_sync_requests.erase(sync_item);
+                        }
                     }
                     trigger_fetch_sync_items_loop();
                 }
@@ -3331,54 +3618,55 @@ namespace golos {
                 std::map<peer_connection_ptr, fc::oexception> peers_with_rejected_block;
 
                 do {
-                    std::copy(std::make_move_iterator(_new_received_sync_items.begin()),
-                            std::make_move_iterator(_new_received_sync_items.end()),
-                            std::front_inserter(_received_sync_items));
-                    _new_received_sync_items.clear();
                     dlog("currently ${count} sync items to consider", ("count", _received_sync_items.size()));
 
                     block_processed_this_iteration = false;
-                    for (auto received_block_iter = _received_sync_items.begin();
-                         received_block_iter != _received_sync_items.end();
-                         ++received_block_iter) {
 
-                        // find out if this block is the next block on the active chain or one of the forks
-                        bool potential_first_block = false;
+                    // the next block on the active chain or one of the forks is the first one on the list of a peer
+                    auto received_block_iter = _received_sync_items.end();
+                    for (const peer_connection_ptr &peer : _active_connections) {
+                        ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
+                        if (!peer->ids_of_items_to_get.empty()) {
+                            received_block_iter = _received_sync_items.find(peer->ids_of_items_to_get.front());
+                            if (received_block_iter != _received_sync_items.end()) {
+                                break;
+                            }
+                        }
+                    }
+
+                    // if there is one, process it, remove it from all sync peers lists
+                    if (received_block_iter != _received_sync_items.end()) {
                         for (const peer_connection_ptr &peer : _active_connections) {
                             ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
                             if (!peer->ids_of_items_to_get.empty() &&
                                 peer->ids_of_items_to_get.front() ==
-                                received_block_iter->block_id) {
-                                potential_first_block = true;
+                                received_block_iter->first) {
                                 peer->ids_of_items_to_get.pop_front();
-                                peer->ids_of_items_being_processed.insert(received_block_iter->block_id);
+                                peer->ids_of_items_being_processed.insert(received_block_iter->first);
                             }
                         }
 
-                        // if it is, process it, remove it from all sync peers lists
-                        if (potential_first_block) {
-                            // we can get into an interesting situation near the end of synchronization.  We can be in
-                            // sync with one peer who is sending us the last block on the chain via a regular inventory
-                            // message, while at the same time still be synchronizing with a peer who is sending us the
-                            // block through the sync mechanism.  Further, we must request both blocks because
-                            // we don't know they're the same (for the peer in normal operation, it has only told us the
-                            // message id, for the peer in the sync case we only known the block_id).
-                            if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
-                                    received_block_iter->block_id) ==
-                                _most_recent_blocks_accepted.end()) {
-                                golos::network::block_message block_message_to_process = *received_block_iter;
-                                _received_sync_items.erase(received_block_iter);
-                                _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process]() {
-                                    send_sync_block_to_node_delegate(block_message_to_process);
-                                }, "send_sync_block_to_node_delegate"));
-                                ++blocks_processed;
-                                block_processed_this_iteration = true;
-                            } else
-                                dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
-
-                            break; // start iterating _received_sync_items from the beginning
-                        } // end if potential_first_block
-                    } // end for each block in _received_sync_items
+                        // we can get into an interesting situation near the end of synchronization.  We can be in
+                        // sync with one peer who is sending us the last block on the chain via a regular inventory
+                        // message, while at the same time still be synchronizing with a peer who is sending us the
+                        // block through the sync mechanism.  Further, we must request both blocks because
+                        // we don't know they're the same (for the peer in normal operation, it has only told us the
+                        // message id, for the peer in the sync case we only known the block_id).
+                        if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
+                                received_block_iter->first) ==
+                            _most_recent_blocks_accepted.end()) {
+                            golos::network::block_message block_message_to_process = std::move(received_block_iter->second);
+                            _received_sync_items.erase(received_block_iter);
+                            _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process]() {
+                                send_sync_block_to_node_delegate(block_message_to_process);
+                            }, "send_sync_block_to_node_delegate"));
+                            ++blocks_processed;
+                            block_processed_this_iteration = true;
+                        } else {
+                            dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
+                            _received_sync_items.erase(received_block_iter);
+                        }
+                    }
 
                     if (_handle_message_calls_in_progress.size() >=
                         _maximum_number_of_blocks_to_handle_at_one_time) {
@@ -3414,9 +3702,9 @@ namespace golos {
                 VERIFY_CORRECT_THREAD();
                 dlog("received a sync block from peer ${endpoint}", ("endpoint", originating_peer->get_remote_endpoint()));
 
-                // add it to the front of _received_sync_items, then process _received_sync_items to try to
+                // add it to _received_sync_items, then process _received_sync_items to try to
                 // pass as many messages as possible to the client.
-                _new_received_sync_items.push_front(block_message_to_process);
+                _received_sync_items.emplace(block_message_to_process.block_id, block_message_to_process);
                 trigger_process_backlog_of_sync_blocks();
             }
 
@@ -3599,21 +3887,41 @@ namespace golos {
                     if (sync_item_iter !=
                         originating_peer->sync_items_requested_from_peer.end()) {
                         originating_peer->sync_items_requested_from_peer.erase(sync_item_iter);
-                        originating_peer->last_sync_item_received_time = fc::time_point::now();
+                        fc::time_point now = fc::time_point::now();
+                        fc::microseconds interval = now - originating_peer->last_sync_item_received_time;
+                        originating_peer->sync_item_interval = originating_peer->sync_item_interval.count() == 0
+                                ? interval
+                                : (originating_peer->sync_item_interval * 7 + interval) / 8;
+                        originating_peer->last_sync_item_received_time = now;
                         _active_sync_requests.erase(block_message_to_process.block_id);
-                        process_block_during_sync(originating_peer, block_message_to_process, message_hash);
-                        if (originating_peer->idle()) {
-                            // we have finished fetching a batch of items, so we either need to grab another batch of items
-                            // or we need to get another list of item ids.
-                            if (originating_peer->number_of_unfetched_item_ids >
-                                0 &&
-                                originating_peer->ids_of_items_to_get.size() <
-                                GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH) {
-                                    fetch_next_batch_of_item_ids_from_peer(originating_peer);
-                            } else {
-                                    trigger_fetch_sync_items_loop();
+
+                        // if we asked other peers for the block as well, we don't need their copies anymore
+                        for (const peer_connection_ptr &peer : _active_connections) {
+                            if (peer.get() != originating_peer &&
+                                peer->sync_items_requested_from_peer.erase(block_message_to_process.block_id)) {
+                                peer->sync_items_received_from_other_peers.insert(block_message_to_process.block_id);
                             }
                         }
+
+                        process_block_during_sync(originating_peer, block_message_to_process, message_hash);
+                        // we either need to grab another batch of items or we need to get another list of item ids
+                        if (originating_peer->number_of_unfetched_item_ids > 0 &&
+                            originating_peer->ids_of_items_to_get.size() <
+                            GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH &&
+                            !originating_peer->item_ids_requested_from_peer) {
+                                fetch_next_batch_of_item_ids_from_peer(originating_peer);
+                        } else {
+                                trigger_fetch_sync_items_loop();
+                        }
+                        return;
+                    }
+
+                    // we asked for it, but another peer sent it first
+                    if (originating_peer->sync_items_received_from_other_peers.erase(block_message_to_process.block_id)) {
+                        dlog("received a sync block ${block_id} from peer ${endpoint} that another peer has already sent",
+                                ("block_id", block_message_to_process.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+                        originating_peer->last_sync_item_received_time = fc::time_point::now();
+                        trigger_fetch_sync_items_loop();
                         return;
                     }
                 }
@@ -3929,6 +4237,22 @@ namespace golos {
                         if (message_to_process.msg_type == trx_message_type) {
                             trx_message transaction_message_to_process = message_to_process.as<trx_message>();
                             dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
+
+                            // the delegate may validate on other threads, other messages are handled meanwhile
+                            struct validation_counter {
+                                node_impl &node;
+
+                                validation_counter(node_impl &node) : node(node) {
+                                    node._transaction_fetch_throttle.validation_started();
+                                }
+
+                                ~validation_counter() {
+                                    if (node._transaction_fetch_throttle.validation_finished()) {
+                                        node.trigger_fetch_items_loop();
+                                    }
+                                }
+                            } transaction_validation_counter(*this);
+
                             _delegate->handle_transaction(transaction_message_to_process);
                         } else {
                             _delegate->handle_message(message_to_process);
@@ -4239,6 +4563,7 @@ namespace golos {
                         if (_node_is_shutting_down) {
                             return;
                         }
+                        new_peer->set_plaintext_allowed(is_plaintext_peer(new_peer->get_socket().remote_endpoint().get_address()));
                         new_peer->connection_initiation_time = fc::time_point::now();
                         _handshaking_connections.insert(new_peer);
                         _rate_limiter.add_tcp_socket(&new_peer->get_socket());
@@ -4318,6 +4643,7 @@ namespace golos {
                 fc::oexception connect_failed_exception;
 
                 try {
+                    new_peer->set_plaintext_allowed(is_plaintext_peer(remote_endpoint.get_address()));
                     new_peer->connect_to(remote_endpoint, _actual_listening_endpoint);  // blocks until the connection is established and secure connection is negotiated
 
                     // we connected to the peer.  guess they're not firewalled....
@@ -4734,17 +5060,18 @@ namespace golos {
                 ilog("--------- MEMORY USAGE ------------");
                 ilog("node._active_sync_requests size: ${size}", ("size", _active_sync_requests.size()));
                 ilog("node._received_sync_items size: ${size}", ("size", _received_sync_items.size()));
-                ilog("node._new_received_sync_items size: ${size}", ("size", _new_received_sync_items.size()));
                 ilog("node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size()));
                 ilog("node._new_inventory size: ${size}", ("size", _new_inventory.size()));
+                ilog("node._advertised_inventory size: ${size}", ("size", _advertised_inventory.size()));
                 ilog("node._message_cache size: ${size}", ("size", _message_cache.size()));
                 for (const peer_connection_ptr &peer : _active_connections) {
                     ilog("  peer ${endpoint}", ("endpoint", peer->get_remote_endpoint()));
                     ilog("    peer.ids_of_items_to_get size: ${size}", ("size", peer->ids_of_items_to_get.size()));
                     ilog("    peer.inventory_peer_advertised_to_us size: ${size}", ("size", peer->inventory_peer_advertised_to_us.size()));
-                    ilog("    peer.inventory_advertised_to_peer size: ${size}", ("size", peer->inventory_advertised_to_peer.size()));
+                    ilog("    peer.blocks_known_to_peer size: ${size}", ("size", peer->blocks_known_to_peer.size()));
                     ilog("    peer.items_requested_from_peer size: ${size}", ("size", peer->items_requested_from_peer.size()));
                     ilog("    peer.sync_items_requested_from_peer size: ${size}", ("size", peer->sync_items_requested_from_peer.size()));
+                    ilog("    peer.sync_items_received_from_other_peers size: ${size}", ("size", peer->sync_items_received_from_other_peers.size()));
                 }
                 ilog("--------- END MEMORY USAGE ------------");
             }
@@ -4851,6 +5178,7 @@ namespace golos {
                     peer_details["inbound"] = peer->direction ==
                                               peer_connection_direction::inbound;
                     peer_details["firewall_status"] = peer->is_firewalled;
+                    peer_details["plaintext"] = peer->is_plaintext();
                     peer_details["startingheight"] = "";
                     peer_details["banscore"] = "";
                     peer_details["syncnode"] = "";
@@ -4921,6 +5249,9 @@ namespace golos {
 
                 _message_cache.cache_message(item_to_broadcast, hash_of_item_to_broadcast, propagation_data, hash_of_message_contents);
                 _new_inventory.insert(item_id(item_to_broadcast.msg_type, hash_of_item_to_broadcast));
+                if (item_to_broadcast.msg_type == golos::network::block_message_type) {
+                    _new_inventory_has_blocks = true;
+                }
                 trigger_advertise_inventory_loop();
             }
 
@@ -5047,6 +5378,16 @@ namespace golos {
                 _rate_limiter.set_download_limit(download_bytes_per_second);
             }
 
+            void node_impl::set_plaintext_peers(const std::vector<fc::ip::address> &addresses) {
+                VERIFY_CORRECT_THREAD();
+                _plaintext_peers = addresses;
+            }
+
+            bool node_impl::is_plaintext_peer(const fc::ip::address &address) const {
+                VERIFY_CORRECT_THREAD();
+                return std::find(_plaintext_peers.begin(), _plaintext_peers.end(), address) != _plaintext_peers.end();
+            }
+
             void node_impl::disable_peer_advertising() {
                 VERIFY_CORRECT_THREAD();
                 _peer_advertising_disabled = true;
@@ -5227,6 +5568,10 @@ namespace golos {
             INVOKE_IN_IMPL(set_total_bandwidth_limit, upload_bytes_per_second, download_bytes_per_second);
         }
 
+        void node::set_plaintext_peers(const std::vector<fc::ip::address> &addresses) {
+            INVOKE_IN_IMPL(set_plaintext_peers, addresses);
+        }
+
         void node::disable_peer_advertising() {
             INVOKE_IN_IMPL(disable_peer_advertising);
         }
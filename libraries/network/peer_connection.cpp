@@ -76,10 +76,13 @@ namespace golos {
                 their_state(their_connection_state::disconnected),
                 we_have_requested_close(false),
                 negotiation_status(connection_negotiation_status::disconnected),
+                supports_compact_blocks(false),
                 number_of_unfetched_item_ids(0),
                 peer_needs_sync_items_from_us(true),
                 we_need_sync_items_from_peer(true),
+                sync_item_interval(0),
                 inhibit_fetching_sync_blocks(false),
+                transactions_known_to_peer(GRAPHENE_NET_INVENTORY_FILTER_CAPACITY),
                 transaction_fetching_inhibited_until(fc::time_point::min()),
                 last_known_fork_block_number(0),
                 firewall_check_state(nullptr)
@@ -425,25 +428,35 @@ namespace golos {
             return _message_connection.get_shared_secret();
         }
 
+        void peer_connection::set_plaintext_allowed(bool allowed) {
+            VERIFY_CORRECT_THREAD();
+            _message_connection.set_plaintext_allowed(allowed);
+        }
+
+        bool peer_connection::is_plaintext() const {
+            VERIFY_CORRECT_THREAD();
+            return _message_connection.is_plaintext();
+        }
+
         void peer_connection::clear_old_inventory() {
             VERIFY_CORRECT_THREAD();
             fc::time_point_sec oldest_inventory_to_keep(fc::time_point::now() -
                                                         fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
 
-            // expire old items from inventory_advertised_to_peer
-            auto oldest_inventory_to_keep_iter = inventory_advertised_to_peer.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-            auto begin_iter = inventory_advertised_to_peer.get<timestamp_index>().begin();
-            unsigned number_of_elements_advertised_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-            inventory_advertised_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
+            // expire old items from blocks_known_to_peer, transactions_known_to_peer drops them by itself
+            auto oldest_inventory_to_keep_iter = blocks_known_to_peer.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
+            auto begin_iter = blocks_known_to_peer.get<timestamp_index>().begin();
+            unsigned number_of_blocks_known_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
+            blocks_known_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
 
             // also expire items from inventory_peer_advertised_to_us
             oldest_inventory_to_keep_iter = inventory_peer_advertised_to_us.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
             begin_iter = inventory_peer_advertised_to_us.get<timestamp_index>().begin();
             unsigned number_of_elements_peer_advertised_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
             inventory_peer_advertised_to_us.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
-            dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
+            dlog("Expiring old inventory for peer ${peer}: removing ${blocks} blocks known to peer (${remain_blocks} left), and ${to_us} advertised to us (${remain_to_us} left)",
                     ("peer", get_remote_endpoint())
-                            ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
+                            ("blocks", number_of_blocks_known_to_peer_to_discard)("remain_blocks", blocks_known_to_peer.size())
                             ("to_us", number_of_elements_peer_advertised_to_discard)("remain_to_us", inventory_peer_advertised_to_us.size()));
         }
 
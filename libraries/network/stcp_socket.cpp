@@ -30,6 +30,7 @@
 #include <fc/network/ip.hpp>
 
 #include <golos/network/stcp_socket.hpp>
+#include <golos/network/config.hpp>
 
 namespace golos {
     namespace network {
@@ -46,16 +47,33 @@ namespace golos {
         stcp_socket::~stcp_socket() {
         }
 
+        /// set in the first byte of a public key (0x02 or 0x03 when compressed) by a side that allows plaintext
+        static const char plaintext_key_flag = 0x10;
+
+        fc::ecc::public_key_data stcp_socket::key_exchange_data(const fc::ecc::public_key &key, bool plaintext_allowed) {
+            fc::ecc::public_key_data result = key.serialize();
+            if (plaintext_allowed) {
+                result.data[0] |= plaintext_key_flag;
+            }
+            return result;
+        }
+
+        bool stcp_socket::take_plaintext_flag(fc::ecc::public_key_data &key_data) {
+            bool result = (key_data.data[0] & plaintext_key_flag) != 0;
+            key_data.data[0] &= ~plaintext_key_flag;
+            return result;
+        }
+
         void stcp_socket::do_key_exchange() {
             _priv_key = fc::ecc::private_key::generate();
-            fc::ecc::public_key pub = _priv_key.get_public_key();
-            fc::ecc::public_key_data s = pub.serialize();
+            fc::ecc::public_key_data s = key_exchange_data(_priv_key.get_public_key(), _plaintext_allowed);
             std::shared_ptr<char> serialized_key_buffer(new char[sizeof(fc::ecc::public_key_data)], [](char *p) { delete[] p; });
             memcpy(serialized_key_buffer.get(), (char *)&s, sizeof(fc::ecc::public_key_data));
             _sock.write(serialized_key_buffer, sizeof(fc::ecc::public_key_data));
             _sock.read(serialized_key_buffer, sizeof(fc::ecc::public_key_data));
             fc::ecc::public_key_data rpub;
             memcpy((char *)&rpub, serialized_key_buffer.get(), sizeof(fc::ecc::public_key_data));
+            _plaintext = take_plaintext_flag(rpub) && _plaintext_allowed;
 
             _shared_secret = _priv_key.get_shared_secret(rpub);
 //    ilog("shared secret ${s}", ("s", shared_secret) );
@@ -79,6 +97,9 @@ namespace golos {
  *   This method must read at least 16 bytes at a time from
  *   the underlying TCP socket so that it can decrypt them. It
  *   will buffer any left-over.
+ *
+ *   Without encryption it returns whatever is available, which
+ *   may end in the middle of a block.
  */
         size_t stcp_socket::readsome(char *buffer, size_t len) {
             try {
@@ -104,13 +125,17 @@ namespace golos {
                 } buffer_in_use_checker(_read_buffer_in_use);
 #endif
 
-                const size_t read_buffer_length = 4096;
+                const size_t read_buffer_length = GRAPHENE_NET_READ_BUFFER_SIZE;
                 if (!_read_buffer) {
                     _read_buffer.reset(new char[read_buffer_length], [](char *p) { delete[] p; });
                 }
 
                 len = std::min<size_t>(read_buffer_length, len);
 
+                if (_plaintext) {
+                    return _sock.readsome(buffer, len);
+                }
+
                 size_t s = _sock.readsome(_read_buffer, len, 0);
                 if (s % 16) {
                     _sock.read(_read_buffer, 16 - (s % 16), s);
@@ -153,11 +178,16 @@ namespace golos {
                 } buffer_in_use_checker(_write_buffer_in_use);
 #endif
 
-                const std::size_t write_buffer_length = 4096;
+                const std::size_t write_buffer_length = GRAPHENE_NET_WRITE_BUFFER_SIZE;
+                len = std::min<size_t>(write_buffer_length, len);
+                if (_plaintext) {
+                    _sock.write(buffer, len);
+                    return len;
+                }
+
                 if (!_write_buffer) {
                     _write_buffer.reset(new char[write_buffer_length], [](char *p) { delete[] p; });
                 }
-                len = std::min<size_t>(write_buffer_length, len);
                 memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
                 /**
                  * every sizeof(crypt_buf) bytes the aes channel
@@ -0,0 +1,391 @@
+#include <golos/plugins/account_history/history_archive.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+
+#define LOG_READ  (std::ios::in | std::ios::binary)
+#define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
+
+namespace golos {
+namespace plugins {
+namespace account_history {
+
+namespace detail {
+
+struct archive_state {
+    uint32_t version = 0;
+    uint32_t head_block = 0;
+    uint64_t operations_size = 0;
+    uint64_t accounts_size = 0;
+    uint32_t pages = 0;
+};
+
+} // detail
+
+} } } // golos::plugins::account_history
+
+FC_REFLECT((golos::plugins::account_history::detail::archive_state),
+    (version)(head_block)(operations_size)(accounts_size)(pages))
+
+namespace golos {
+namespace plugins {
+namespace account_history {
+
+namespace bip = boost::interprocess;
+
+using detail::archive_state;
+
+static const uint32_t archive_version = 4;
+
+static const char *operations_file = "operations.log";
+static const char *accounts_file = "accounts.log";
+static const char *pages_file = "entries.idx";
+static const char *state_file = "head.state";
+
+static const uint32_t initial_pages = 1024;
+
+/// An entry is the offset of the operation shifted left by 16 bits and the operation type
+struct history_archive::page {
+    static constexpr uint32_t capacity = (page_size - 16) / sizeof(uint64_t);
+
+    uint32_t account_id;
+    uint32_t size;
+    uint64_t op_mask;
+    uint64_t entries[capacity];
+
+    static uint64_t offset(uint64_t entry) {
+        return entry >> 16;
+    }
+
+    static uint16_t op_tag(uint64_t entry) {
+        return uint16_t(entry);
+    }
+};
+
+static uint64_t op_tag_mask(uint16_t op_tag) {
+    // types out of the mask can't be queried
+    return op_tag < 64 ? uint64_t(1) << op_tag : 0;
+}
+
+archived_operation::archived_operation(const golos::chain::operation_object &obj)
+    : trx_id(obj.trx_id),
+      block(obj.block),
+      trx_in_block(obj.trx_in_block),
+      op_in_trx(obj.op_in_trx),
+      virtual_op(obj.virtual_op),
+      timestamp(obj.timestamp),
+      serialized_op(obj.serialized_op.begin(), obj.serialized_op.end()) {
+}
+
+history_archive::history_archive() {
+    _operations_out.exceptions(std::fstream::failbit | std::fstream::badbit);
+    _accounts_out.exceptions(std::fstream::failbit | std::fstream::badbit);
+}
+
+history_archive::~history_archive() {
+    close();
+}
+
+void history_archive::open(const fc::path &dir) {
+    static_assert(sizeof(page) == page_size, "Page of account history archive has wrong size");
+
+    close();
+
+    _dir = dir;
+    fc::create_directories(_dir);
+
+    auto operations_path = _dir / operations_file;
+    auto accounts_path = _dir / accounts_file;
+    auto pages_path = _dir / pages_file;
+    auto state_path = _dir / state_file;
+
+    archive_state state;
+    state.version = archive_version;
+    if (fc::exists(state_path)) {
+        std::ifstream in(state_path.generic_string(), LOG_READ);
+        fc::raw::unpack(in, state);
+        FC_ASSERT(state.version == archive_version,
+            "Account history archive at ${d} has format version ${v}, expected ${e}, run with --replay-blockchain",
+            ("d", _dir)("v", state.version)("e", archive_version));
+    }
+
+    // drop the tail written after the last commit
+    for (const auto &file: {std::make_pair(operations_path, state.operations_size),
+                            std::make_pair(accounts_path, state.accounts_size)}) {
+        if (!fc::exists(file.first)) {
+            std::ofstream create(file.first.generic_string(), LOG_WRITE);
+        }
+        FC_ASSERT(fc::file_size(file.first) >= file.second,
+            "Account history archive file ${f} is shorter than recorded in ${s}",
+            ("f", file.first)("s", state_path));
+        boost::filesystem::resize_file(file.first, file.second);
+    }
+    if (!fc::exists(pages_path)) {
+        std::ofstream create(pages_path.generic_string(), LOG_WRITE);
+    }
+    FC_ASSERT(fc::file_size(pages_path) >= uint64_t(state.pages) * page_size,
+        "Account history archive file ${f} is shorter than recorded in ${s}", ("f", pages_path)("s", state_path));
+    if (fc::file_size(pages_path) < uint64_t(initial_pages) * page_size) {
+        boost::filesystem::resize_file(pages_path, uint64_t(initial_pages) * page_size);
+    }
+
+    _head_block = state.head_block;
+    _operations_size = state.operations_size;
+    _accounts_size = state.accounts_size;
+    _pages = state.pages;
+
+    _account_ids.clear();
+    _entries.clear();
+    {
+        std::ifstream in(accounts_path.generic_string(), LOG_READ);
+        in.exceptions(std::fstream::failbit | std::fstream::badbit);
+        uint64_t pos = 0;
+        account_name_type account;
+        while (pos < _accounts_size) {
+            fc::raw::unpack(in, account);
+            _account_ids.emplace(account, _entries.size());
+            _entries.emplace_back();
+            pos = in.tellg();
+        }
+    }
+
+    map_pages();
+
+    // pages of an account follow in the order of entries, only the last one may be partially filled
+    for (uint32_t number = 0; number < _pages; ++number) {
+        const auto &p = get_page(number);
+        FC_ASSERT(p.account_id < _entries.size(), "Unknown account id ${i} in account history archive", ("i", p.account_id));
+        auto &entries = _entries[p.account_id];
+        FC_ASSERT(entries.size % page::capacity == 0, "Account history archive has a partial page of an account before its last one");
+        entries.pages.push_back({number, p.op_mask});
+        entries.size += p.size;
+    }
+
+    // entries appended to the last pages after the last commit point beyond operations.log
+    for (auto &entries: _entries) {
+        if (entries.pages.empty()) {
+            continue;
+        }
+        auto &last = entries.pages.back();
+        auto &p = get_page(last.number);
+        uint32_t size = 0;
+        uint64_t op_mask = 0;
+        for (; size < p.size && page::offset(p.entries[size]) < _operations_size; ++size) {
+            op_mask |= op_tag_mask(page::op_tag(p.entries[size]));
+        }
+        FC_ASSERT(size != 0, "Account history archive has an empty page");
+        entries.size -= p.size - size;
+        p.size = size;
+        p.op_mask = op_mask;
+        last.op_mask = op_mask;
+    }
+
+    _operations_out.open(operations_path.generic_string(), LOG_WRITE);
+    _accounts_out.open(accounts_path.generic_string(), LOG_WRITE);
+    _operations_in.open(operations_path.generic_string(), LOG_READ);
+
+    _is_open = true;
+
+    ilog("Account history archive opened at block ${b} with ${n} accounts", ("b", _head_block)("n", _entries.size()));
+}
+
+void history_archive::close() {
+    if (!_is_open) {
+        return;
+    }
+    _operations_out.close();
+    _accounts_out.close();
+    _operations_in.close();
+    _pages_region->flush();
+    unmap_pages();
+    _is_open = false;
+}
+
+void history_archive::wipe() {
+    auto dir = _dir;
+    close();
+    fc::remove_all(dir / operations_file);
+    fc::remove_all(dir / accounts_file);
+    fc::remove_all(dir / pages_file);
+    fc::remove_all(dir / state_file);
+    open(dir);
+}
+
+void history_archive::map_pages() {
+    auto pages_path = (_dir / pages_file).generic_string();
+    _pages_mapping.reset(new bip::file_mapping(pages_path.c_str(), bip::read_write));
+    _pages_region.reset(new bip::mapped_region(*_pages_mapping, bip::read_write));
+}
+
+void history_archive::unmap_pages() {
+    _pages_region.reset();
+    _pages_mapping.reset();
+}
+
+history_archive::page &history_archive::get_page(uint32_t number) const {
+    return reinterpret_cast<page *>(_pages_region->get_address())[number];
+}
+
+uint32_t history_archive::size(const account_name_type &account) const {
+    auto itr = _account_ids.find(account);
+    if (itr == _account_ids.end()) {
+        return 0;
+    }
+    return _entries[itr->second].size;
+}
+
+uint32_t history_archive::get_account_id(const account_name_type &account) {
+    auto itr = _account_ids.find(account);
+    if (itr != _account_ids.end()) {
+        return itr->second;
+    }
+
+    auto data = fc::raw::pack(account);
+    _accounts_out.write(data.data(), data.size());
+    _accounts_size += data.size();
+
+    uint32_t id = _entries.size();
+    _account_ids.emplace(account, id);
+    _entries.emplace_back();
+    return id;
+}
+
+void history_archive::add_entry(uint32_t account_id, uint16_t op_tag, uint64_t offset) {
+    auto &entries = _entries[account_id];
+    if (entries.size % page::capacity == 0) {
+        if (uint64_t(_pages + 1) * page_size > _pages_region->get_size()) {
+            // the file doubles, it is read under the read lock of the database and appended under the write lock
+            auto new_size = _pages_region->get_size() * 2;
+            _pages_region->flush();
+            unmap_pages();
+            boost::filesystem::resize_file(_dir / pages_file, new_size);
+            map_pages();
+        }
+        auto &p = get_page(_pages);
+        p.account_id = account_id;
+        p.size = 0;
+        p.op_mask = 0;
+        entries.pages.push_back({_pages, 0});
+        ++_pages;
+    }
+
+    auto &last = entries.pages.back();
+    auto &p = get_page(last.number);
+    p.entries[p.size++] = (offset << 16) | op_tag;
+    p.op_mask |= op_tag_mask(op_tag);
+    last.op_mask = p.op_mask;
+    ++entries.size;
+}
+
+void history_archive::append(
+    const archived_operation &op, uint16_t op_tag, const std::vector<account_name_type> &accounts
+) {
+    if (accounts.empty()) {
+        return;
+    }
+
+    auto data = fc::raw::pack(op);
+    auto size_prefix = fc::raw::pack(fc::unsigned_int(data.size()));
+
+    auto offset = _operations_size;
+    _operations_out.write(size_prefix.data(), size_prefix.size());
+    _operations_out.write(data.data(), data.size());
+    _operations_size += size_prefix.size() + data.size();
+
+    for (const auto &account: accounts) {
+        add_entry(get_account_id(account), op_tag, offset);
+    }
+}
+
+void history_archive::commit(uint32_t block) {
+    _operations_out.flush();
+    _accounts_out.flush();
+    _pages_region->flush();
+    _head_block = block;
+    write_state();
+}
+
+void history_archive::write_state() {
+    archive_state state;
+    state.version = archive_version;
+    state.head_block = _head_block;
+    state.operations_size = _operations_size;
+    state.accounts_size = _accounts_size;
+    state.pages = _pages;
+
+    auto state_path = _dir / state_file;
+    auto tmp_path = fc::path(state_path.generic_string() + ".tmp");
+    {
+        std::ofstream out(tmp_path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.exceptions(std::fstream::failbit | std::fstream::badbit);
+        auto data = fc::raw::pack(state);
+        out.write(data.data(), data.size());
+    }
+    fc::rename(tmp_path, state_path);
+}
+
+bool history_archive::get(const account_name_type &account, uint32_t sequence, archived_operation &op) const {
+    auto itr = _account_ids.find(account);
+    if (itr == _account_ids.end()) {
+        return false;
+    }
+    const auto &entries = _entries[itr->second];
+    if (sequence >= entries.size) {
+        return false;
+    }
+    const auto &p = get_page(entries.pages[sequence / page::capacity].number);
+    auto offset = page::offset(p.entries[sequence % page::capacity]);
+
+    std::lock_guard<std::mutex> lock(_read_mutex);
+
+    _operations_in.clear();
+    _operations_in.seekg(offset);
+
+    fc::unsigned_int data_size;
+    fc::raw::unpack(_operations_in, data_size);
+    std::vector<char> data(data_size.value);
+    _operations_in.read(data.data(), data.size());
+    FC_ASSERT(_operations_in, "Can't read operation ${s} of ${a} from account history archive",
+        ("s", sequence)("a", account));
+
+    op = fc::raw::unpack<archived_operation>(data);
+    return true;
+}
+
+std::vector<uint32_t> history_archive::find(
+    const account_name_type &account, uint32_t from, uint32_t limit, uint64_t op_mask
+) const {
+    std::vector<uint32_t> result;
+    auto itr = _account_ids.find(account);
+    if (itr == _account_ids.end() || limit == 0) {
+        return result;
+    }
+    const auto &entries = _entries[itr->second];
+    if (entries.size == 0) {
+        return result;
+    }
+
+    // pages are visited from the newest one, pages without the types are skipped without reading them
+    uint64_t sequence = std::min(from, entries.size - 1);
+    for (auto number = sequence / page::capacity + 1; number-- > 0 && result.size() < limit;) {
+        if (!(entries.pages[number].op_mask & op_mask)) {
+            sequence = number * page::capacity - 1;
+            continue;
+        }
+        const auto &p = get_page(entries.pages[number].number);
+        for (auto i = sequence % page::capacity + 1; i-- > 0 && result.size() < limit;) {
+            if (op_tag_mask(page::op_tag(p.entries[i])) & op_mask) {
+                result.push_back(number * page::capacity + i);
+            }
+        }
+        sequence = number * page::capacity - 1;
+    }
+    return result;
+}
+
+} } } // golos::plugins::account_history
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+#include <golos/chain/history_object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace boost {
+namespace interprocess {
+class file_mapping;
+class mapped_region;
+} } // boost::interprocess
+
+namespace golos {
+namespace plugins {
+namespace account_history {
+
+using golos::protocol::account_name_type;
+using golos::protocol::transaction_id_type;
+
+/**
+ *  Copy of operation_object living outside of the shared memory
+ */
+struct archived_operation {
+    archived_operation() = default;
+
+    archived_operation(const golos::chain::operation_object &obj);
+
+    transaction_id_type trx_id;
+    uint32_t block = 0;
+    uint32_t trx_in_block = 0;
+    uint16_t op_in_trx = 0;
+    uint64_t virtual_op = 0;
+    fc::time_point_sec timestamp;
+    std::vector<char> serialized_op;
+};
+
+struct account_name_hash {
+    std::size_t operator()(const account_name_type &name) const {
+        return std::hash<std::string>()(std::string(name));
+    }
+};
+
+/**
+ *  Append-only storage of the account history of irreversible blocks.
+ *
+ *  Each operation is stored once in operations.log, no matter how many accounts it impacts.
+ *  accounts.log assigns numeric ids to account names in the order of their first appearance.
+ *  entries.idx is a memory mapped file of pages of page_size bytes, each page keeps entries of one
+ *  account: the offset of the operation in operations.log and its type. Only numbers of the pages
+ *  of each account and masks of the operation types in them are kept in memory, so a query by
+ *  operation types reads only the pages having them.
+ *  head.state keeps the last archived block and the sizes of the files at that block,
+ *  anything written after them (by an unclean shutdown) is dropped on open.
+ */
+class history_archive final {
+public:
+    static constexpr uint32_t page_size = 4096;
+
+    history_archive();
+
+    ~history_archive();
+
+    void open(const fc::path &dir);
+
+    void close();
+
+    /// Removes all archived history
+    void wipe();
+
+    bool is_open() const {
+        return _is_open;
+    }
+
+    uint32_t head_block() const {
+        return _head_block;
+    }
+
+    /// Number of archived entries of the account, which is also the sequence of its next entry
+    uint32_t size(const account_name_type &account) const;
+
+    /// Appends operation to the history of each account, assigning it the next sequence number
+    void append(const archived_operation &op, uint16_t op_tag, const std::vector<account_name_type> &accounts);
+
+    /// Flushes appended operations and marks everything up to block as archived
+    void commit(uint32_t block);
+
+    bool get(const account_name_type &account, uint32_t sequence, archived_operation &op) const;
+
+    /// Up to limit newest sequences not greater than from of the account entries with the operation type in op_mask
+    std::vector<uint32_t> find(
+        const account_name_type &account, uint32_t from, uint32_t limit, uint64_t op_mask) const;
+
+private:
+    struct page;
+
+    struct page_ref {
+        uint32_t number;
+        uint64_t op_mask; ///< operation types of the entries of the page
+    };
+
+    struct account_entries {
+        uint32_t size = 0;
+        std::vector<page_ref> pages;
+    };
+
+    uint32_t get_account_id(const account_name_type &account);
+
+    void add_entry(uint32_t account_id, uint16_t op_tag, uint64_t offset);
+
+    page &get_page(uint32_t number) const;
+
+    void map_pages();
+
+    void unmap_pages();
+
+    void write_state();
+
+    fc::path _dir;
+    bool _is_open = false;
+    uint32_t _head_block = 0;
+
+    std::ofstream _operations_out;
+    std::ofstream _accounts_out;
+    uint64_t _operations_size = 0;
+    uint64_t _accounts_size = 0;
+    uint32_t _pages = 0;
+
+    std::unique_ptr<boost::interprocess::file_mapping> _pages_mapping;
+    std::unique_ptr<boost::interprocess::mapped_region> _pages_region;
+
+    mutable std::mutex _read_mutex;
+    mutable std::ifstream _operations_in;
+
+    std::unordered_map<account_name_type, uint32_t, account_name_hash> _account_ids;
+    std::vector<account_entries> _entries;
+};
+
+} } } // golos::plugins::account_history
+
+FC_REFLECT((golos::plugins::account_history::archived_operation),
+    (trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op))
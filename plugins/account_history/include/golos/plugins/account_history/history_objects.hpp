@@ -0,0 +1,77 @@
+#pragma once
+
+#include <golos/chain/history_object.hpp>
+#include <golos/chain/steem_object_types.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace golos {
+namespace plugins {
+namespace account_history {
+
+using golos::protocol::account_name_type;
+using chainbase::object;
+using chainbase::object_id;
+using chainbase::allocator;
+using golos::chain::by_id;
+using golos::chain::operation_id_type;
+
+// ACCOUNT_HISTORY_SPACE_ID is the same as the one of tags
+#ifndef ACCOUNT_OPERATIONS_SPACE_ID
+#define ACCOUNT_OPERATIONS_SPACE_ID 10
+#endif
+
+enum account_operations_object_type {
+    account_operation_object_type = (ACCOUNT_OPERATIONS_SPACE_ID << 8)
+};
+
+/**
+ *  Type of the operation of an account_history_object, indexed to filter account history
+ *  by operation types without visiting other entries. It is created and removed together
+ *  with the account_history_object of the same account and sequence.
+ */
+class account_operation_object : public object<account_operation_object_type, account_operation_object> {
+public:
+    template<typename Constructor, typename Allocator>
+    account_operation_object(Constructor &&c, allocator<Allocator> a) {
+        c(*this);
+    }
+
+    id_type id;
+
+    account_name_type account;
+    uint32_t sequence = 0;
+    uint16_t op_tag = 0; ///< operation::which() of the operation
+    operation_id_type op;
+};
+
+typedef object_id<account_operation_object> account_operation_id_type;
+
+struct by_account_operation;
+struct by_operation;
+
+using namespace boost::multi_index;
+
+typedef multi_index_container<
+    account_operation_object,
+    indexed_by<
+        ordered_unique<tag<by_id>,
+            member<account_operation_object, account_operation_id_type, &account_operation_object::id>>,
+        ordered_unique<tag<by_account_operation>,
+            composite_key<account_operation_object,
+                member<account_operation_object, account_name_type, &account_operation_object::account>,
+                member<account_operation_object, uint16_t, &account_operation_object::op_tag>,
+                member<account_operation_object, uint32_t, &account_operation_object::sequence>>,
+            composite_key_compare<std::less<account_name_type>, std::less<uint16_t>, std::greater<uint32_t>>>,
+        ordered_unique<tag<by_operation>,
+            composite_key<account_operation_object,
+                member<account_operation_object, operation_id_type, &account_operation_object::op>,
+                member<account_operation_object, account_name_type, &account_operation_object::account>>>>,
+    allocator<account_operation_object>>
+    account_operation_index;
+
+} } } // golos::plugins::account_history
+
+FC_REFLECT((golos::plugins::account_history::account_operation_object), (id)(account)(sequence)(op_tag)(op))
+CHAINBASE_SET_INDEX_TYPE(golos::plugins::account_history::account_operation_object,
+                         golos::plugins::account_history::account_operation_index)
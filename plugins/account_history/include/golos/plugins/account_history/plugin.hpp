@@ -27,6 +27,7 @@
 #include <golos/plugins/chain/plugin.hpp>
 
 #include <golos/chain/database.hpp>
+#include <golos/plugins/account_history/history_archive.hpp>
 #include <boost/program_options.hpp>
 
 #include <fc/thread/future.hpp>
@@ -55,6 +56,9 @@ enum account_history_object_type {
     bucket_object_type = 1 ///< used in market_history_plugin
 };
 
+/// Accounts whose history includes the operation
+void operation_get_impacted_accounts(const golos::protocol::operation &op, flat_set<golos::chain::account_name_type> &result);
+
 /**
 *  This plugin is designed to track a range of operations by account so that one node
 *  doesn't need to hold the full operation history in memory.
@@ -80,11 +84,20 @@ public:
 
     void plugin_startup() override;
 
-    void plugin_shutdown() override {
-    }
+    void plugin_shutdown() override;
 
     flat_map<string, string> tracked_accounts() const; /// map start_range to end_range
 
+    /// History of irreversible blocks is kept in the archive instead of the shared memory
+    bool is_archive_enabled() const;
+
+    /// Entries from - limit ... from of the account history, both from the archive and the shared memory
+    std::map<uint32_t, archived_operation> get_account_history(const std::string &account, uint64_t from, uint32_t limit) const;
+
+    /// Up to limit newest entries not newer than from with operation types in op_mask (bit operation::which())
+    std::map<uint32_t, archived_operation> get_account_history(
+        const std::string &account, uint64_t from, uint32_t limit, uint64_t op_mask) const;
+
 private:
     struct plugin_impl;
 
@@ -2,6 +2,9 @@
 
 #include <golos/chain/operation_notification.hpp>
 #include <golos/chain/history_object.hpp>
+#include <golos/chain/index.hpp>
+#include <golos/plugins/account_history/history_archive.hpp>
+#include <golos/plugins/account_history/history_objects.hpp>
 
 #include <fc/smart_ref_impl.hpp>
 
@@ -13,7 +16,6 @@ namespace plugins {
 namespace account_history {
 
 struct operation_visitor_filter;
-void operation_get_impacted_accounts(const operation &op, flat_set<golos::chain::account_name_type> &result);
 
 using namespace golos::protocol;
 using namespace golos::chain;
@@ -32,15 +34,16 @@ if( options.count(name) ) { \
 // 
 
 struct operation_visitor {
-    operation_visitor(golos::chain::database &db, const golos::chain::operation_notification &note, const golos::chain::operation_object *&n, std::string i)
-        : _db(db), _note(note), new_obj(n), item(i){};
+    operation_visitor(golos::chain::database &db, const golos::chain::operation_notification &note, const golos::chain::operation_object *&n, std::string i, const history_archive &archive)
+        : _db(db), _note(note), new_obj(n), item(i), _archive(archive) {};
 
     typedef void result_type;
 
     golos::chain::database &_db;
     const golos::chain::operation_notification &_note;
     const golos::chain::operation_object *&new_obj;
-    string item;
+    golos::chain::account_name_type item;
+    const history_archive &_archive;
 
     template<typename Op>
     void operator()(Op &&) const {
@@ -61,10 +64,17 @@ struct operation_visitor {
             });
         }
 
+        // the tail in the shared memory is covered by undo sessions, so the next sequence is taken
+        // from its newest entry, and only an account without reversible entries looks into the archive.
+        // A counter per account outside of the shared memory would have to follow undo: pending
+        // transactions are undone and applied again after every block, and blocks can be popped.
+        // The lookup is a descent of the by_account index, which the new entry takes anyway.
+        uint32_t sequence;
         auto hist_itr = hist_idx.lower_bound(boost::make_tuple(item, uint32_t(-1)));
-        uint32_t sequence = 0;
         if (hist_itr != hist_idx.end() && hist_itr->account == item) {
-                sequence = hist_itr->sequence + 1;
+            sequence = hist_itr->sequence + 1;
+        } else {
+            sequence = _archive.size(item);
         }
 
         _db.create<golos::chain::account_history_object>([&](golos::chain::account_history_object &ahist) {
@@ -72,11 +82,17 @@ struct operation_visitor {
             ahist.sequence = sequence;
             ahist.op = new_obj->id;
         });
+        _db.create<account_operation_object>([&](account_operation_object &aop) {
+            aop.account = item;
+            aop.sequence = sequence;
+            aop.op_tag = _note.op.which();
+            aop.op = new_obj->id;
+        });
     }
 };
 struct operation_visitor_filter : operation_visitor {
-    operation_visitor_filter(golos::chain::database &db, const golos::chain::operation_notification &note, const golos::chain::operation_object *&n, std::string i, const flat_set<string> &filter, bool blacklist, uint32_t start_block)
-        : operation_visitor(db, note, n, i), _filter(filter), _blacklist(blacklist), _start_block(start_block) {
+    operation_visitor_filter(golos::chain::database &db, const golos::chain::operation_notification &note, const golos::chain::operation_object *&n, std::string i, const history_archive &archive, const flat_set<string> &filter, bool blacklist, uint32_t start_block)
+        : operation_visitor(db, note, n, i, archive), _filter(filter), _blacklist(blacklist), _start_block(start_block) {
     }
 
     const flat_set<string> &_filter;
@@ -123,12 +139,176 @@ public:
             if (!_tracked_accounts.size() ||
                 (itr != _tracked_accounts.end() && itr->first <= item && item <= itr->second)) {
                 if (_filter_content) {
-                    note.op.visit(operation_visitor_filter(db, note, new_obj, item, _op_list, _blacklist, _start_block));
+                    note.op.visit(operation_visitor_filter(db, note, new_obj, item, _archive, _op_list, _blacklist, _start_block));
                 } else {
-                    note.op.visit(operation_visitor(db, note, new_obj, item));
+                    note.op.visit(operation_visitor(db, note, new_obj, item, _archive));
+                }
+            }
+        }
+    }
+
+    void on_applied_block(const signed_block &block) {
+        try {
+            if (block.block_num() == 1 && _archive.head_block() > 0) {
+                wlog("Account history: the chain is being replayed, wiping the archive");
+                _archive.wipe();
+            }
+            archive_irreversible_operations();
+        } FC_CAPTURE_AND_LOG((block.block_num()))
+    }
+
+    /**
+     *  Moves history of irreversible blocks from the shared memory to the archive.
+     *
+     *  Removed objects can be restored by undo if the head block is popped, so operations of
+     *  blocks already in the archive are only removed, not appended again.
+     */
+    void archive_irreversible_operations() {
+        golos::chain::database &db = database();
+
+        const auto last_irreversible_block = db.last_non_undoable_block_num();
+        const auto &op_idx = db.get_index<operation_index>().indices().get<by_id>();
+        const auto &hist_idx = db.get_index<account_history_index>().indices().get<by_account>();
+        const auto &aop_idx = db.get_index<account_operation_index>().indices().get<by_operation>();
+
+        std::vector<account_name_type> accounts;
+        uint32_t current_block = 0;
+        uint32_t count = 0;
+
+        while (!op_idx.empty() && op_idx.begin()->block <= last_irreversible_block) {
+            const auto &op = *op_idx.begin();
+
+            // a big backlog (e.g. after enabling the archive) is moved by parts, whole blocks at a time
+            if (op.block != current_block) {
+                if (count >= _max_archive_ops_per_block) {
+                    break;
+                }
+                current_block = op.block;
+            }
+            const bool append = op.block > _archive.head_block();
+
+            // all entries of the operation are removed with it, so none of them is left pointing to nothing
+            accounts.clear();
+            uint16_t op_tag = 0;
+            for (auto aop_itr = aop_idx.lower_bound(op.id); aop_itr != aop_idx.end() && aop_itr->op == op.id;) {
+                const auto &aop = *aop_itr++;
+                op_tag = aop.op_tag;
+                if (append) {
+                    if (aop.sequence == _archive.size(aop.account)) {
+                        accounts.push_back(aop.account);
+                    } else {
+                        elog("Account history: sequence ${s} of ${a} doesn't follow the archive of ${n} entries",
+                             ("s", aop.sequence)("a", aop.account)("n", _archive.size(aop.account)));
+                    }
+                }
+                auto itr = hist_idx.find(boost::make_tuple(aop.account, aop.sequence));
+                if (itr != hist_idx.end()) {
+                    db.remove(*itr);
+                }
+                db.remove(aop);
+            }
+
+            if (append) {
+                _archive.append(archived_operation(op), op_tag, accounts);
+            }
+            db.remove(op);
+            ++count;
+        }
+
+        uint32_t archived_block = last_irreversible_block;
+        if (!op_idx.empty() && op_idx.begin()->block <= last_irreversible_block) {
+            archived_block = op_idx.begin()->block - 1;
+        }
+        if (archived_block > _archive.head_block()) {
+            _archive.commit(archived_block);
+        }
+    }
+
+    std::map<uint32_t, archived_operation> get_account_history(
+        const std::string &account, uint64_t from, uint32_t limit
+    ) const {
+        FC_ASSERT(limit <= 10000, "Limit of ${l} is greater than maxmimum allowed", ("l", limit));
+        FC_ASSERT(from >= limit, "From must be greater than limit");
+
+        std::map<uint32_t, archived_operation> result;
+
+        const auto &hist_idx = database_.get_index<account_history_index>().indices().get<by_account>();
+        auto itr = hist_idx.lower_bound(boost::make_tuple(account_name_type(account), uint32_t(-1)));
+
+        uint32_t archived = _archive.size(account);
+        uint64_t total = archived;
+        if (itr != hist_idx.end() && itr->account == account) {
+            total = uint64_t(itr->sequence) + 1;
+        }
+        if (total == 0) {
+            return result;
+        }
+
+        auto start = std::min(from, total - 1);
+        auto end = start - std::min<uint64_t>(start, limit);
+
+        for (auto sequence = start + 1; sequence-- > end;) {
+            if (sequence < archived) {
+                archived_operation op;
+                if (_archive.get(account, sequence, op)) {
+                    result[sequence] = std::move(op);
                 }
+                continue;
+            }
+            auto hist_itr = hist_idx.find(boost::make_tuple(account_name_type(account), uint32_t(sequence)));
+            if (hist_itr != hist_idx.end()) {
+                result[sequence] = archived_operation(database_.get(hist_itr->op));
             }
         }
+        return result;
+    }
+
+    /**
+     *  Up to limit newest entries not newer than from, which have the operation type in op_mask:
+     *  the shared memory keeps account entries indexed by operation type and the archive
+     *  skips pages of entries without the types.
+     */
+    std::map<uint32_t, archived_operation> get_account_history(
+        const std::string &account, uint64_t from, uint32_t limit, uint64_t op_mask
+    ) const {
+        FC_ASSERT(limit <= 10000, "Limit of ${l} is greater than maxmimum allowed", ("l", limit));
+
+        std::map<uint32_t, archived_operation> result;
+        const account_name_type name(account);
+        const uint32_t start = std::min<uint64_t>(from, uint32_t(-1));
+
+        std::vector<std::pair<uint32_t, operation_id_type>> entries;
+        const auto &hist_idx = database_.get_index<account_operation_index>().indices().get<by_account_operation>();
+        for (uint16_t tag = 0; tag < 64; ++tag) {
+            if (!(op_mask & (uint64_t(1) << tag))) {
+                continue;
+            }
+            auto itr = hist_idx.lower_bound(boost::make_tuple(name, tag, start));
+            for (uint32_t n = 0; n < limit && itr != hist_idx.end() && itr->account == name && itr->op_tag == tag;
+                 ++n, ++itr) {
+                entries.emplace_back(itr->sequence, itr->op);
+            }
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto &l, const auto &r) {
+            return l.first > r.first;
+        });
+        if (entries.size() > limit) {
+            entries.resize(limit);
+        }
+        for (const auto &entry: entries) {
+            result[entry.first] = archived_operation(database_.get(entry.second));
+        }
+
+        // entries of the shared memory are newer than the archived ones
+        if (entries.size() < limit) {
+            for (auto sequence: _archive.find(name, start, limit - entries.size(), op_mask)) {
+                archived_operation op;
+                if (_archive.get(name, sequence, op)) {
+                    result[sequence] = std::move(op);
+                }
+            }
+        }
+        return result;
     }
 
     flat_map<string, string> _tracked_accounts;
@@ -137,6 +317,10 @@ public:
     bool _blacklist = false;
     flat_set<string> _op_list;
     golos::chain::database &database_;
+
+    bool _use_archive = false;
+    uint32_t _max_archive_ops_per_block = 10000;
+    history_archive _archive;
 };
 
 
@@ -347,6 +531,8 @@ void plugin::set_program_options(
          ("history-whitelist-ops", boost::program_options::value< vector< string > >()->composing(), "Defines a list of operations which will be explicitly logged.")
          ("history-blacklist-ops", boost::program_options::value< vector< string > >()->composing(), "Defines a list of operations which will be explicitly ignored.")
          ("history-start-block", boost::program_options::value<uint32_t>()->composing(), "Defines starting block from which recording stats.")
+         ("history-archive", boost::program_options::value<bool>()->default_value(false), "Move history of irreversible blocks from the shared memory to append-only files.")
+         ("history-archive-dir", boost::program_options::value<boost::filesystem::path>()->default_value("account-history"), "The location of the account history archive (absolute path or relative to application data dir).")
          ;
     cfg.add(cli);
 }
@@ -355,7 +541,10 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
     ilog("account_history plugin: plugin_initialize() begin");
     my.reset(new plugin_impl);
     // auto & tmp_db_ref = appbase::app().get_plugin<chain::plugin>().db();
+    // not a block consumer: history objects are created in the undo session of the operation,
+    // so they are popped with the block, and the API reads them consistently with the chain state
     my->database().pre_apply_operation.connect([&](const golos::chain::operation_notification &note) { my->on_operation(note); });
+    golos::chain::add_plugin_index<account_operation_index>(my->database());
 
     typedef pair<string, string> pairstring;
     LOAD_VALUE_SET(options, "track-account-range", my->_tracked_accounts, pairstring);
@@ -400,6 +589,18 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
         my->_start_block = 0;
     }
     ilog("Account History: start_block ${s}", ("s", my->_start_block));
+
+    my->_use_archive = options.at("history-archive").as<bool>();
+    if (my->_use_archive) {
+        auto dir = options.at("history-archive-dir").as<boost::filesystem::path>();
+        if (dir.is_relative()) {
+            dir = appbase::app().data_dir() / dir;
+        }
+        // the archive must be ready before the chain plugin starts a replay
+        my->_archive.open(dir);
+        // archived operations are removed from chainbase, which needs the write lock held by the block apply
+        my->database().applied_block.connect([&](const signed_block &block) { my->on_applied_block(block); });
+    }
     ilog("account_history plugin: plugin_initialize() end");
     // init(options);
 }
@@ -415,8 +616,31 @@ void plugin::plugin_startup() {
     ilog("account_history plugin: plugin_startup() end");
 }
 
+void plugin::plugin_shutdown() {
+    if (my) {
+        my->_archive.close();
+    }
+}
+
 flat_map<string, string> plugin::tracked_accounts() const {
     return my->_tracked_accounts;
 }
 
+bool plugin::is_archive_enabled() const {
+    // the plugin may be registered, but not enabled
+    return my && my->_use_archive;
+}
+
+std::map<uint32_t, archived_operation> plugin::get_account_history(
+    const std::string &account, uint64_t from, uint32_t limit
+) const {
+    return my->get_account_history(account, from, limit);
+}
+
+std::map<uint32_t, archived_operation> plugin::get_account_history(
+    const std::string &account, uint64_t from, uint32_t limit, uint64_t op_mask
+) const {
+    return my->get_account_history(account, from, limit, op_mask);
+}
+
 } } } // golos::plugins::account_history
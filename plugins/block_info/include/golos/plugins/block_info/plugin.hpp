@@ -58,7 +58,6 @@ public:
             (get_block_info)
             (get_blocks_with_info)
     )
-    void on_applied_block(const protocol::signed_block &b);
 
 private:
     struct plugin_impl;
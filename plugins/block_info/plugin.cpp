@@ -6,6 +6,8 @@
 #include <golos/plugins/json_rpc/utility.hpp>
 #include <golos/plugins/json_rpc/plugin.hpp>
 
+#include <mutex>
+
 namespace golos {
 namespace plugins {
 namespace block_info {
@@ -26,15 +28,15 @@ public:
         uint32_t count = 1000);
 
     // PLUGIN_METHODS
-    void on_applied_block(const protocol::signed_block &b);
+    void on_block(const chain::applied_block_notification &b);
 
     // HELPING METHODS
     golos::chain::database &database() {
         return db_;
     }
-// protected:
-    boost::signals2::scoped_connection applied_block_conn_;
 private:
+    // filled by the block consumer, which can run on its own thread
+    std::mutex block_info_mutex_;
     std::vector<block_info> block_info_;
 
     golos::chain::database & db_;
@@ -45,6 +47,7 @@ std::vector<block_info> plugin::plugin_impl::get_block_info(uint32_t start_block
 
     FC_ASSERT(start_block_num > 0);
     FC_ASSERT(count <= 10000);
+    std::lock_guard<std::mutex> lock(block_info_mutex_);
     uint32_t n = std::min(uint32_t(block_info_.size()),
     start_block_num + count);
 
@@ -63,6 +66,7 @@ std::vector<block_with_info> plugin::plugin_impl::get_blocks_with_info(
 
     FC_ASSERT(start_block_num > 0);
     FC_ASSERT(count <= 10000);
+    std::lock_guard<std::mutex> lock(block_info_mutex_);
     uint32_t n = std::min( uint32_t( block_info_.size() ), start_block_num + count );
 
     uint64_t total_size = 0;
@@ -83,19 +87,23 @@ std::vector<block_with_info> plugin::plugin_impl::get_blocks_with_info(
     return result;
 }
 
-void plugin::plugin_impl::on_applied_block(const protocol::signed_block &b) {
-    uint32_t block_num = b.block_num();
-    const auto &db = appbase::app().get_plugin<chain::plugin>().db();
+void plugin::plugin_impl::on_block(const chain::applied_block_notification &b) {
+    uint32_t block_num = b.block_num;
+    std::lock_guard<std::mutex> lock(block_info_mutex_);
 
+    // a block with a lower number comes after a fork switch, the later blocks were popped
+    if (block_num < block_info_.size()) {
+        block_info_.resize(block_num + 1);
+    }
     while (block_num >= block_info_.size()) {
         block_info_.emplace_back();
     }
 
     block_info &info = block_info_[block_num];
-    const dynamic_global_property_object &dgpo = db.get_dynamic_global_properties();
+    const dynamic_global_property_object &dgpo = b.props;
 
-    info.block_id = b.id();
-    info.block_size = fc::raw::pack_size(b);
+    info.block_id = b.block_id;
+    info.block_size = b.block_size;
     info.average_block_size = dgpo.average_block_size;
     info.aslot = dgpo.current_aslot;
     info.last_irreversible_block_num = dgpo.last_irreversible_block_num;
@@ -121,11 +129,6 @@ DEFINE_API ( plugin, get_blocks_with_info ) {
     });
 }
 
-void plugin::on_applied_block(const protocol::signed_block &b) {
-    return my->on_applied_block(b);
-}
-
-
 plugin::plugin() {
 }
 
@@ -134,12 +137,10 @@ plugin::~plugin() {
 
 void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
 
-    auto &db = appbase::app().get_plugin<chain::plugin>().db();
-
     my.reset(new plugin_impl);
 
-    my->applied_block_conn_ = db.applied_block.connect([this](const protocol::signed_block &b) {
-        on_applied_block(b);
+    appbase::app().get_plugin<chain::plugin>().add_block_consumer(name(), [&](const chain::applied_block_notification &b) {
+        my->on_block(b);
     });
 
     JSON_RPC_REGISTER_API ( name() ) ;
@@ -0,0 +1,154 @@
+#include <golos/plugins/chain/block_consumer.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+
+namespace golos {
+namespace plugins {
+namespace chain {
+
+    block_consumer::block_consumer(std::string name, block_consumer_handler handler, uint32_t max_queue_size)
+            : _name(std::move(name)),
+              _handler(std::move(handler)),
+              _max_queue_size(std::max<uint32_t>(max_queue_size, 1)),
+              _thread([this]() { run(); }) {
+    }
+
+    block_consumer::~block_consumer() {
+        stop();
+    }
+
+    static thread_local bool consumer_thread = false;
+
+    bool block_consumer::in_consumer_thread() {
+        return consumer_thread;
+    }
+
+    void block_consumer::push(std::shared_ptr<const applied_block_notification> block) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_stopped) {
+            return;
+        }
+        _queue.push_back(std::move(block));
+        _pushed.notify_one();
+    }
+
+    void block_consumer::wait_for_capacity() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _popped.wait(lock, [&]() {
+            return _queue.size() < _max_queue_size || _stopped;
+        });
+    }
+
+    void block_consumer::wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _popped.wait(lock, [&]() {
+            return _queue.empty() && !_busy;
+        });
+    }
+
+    void block_consumer::stop() {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_stopped) {
+                return;
+            }
+            _stopped = true;
+            _pushed.notify_one();
+            _popped.notify_all();
+        }
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    void block_consumer::run() {
+        consumer_thread = true;
+        while (true) {
+            std::shared_ptr<const applied_block_notification> block;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _pushed.wait(lock, [&]() {
+                    return !_queue.empty() || _stopped;
+                });
+                // the queue is drained before stopping
+                if (_queue.empty()) {
+                    return;
+                }
+                block = std::move(_queue.front());
+                _queue.pop_front();
+                _busy = true;
+            }
+
+            try {
+                _handler(*block);
+            } catch (const fc::exception &e) {
+                elog("Block consumer ${n} failed on block ${b}: ${e}", ("n", _name)("b", block->block_num)("e", e.to_detail_string()));
+            } catch (const std::exception &e) {
+                elog("Block consumer ${n} failed on block ${b}: ${e}", ("n", _name)("b", block->block_num)("e", e.what()));
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _busy = false;
+                _popped.notify_all();
+            }
+        }
+    }
+
+    block_consumer_set::~block_consumer_set() {
+        stop();
+    }
+
+    void block_consumer_set::add(std::string name, block_consumer_handler handler) {
+        FC_ASSERT(!started(), "Block consumer ${n} is added after the consumers were started", ("n", name));
+        _handlers.emplace_back(std::move(name), std::move(handler));
+    }
+
+    void block_consumer_set::start(uint32_t max_queue_size) {
+        for (const auto &handler: _handlers) {
+            _consumers.emplace_back(new block_consumer(handler.first, handler.second, max_queue_size));
+        }
+    }
+
+    void block_consumer_set::notify(std::shared_ptr<const applied_block_notification> block, bool synchronous) {
+        if (started() && !synchronous) {
+            for (auto &consumer: _consumers) {
+                consumer->push(block);
+            }
+            return;
+        }
+
+        // the blocks pushed before are processed first to keep the order
+        wait();
+        for (const auto &handler: _handlers) {
+            try {
+                handler.second(*block);
+            } FC_CAPTURE_AND_LOG((handler.first)(block->block_num))
+        }
+    }
+
+    void block_consumer_set::wait_for_capacity() {
+        for (auto &consumer: _consumers) {
+            consumer->wait_for_capacity();
+        }
+    }
+
+    void block_consumer_set::wait() {
+        for (auto &consumer: _consumers) {
+            consumer->wait();
+        }
+    }
+
+    void block_consumer_set::stop() {
+        for (auto &consumer: _consumers) {
+            consumer->stop();
+        }
+        _consumers.clear();
+    }
+
+}
+}
+} // golos::plugins::chain
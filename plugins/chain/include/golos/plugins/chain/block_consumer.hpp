@@ -0,0 +1,147 @@
+#pragma once
+
+#include <golos/chain/global_property_object.hpp>
+#include <golos/protocol/operations.hpp>
+#include <golos/protocol/types.hpp>
+
+#include <fc/time.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace golos {
+    namespace plugins {
+        namespace chain {
+
+            /**
+             *  Copy of an operation notification, which outlives the apply of the block
+             */
+            struct applied_operation_notification {
+                protocol::transaction_id_type trx_id;
+                uint32_t block = 0;
+                uint32_t trx_in_block = 0;
+                uint16_t op_in_trx = 0;
+                uint64_t virtual_op = 0;
+                protocol::operation op;
+            };
+
+            /**
+             *  Operations of an applied block in the order they were applied.
+             *
+             *  Blocks come in the order of apply, so after a fork switch the blocks of the new branch
+             *  come again with the same numbers as the blocks of the popped branch. A consumer should
+             *  replace the data of such blocks and treat only blocks up to last_irreversible_block as final.
+             */
+            struct applied_block_notification {
+                uint32_t block_num = 0;
+                protocol::block_id_type block_id;
+                fc::time_point_sec timestamp;
+                uint32_t block_size = 0;
+                uint32_t last_irreversible_block = 0;
+                /// global properties right after the block was applied
+                golos::chain::dynamic_global_property_object props;
+                std::vector<applied_operation_notification> operations;
+            };
+
+            using block_consumer_handler = std::function<void(const applied_block_notification &)>;
+
+            /**
+             *  Runs a handler of applied blocks on its own thread, in the order of blocks.
+             *
+             *  push() is called under the write lock and doesn't block, as the handler may wait
+             *  for a read lock. Instead the writer calls wait_for_capacity() after releasing the lock,
+             *  so a slow consumer slows down the block apply instead of growing the queue.
+             */
+            class block_consumer final {
+            public:
+                block_consumer(std::string name, block_consumer_handler handler, uint32_t max_queue_size);
+
+                ~block_consumer();
+
+                const std::string &name() const {
+                    return _name;
+                }
+
+                void push(std::shared_ptr<const applied_block_notification> block);
+
+                /// Waits while max_queue_size blocks are waiting
+                void wait_for_capacity();
+
+                /// Waits until all pushed blocks are processed
+                void wait();
+
+                /// Processes the pushed blocks and stops the thread
+                void stop();
+
+                /// The caller is a thread of a block consumer, it should take a read lock to access the chain state
+                static bool in_consumer_thread();
+
+            private:
+                void run();
+
+                std::string _name;
+                block_consumer_handler _handler;
+                uint32_t _max_queue_size;
+
+                std::mutex _mutex;
+                std::condition_variable _pushed;
+                std::condition_variable _popped;
+                std::deque<std::shared_ptr<const applied_block_notification>> _queue;
+                bool _busy = false;
+                bool _stopped = false;
+
+                std::thread _thread;
+            };
+
+            /**
+             *  Block consumers of all plugins.
+             *
+             *  Until start() is called the handlers are called by notify() on the caller's thread,
+             *  so plugins get all blocks even if the consumers never run on their own threads.
+             */
+            class block_consumer_set final {
+            public:
+                ~block_consumer_set();
+
+                void add(std::string name, block_consumer_handler handler);
+
+                bool empty() const {
+                    return _handlers.empty();
+                }
+
+                /// Starts a thread for each consumer
+                void start(uint32_t max_queue_size);
+
+                bool started() const {
+                    return !_consumers.empty();
+                }
+
+                /**
+                 *  Pushes the block to the threads of consumers. With synchronous set or before start()
+                 *  it waits for the pushed blocks and calls the handlers itself.
+                 */
+                void notify(std::shared_ptr<const applied_block_notification> block, bool synchronous);
+
+                /// Waits while one of consumers has max_queue_size blocks waiting
+                void wait_for_capacity();
+
+                /// Waits until all consumers have processed all pushed blocks
+                void wait();
+
+                /// Processes the pushed blocks and stops the threads, the handlers are called synchronously after it
+                void stop();
+
+            private:
+                std::vector<std::pair<std::string, block_consumer_handler>> _handlers;
+                std::vector<std::unique_ptr<block_consumer>> _consumers;
+            };
+
+        }
+    }
+} // golos::plugins::chain
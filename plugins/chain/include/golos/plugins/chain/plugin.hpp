@@ -6,6 +6,7 @@
 #include <golos/protocol/types.hpp>
 #include <golos/chain/database.hpp>
 #include <golos/protocol/block.hpp>
+#include <golos/plugins/chain/block_consumer.hpp>
 
 #include <golos/plugins/json_rpc/utility.hpp>
 #include <golos/plugins/json_rpc/plugin.hpp>
@@ -85,6 +86,32 @@ namespace golos {
 
                 const golos::chain::database &db() const;
 
+                /**
+                 *  Registers a consumer of operations of applied blocks for a plugin, which doesn't modify
+                 *  the chain state. With plugin-notification-threads enabled each consumer runs on its own
+                 *  thread, otherwise it's called on the write thread after the block is applied.
+                 *  Should be called in plugin_initialize().
+                 */
+                void add_block_consumer(const std::string &name, block_consumer_handler handler);
+
+                /// Consumers run on their own threads, so they should take a read lock to access the chain state
+                bool async_block_consumers() const;
+
+                /// Waits until all consumers have processed all applied blocks
+                void wait_block_consumers();
+
+                /**
+                 *  Waits while a consumer has plugin-notification-queue-size blocks waiting.
+                 *  Should be called after each applied block out of the write lock
+                 *  by a caller, which applies blocks not through accept_block() or generate_block().
+                 */
+                void wait_block_consumers_capacity();
+
+                /// Generates a block like database::generate_block() and waits for capacity of block consumers
+                protocol::signed_block generate_block(
+                    fc::time_point_sec when, const protocol::account_name_type &witness_owner,
+                    const fc::ecc::private_key &block_signing_private_key, uint32_t skip = 0);
+
                 // Emitted when the blockchain is syncing/live.
                 // This is to synchronize plugins that have the chain plugin as an optional dependency.
                 boost::signals2::signal<void()> on_sync;
@@ -9,6 +9,9 @@
 #include <golos/protocol/protocol.hpp>
 #include <golos/protocol/types.hpp>
 #include <future>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
 
 namespace golos {
 namespace plugins {
@@ -48,10 +51,38 @@ namespace chain {
 
         bool skip_virtual_ops = false;
 
+        bool store_virtual_operations = false;
+
+        boost::filesystem::path import_blocks_path;
+
         golos::chain::database db;
 
         bool single_write_thread = false;
 
+        bool async_block_consumers = false;
+        uint32_t block_consumer_queue_size = 100;
+        block_consumer_set block_consumers;
+        std::shared_ptr<applied_block_notification> current_block;
+        bool replaying = false;
+
+        void connect_block_consumers();
+
+        void start_block_consumers();
+
+        void stop_block_consumers();
+
+        void on_pre_apply_block(const protocol::signed_block &block);
+
+        void on_operation(const golos::chain::operation_notification &note);
+
+        void on_applied_block(const protocol::signed_block &block);
+
+        void wait_block_consumers_capacity();
+
+        void reindex(const boost::filesystem::path &data_dir);
+
+        void import_blocks();
+
         plugin_impl() {
             // get default settings
             read_wait_micro = db.read_wait_micro();
@@ -89,6 +120,113 @@ namespace chain {
         FC_ASSERT(block.timestamp.sec_since_epoch() <= max_accept_time);
     }
 
+    void plugin::plugin_impl::start_block_consumers() {
+        if (block_consumers.empty()) {
+            return;
+        }
+
+        if (async_block_consumers) {
+            block_consumers.start(block_consumer_queue_size);
+        }
+
+        ilog("Started block consumers${t}", ("t", async_block_consumers ? " on their own threads" : ""));
+    }
+
+    void plugin::plugin_impl::connect_block_consumers() {
+        db.pre_apply_block.connect([&](const protocol::signed_block &block) {
+            on_pre_apply_block(block);
+        });
+        db.post_apply_operation.connect([&](const golos::chain::operation_notification &note) {
+            on_operation(note);
+        });
+        db.applied_block.connect([&](const protocol::signed_block &block) {
+            on_applied_block(block);
+        });
+    }
+
+    void plugin::plugin_impl::stop_block_consumers() {
+        block_consumers.stop();
+    }
+
+    void plugin::plugin_impl::on_pre_apply_block(const protocol::signed_block &block) {
+        // operations of a block, which failed to apply, are dropped here
+        current_block = std::make_shared<applied_block_notification>();
+        current_block->block_num = block.block_num();
+        current_block->timestamp = block.timestamp;
+    }
+
+    void plugin::plugin_impl::on_operation(const golos::chain::operation_notification &note) {
+        // operations of pending transactions come outside of blocks
+        if (!current_block) {
+            return;
+        }
+        applied_operation_notification item;
+        item.trx_id = note.trx_id;
+        item.block = note.block;
+        item.trx_in_block = note.trx_in_block;
+        item.op_in_trx = note.op_in_trx;
+        item.virtual_op = note.virtual_op;
+        item.op = note.op;
+        current_block->operations.push_back(std::move(item));
+    }
+
+    void plugin::plugin_impl::on_applied_block(const protocol::signed_block &block) {
+        if (!current_block) {
+            return;
+        }
+        current_block->block_id = block.id();
+        current_block->block_size = fc::raw::pack_size(block);
+        current_block->last_irreversible_block = db.last_non_undoable_block_num();
+        current_block->props = db.get_dynamic_global_properties();
+        std::shared_ptr<const applied_block_notification> notification = std::move(current_block);
+
+        // the replay holds the write lock all the time, so consumers can't read the state on their threads
+        block_consumers.notify(std::move(notification), replaying);
+    }
+
+    void plugin::plugin_impl::wait_block_consumers_capacity() {
+        block_consumers.wait_for_capacity();
+    }
+
+    void plugin::plugin_impl::reindex(const boost::filesystem::path &data_dir) {
+        replaying = true;
+        try {
+            db.reindex(data_dir, shared_memory_dir, shared_memory_size);
+        } catch (...) {
+            replaying = false;
+            throw;
+        }
+        replaying = false;
+    }
+
+    void plugin::plugin_impl::import_blocks() {
+        std::vector<boost::filesystem::path> files;
+        if (boost::filesystem::is_directory(import_blocks_path)) {
+            // block logs of the directory are imported by names, each continues from the head of the chain
+            for (boost::filesystem::directory_iterator itr(import_blocks_path), end; itr != end; ++itr) {
+                if (boost::filesystem::is_regular_file(itr->path()) && itr->path().extension() != ".index") {
+                    files.push_back(itr->path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+        } else {
+            FC_ASSERT(boost::filesystem::exists(import_blocks_path),
+                      "Block file ${f} doesn't exist", ("f", import_blocks_path.string()));
+            files.push_back(import_blocks_path);
+        }
+
+        replaying = true;
+        try {
+            for (const auto &file: files) {
+                db.import_blocks(file);
+            }
+        } catch (...) {
+            replaying = false;
+            throw;
+        }
+        replaying = false;
+    }
+
     bool plugin::plugin_impl::accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip) {
         if (currently_syncing && block.block_num() % 10000 == 0) {
             ilog("Syncing Blockchain --- Got block: #${n} time: ${t} producer: ${p}",
@@ -99,9 +237,10 @@ namespace chain {
 
         skip = db.validate_block(block, skip);
 
+        bool result;
         if (single_write_thread) {
             std::promise<bool> promise;
-            auto result = promise.get_future();
+            auto future = promise.get_future();
 
             io_service().post([&]{
                 try {
@@ -110,10 +249,14 @@ namespace chain {
                     promise.set_exception(std::current_exception());
                 }
             });
-            return result.get(); // if an exception was, it will be thrown
+            result = future.get(); // if an exception was, it will be thrown
         } else {
-            return db.push_block(block, skip);
+            result = db.push_block(block, skip);
         }
+
+        // backpressure of block consumers, out of the write lock
+        wait_block_consumers_capacity();
+        return result;
     }
 
     void plugin::plugin_impl::accept_transaction(const protocol::signed_transaction &trx) {
@@ -196,9 +339,19 @@ namespace chain {
             ) (
                 "skip-virtual-ops", boost::program_options::value<bool>()->default_value(false),
                 "virtual operations will not be passed to the plugins, helps to save some memory"
+            ) (
+                "store-virtual-operations", boost::program_options::value<bool>()->default_value(false),
+                "write virtual operations of irreversible blocks to the virtual_op_log file next to the block_log, "
+                "a replay is needed to fill it for already applied blocks"
             ) (
                 "enable-plugins-on-push-transaction", boost::program_options::value<bool>()->default_value(true),
                 "enable calling of plugins for operations on push_transaction"
+            ) (
+                "plugin-notification-threads", boost::program_options::value<bool>()->default_value(false),
+                "run block consumers of plugins, which don't modify the chain state, on their own threads"
+            ) (
+                "plugin-notification-queue-size", boost::program_options::value<uint32_t>()->default_value(100),
+                "maximum number of blocks waiting for a block consumer, block apply waits when it is reached"
             );
         cli.add_options()
             (
@@ -207,6 +360,10 @@ namespace chain {
             ) (
                 "resync-blockchain", boost::program_options::bool_switch()->default_value(false),
                 "clear chain database and block log"
+            ) (
+                "import-blocks", boost::program_options::value<boost::filesystem::path>(),
+                "apply blocks from a block_log file or from a directory of block_log files, checking signatures, "
+                "before connecting to the network"
             ) (
                 "check-locks", boost::program_options::bool_switch()->default_value(false),
                 "Check correctness of chainbase locking"
@@ -247,11 +404,17 @@ namespace chain {
 
         my->enable_plugins_on_push_transaction = options.at("enable-plugins-on-push-transaction").as<bool>();
 
+        my->async_block_consumers = options.at("plugin-notification-threads").as<bool>();
+        my->block_consumer_queue_size = options.at("plugin-notification-queue-size").as<uint32_t>();
+
         my->shared_memory_size = fc::parse_size(options.at("shared-file-size").as<std::string>());
         my->inc_shared_memory_size = fc::parse_size(options.at("inc-shared-file-size").as<std::string>());
         my->min_free_shared_memory_size = fc::parse_size(options.at("min-free-shared-file-size").as<std::string>());
         my->clear_votes_before_block = options.at("clear-votes-before-block").as<uint32_t>();
         my->skip_virtual_ops = options.at("skip-virtual-ops").as<bool>();
+        my->store_virtual_operations = options.at("store-virtual-operations").as<bool>();
+        FC_ASSERT(!my->skip_virtual_ops || !my->store_virtual_operations,
+                  "Virtual operations can't be stored when they are skipped");
 
         if (options.count("block-num-check-free-size")) {
             my->block_num_check_free_size = options.at("block-num-check-free-size").as<uint32_t>();
@@ -260,6 +423,9 @@ namespace chain {
         my->replay = options.at("replay-blockchain").as<bool>();
         my->resync = options.at("resync-blockchain").as<bool>();
         my->check_locks = options.at("check-locks").as<bool>();
+        if (options.count("import-blocks")) {
+            my->import_blocks_path = options.at("import-blocks").as<boost::filesystem::path>();
+        }
         my->validate_invariants = options.at("validate-database-invariants").as<bool>();
         if (options.count("flush-state-interval")) {
             my->flush_interval = options.at("flush-state-interval").as<uint32_t>();
@@ -305,15 +471,19 @@ namespace chain {
             my->db.set_skip_virtual_ops();
         }
 
+        my->db.set_store_virtual_operations(my->store_virtual_operations);
+
         if (my->block_num_check_free_size) {
             my->db.set_block_num_check_free_size(my->block_num_check_free_size);
         }
 
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
 
+        my->start_block_consumers();
+
         if (my->replay) {
             ilog("Replaying blockchain on user request.");
-            my->db.reindex(data_dir, my->shared_memory_dir, my->shared_memory_size);
+            my->reindex(data_dir);
         } else {
             try {
                 ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
@@ -322,7 +492,7 @@ namespace chain {
                 wlog("Error opening database, attempting to replay blockchain. Error: ${e}", ("e", e));
 
                 try {
-                    my->db.reindex(data_dir, my->shared_memory_dir, my->shared_memory_size);
+                    my->reindex(data_dir);
                 } catch (golos::chain::block_log &) {
                     wlog("Error opening block log. Having to resync from network...");
                     my->db.open(data_dir, my->shared_memory_dir, STEEMIT_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/ );
@@ -330,16 +500,51 @@ namespace chain {
             }
         }
 
+        if (!my->import_blocks_path.empty()) {
+            my->import_blocks();
+        }
+
         ilog("Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()));
         on_sync();
     }
 
     void plugin::plugin_shutdown() {
+        my->stop_block_consumers();
         ilog("closing chain database");
         my->db.close();
         ilog("database closed successfully");
     }
 
+    void plugin::add_block_consumer(const std::string &name, block_consumer_handler handler) {
+        // consumers are called synchronously until their threads are started in plugin_startup()
+        if (my->block_consumers.empty()) {
+            my->connect_block_consumers();
+        }
+        my->block_consumers.add(name, std::move(handler));
+    }
+
+    bool plugin::async_block_consumers() const {
+        return my->async_block_consumers;
+    }
+
+    void plugin::wait_block_consumers() {
+        my->block_consumers.wait();
+    }
+
+    void plugin::wait_block_consumers_capacity() {
+        my->wait_block_consumers_capacity();
+    }
+
+    protocol::signed_block plugin::generate_block(
+        fc::time_point_sec when, const protocol::account_name_type &witness_owner,
+        const fc::ecc::private_key &block_signing_private_key, uint32_t skip
+    ) {
+        auto block = my->db.generate_block(when, witness_owner, block_signing_private_key, skip);
+        // backpressure of block consumers, out of the write lock
+        my->wait_block_consumers_capacity();
+        return block;
+    }
+
     bool plugin::accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip) {
         return my->accept_block(block, currently_syncing, skip);
     }
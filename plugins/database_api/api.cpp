@@ -1,17 +1,26 @@
 #include <golos/plugins/database_api/plugin.hpp>
+#include <golos/plugins/database_api/witness_votes_object.hpp>
 
 //#include <golos/plugins/tags/tags_plugin.hpp>
 
 #include <golos/protocol/get_config.hpp>
+#include <golos/chain/index.hpp>
+#include <golos/chain/operation_notification.hpp>
 
 #include <fc/bloom_filter.hpp>
 #include <fc/smart_ref_impl.hpp>
 
 #include <boost/range/iterator_range.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/thread/thread.hpp>
+#include <future>
 #include <memory>
+#include <tuple>
 #include <golos/plugins/json_rpc/plugin.hpp>
 #include <golos/plugins/follow/plugin.hpp>
+#include <golos/plugins/account_history/plugin.hpp>
+#include <golos/plugins/transaction_lookup/plugin.hpp>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -58,6 +67,8 @@ namespace golos {
 
                 void startup() {
                     _follow_api = appbase::app().find_plugin<golos::plugins::follow::plugin>();
+                    _account_history = appbase::app().find_plugin<golos::plugins::account_history::plugin>();
+                    _transaction_lookup = appbase::app().find_plugin<golos::plugins::transaction_lookup::plugin>();
                 }
 
                 // Subscriptions
@@ -78,6 +89,8 @@ namespace golos {
 
                 std::vector<applied_operation> get_ops_in_block(uint32_t block_num, bool only_virtual) const;
 
+                std::vector<applied_operation> get_virtual_ops_in_range(uint32_t from_block, uint32_t block_count) const;
+
                 // Globals
                 fc::variant_object get_config() const;
 
@@ -116,7 +129,7 @@ namespace golos {
 
                 std::vector<withdraw_route> get_withdraw_routes(std::string account, withdraw_route_type type) const;
 
-                std::map<uint32_t, applied_operation> get_account_history(std::string account, uint64_t from, uint32_t limit) const;
+                std::map<uint32_t, applied_operation> get_account_history(std::string account, uint64_t from, uint32_t limit, uint64_t op_mask) const;
 
                 std::vector<witness_api_object> get_witnesses_by_vote(std::string from, uint32_t limit) const;
 
@@ -174,10 +187,40 @@ namespace golos {
                 block_applied_callback_info::cont active_block_applied_callback;
                 block_applied_callback_info::cont free_block_applied_callback;
 
+                uint32_t get_accounts_threads = 1;
+
+                // workers assembling parts of big get_accounts requests, the calling thread assembles one part too
+                void start_accounts_workers();
+
+                void stop_accounts_workers();
+
+                mutable boost::asio::io_service accounts_ios;
+                std::unique_ptr<boost::asio::io_service::work> accounts_work;
+                boost::thread_group accounts_threads;
+
+                // Witness votes of accounts
+                void update_witness_votes(const account_name_type &account);
+
+                void rebuild_witness_votes();
+
+                void on_pre_apply_block(const signed_block &block);
+
+                void on_applied_block(const signed_block &block);
+
+                void on_post_apply_operation(const operation_notification &note);
+
+                struct witness_votes_visitor;
+
+                // accounts whose declines of voting rights become effective in the applying block
+                std::vector<account_name_type> declining_accounts;
+
             private:
 
                 golos::chain::database &_db;
                 golos::plugins::follow::plugin *_follow_api = nullptr;
+
+                golos::plugins::account_history::plugin *_account_history = nullptr;
+                golos::plugins::transaction_lookup::plugin *_transaction_lookup = nullptr;
             };
 
 
@@ -251,6 +294,25 @@ namespace golos {
 
             plugin::api_impl::~api_impl() {
                 elog("freeing database plugin ${x}", ("x", int64_t(this)));
+                stop_accounts_workers();
+            }
+
+            void plugin::api_impl::start_accounts_workers() {
+                if (get_accounts_threads <= 1) {
+                    return;
+                }
+                accounts_work.reset(new boost::asio::io_service::work(accounts_ios));
+                for (uint32_t i = 1; i < get_accounts_threads; ++i) {
+                    accounts_threads.create_thread([this]() {
+                        accounts_ios.run();
+                    });
+                }
+            }
+
+            void plugin::api_impl::stop_accounts_workers() {
+                accounts_work.reset();
+                accounts_ios.stop();
+                accounts_threads.join_all();
             }
 
             //////////////////////////////////////////////////////////////////////
@@ -306,6 +368,108 @@ namespace golos {
                     }
                     ++itr;
                 }
+                if (!result.empty()) {
+                    return result;
+                }
+
+                // operations aren't kept in the state, so they are restored from the block
+                // and virtual operations stored while it was applied
+                auto virtual_ops = _db.fetch_virtual_operations_by_number(block_num);
+                if (!virtual_ops) {
+                    return result;
+                }
+                auto block = _db.fetch_block_by_number(block_num);
+                if (!block) {
+                    return result;
+                }
+
+                temp.block = block_num;
+                temp.timestamp = block->timestamp;
+                auto vitr = virtual_ops->operations.begin();
+                auto push_virtual_ops = [&](uint32_t trx_in_block, uint16_t op_in_trx) {
+                    for (; vitr != virtual_ops->operations.end() &&
+                           std::tie(vitr->trx_in_block, vitr->op_in_trx) <= std::tie(trx_in_block, op_in_trx); ++vitr) {
+                        temp.trx_id = vitr->trx_in_block < block->transactions.size()
+                                      ? block->transactions[vitr->trx_in_block].id()
+                                      : transaction_id_type();
+                        temp.trx_in_block = vitr->trx_in_block;
+                        temp.op_in_trx = vitr->op_in_trx;
+                        temp.virtual_op = (vitr - virtual_ops->operations.begin()) + 1;
+                        temp.op = vitr->op;
+                        result.push_back(temp);
+                    }
+                };
+
+                for (uint32_t trx_in_block = 0; trx_in_block < block->transactions.size(); ++trx_in_block) {
+                    const auto &trx = block->transactions[trx_in_block];
+                    const auto trx_id = trx.id();
+                    for (uint16_t op_in_trx = 0; op_in_trx < trx.operations.size(); ++op_in_trx) {
+                        if (!only_virtual) {
+                            temp.trx_id = trx_id;
+                            temp.trx_in_block = trx_in_block;
+                            temp.op_in_trx = op_in_trx;
+                            temp.virtual_op = 0;
+                            temp.op = trx.operations[op_in_trx];
+                            result.push_back(temp);
+                        }
+                        // virtual operations caused by the operation
+                        push_virtual_ops(trx_in_block, op_in_trx);
+                    }
+                }
+                push_virtual_ops(uint32_t(-1), uint16_t(-1));
+                return result;
+            }
+
+            DEFINE_API(plugin, get_virtual_ops_in_range) {
+                CHECK_ARG_SIZE(2)
+                auto from_block = args.args->at(0).as<uint32_t>();
+                auto block_count = args.args->at(1).as<uint32_t>();
+                return my->database().with_weak_read_lock([&]() {
+                    return my->get_virtual_ops_in_range(from_block, block_count);
+                });
+            }
+
+            std::vector<applied_operation> plugin::api_impl::get_virtual_ops_in_range(
+                uint32_t from_block, uint32_t block_count
+            ) const {
+                FC_ASSERT(block_count <= 1000);
+                FC_ASSERT(_db.store_virtual_operations(), "Virtual operations aren't stored, enable store-virtual-operations");
+                auto first_stored = _db.first_stored_virtual_operations_block();
+                FC_ASSERT(from_block >= first_stored,
+                    "Virtual operations are stored from block ${first}", ("first", first_stored));
+                std::vector<applied_operation> result;
+                if (block_count == 0) {
+                    return result;
+                }
+
+                auto blocks = _db.fetch_virtual_operations_in_range(
+                    from_block, from_block + std::min(block_count - 1, uint32_t(-1) - from_block));
+
+                applied_operation temp;
+                for (const auto &b: blocks) {
+                    if (b.operations.empty()) {
+                        continue;
+                    }
+                    // the block gives the timestamp and ids of transactions which caused virtual operations
+                    auto block = _db.fetch_block_by_number(b.block_num);
+                    if (!block) {
+                        continue;
+                    }
+                    temp.block = b.block_num;
+                    temp.timestamp = block->timestamp;
+                    temp.virtual_op = 0;
+                    for (const auto &vop: b.operations) {
+                        temp.trx_id = vop.trx_in_block < block->transactions.size()
+                                      ? block->transactions[vop.trx_in_block].id()
+                                      : transaction_id_type();
+                        temp.trx_in_block = vop.trx_in_block;
+                        temp.op_in_trx = vop.op_in_trx;
+                        // virtual operations are numbered from 1 in the order of the block
+                        ++temp.virtual_op;
+                        temp.op = vop.op;
+                        result.push_back(temp);
+                    }
+                }
                 return result;
             }
 
@@ -427,26 +591,205 @@ namespace golos {
 
             std::vector<extended_account> plugin::api_impl::get_accounts(std::vector<std::string> names) const {
                 const auto &idx = _db.get_index<account_index>().indices().get<by_name>();
-                const auto &vidx = _db.get_index<witness_vote_index>().indices().get<by_account_witness>();
-                std::vector<extended_account> results;
-
-                for (auto name: names) {
+                const auto &vidx = _db.get_index<account_witness_votes_index>().indices().get<by_account>();
+
+                // accounts are looked up in the order of names for locality of the index,
+                // and each of repeated names is looked up once. Reputations aren't cached between calls:
+                // they change with votes of pending transactions as well as of blocks, and a lookup
+                // in the reputation index costs the same as in a cache, which would also need a lock.
+                std::vector<account_name_type> sorted_names(names.begin(), names.end());
+                std::sort(sorted_names.begin(), sorted_names.end());
+                sorted_names.erase(std::unique(sorted_names.begin(), sorted_names.end()), sorted_names.end());
+
+                std::vector<account_name_type> found_names;
+                std::vector<const account_object *> accounts;
+                std::vector<share_type> reputations;
+                for (const auto &name: sorted_names) {
                     auto itr = idx.find(name);
                     if (itr != idx.end()) {
-                        results.push_back(extended_account(*itr, _db));
-                        results.back().reputation = get_account_reputation(name);
-                        auto vitr = vidx.lower_bound(boost::make_tuple(itr->id, witness_id_type()));
-                        while (vitr != vidx.end() && vitr->account == itr->id) {
-                            results.back().witness_votes.insert(_db.get(vitr->witness).owner);
-                            ++vitr;
+                        found_names.push_back(name);
+                        accounts.push_back(&*itr);
+                        reputations.push_back(get_account_reputation(name));
+                    }
+                }
+
+                auto assemble = [&](size_t begin, size_t end) {
+                    std::vector<extended_account> result;
+                    result.reserve(end - begin);
+                    for (size_t i = begin; i < end; ++i) {
+                        result.emplace_back(*accounts[i], _db);
+                        result.back().reputation = reputations[i];
+                        auto vitr = vidx.find(accounts[i]->name);
+                        if (vitr != vidx.end()) {
+                            auto &votes = result.back().witness_votes;
+                            for (const auto &witness: vitr->witnesses) {
+                                votes.insert(votes.end(), witness);
+                            }
                         }
                     }
+                    return result;
+                };
+
+                // the caller holds the read lock, so workers read the same state
+                static const size_t min_accounts_per_thread = 16;
+                const size_t threads = std::max<size_t>(1,
+                    std::min<size_t>(get_accounts_threads, accounts.size() / min_accounts_per_thread));
+                const size_t chunk = (accounts.size() + threads - 1) / std::max<size_t>(threads, 1);
+
+                std::vector<std::future<std::vector<extended_account>>> workers;
+                for (size_t begin = chunk; begin < accounts.size(); begin += chunk) {
+                    auto task = std::make_shared<std::packaged_task<std::vector<extended_account>()>>(
+                        std::bind(assemble, begin, std::min(begin + chunk, accounts.size())));
+                    workers.push_back(task->get_future());
+                    accounts_ios.post([task]() {
+                        (*task)();
+                    });
+                }
+                // the parts refer to the data of this call, so all of them are waited for even on an error
+                auto wait_workers = [&]() {
+                    for (auto &worker: workers) {
+                        worker.wait();
+                    }
+                };
+                std::vector<extended_account> assembled;
+                try {
+                    assembled = assemble(0, std::min(chunk, accounts.size()));
+                } catch (...) {
+                    wait_workers();
+                    throw;
+                }
+                wait_workers();
+                for (auto &worker: workers) {
+                    auto part = worker.get();
+                    std::move(part.begin(), part.end(), std::back_inserter(assembled));
                 }
 
+                std::vector<extended_account> results;
+                results.reserve(names.size());
+                for (const auto &name: names) {
+                    auto itr = std::lower_bound(found_names.begin(), found_names.end(), account_name_type(name));
+                    if (itr != found_names.end() && *itr == name) {
+                        results.push_back(assembled[itr - found_names.begin()]);
+                    }
+                }
                 return results;
             }
 
 
+            void plugin::api_impl::update_witness_votes(const account_name_type &account) {
+                const auto *voter = _db.find_account(account);
+                if (voter == nullptr) {
+                    return;
+                }
+
+                std::vector<account_name_type> witnesses;
+                const auto &vidx = _db.get_index<witness_vote_index>().indices().get<by_account_witness>();
+                auto vitr = vidx.lower_bound(boost::make_tuple(voter->id, witness_id_type()));
+                while (vitr != vidx.end() && vitr->account == voter->id) {
+                    witnesses.push_back(_db.get(vitr->witness).owner);
+                    ++vitr;
+                }
+                std::sort(witnesses.begin(), witnesses.end());
+
+                const auto *votes = _db.find<account_witness_votes_object, by_account>(account);
+                if (witnesses.empty()) {
+                    if (votes != nullptr) {
+                        _db.remove(*votes);
+                    }
+                } else if (votes == nullptr) {
+                    _db.create<account_witness_votes_object>([&](account_witness_votes_object &o) {
+                        o.account = account;
+                        o.witnesses.assign(witnesses.begin(), witnesses.end());
+                    });
+                } else {
+                    _db.modify(*votes, [&](account_witness_votes_object &o) {
+                        o.witnesses.assign(witnesses.begin(), witnesses.end());
+                    });
+                }
+            }
+
+            void plugin::api_impl::rebuild_witness_votes() {
+                const auto &vote_idx = _db.get_index<witness_vote_index>().indices().get<by_account_witness>();
+                const auto &cache_idx = _db.get_index<account_witness_votes_index>().indices().get<by_account>();
+
+                // the plugin could be disabled while votes changed, so votes of each account are compared with the cache
+                uint32_t updated = 0;
+                std::vector<account_name_type> witnesses;
+                for (auto itr = vote_idx.begin(); itr != vote_idx.end();) {
+                    const auto account = itr->account;
+                    witnesses.clear();
+                    for (; itr != vote_idx.end() && itr->account == account; ++itr) {
+                        witnesses.push_back(_db.get(itr->witness).owner);
+                    }
+                    std::sort(witnesses.begin(), witnesses.end());
+
+                    const auto &name = _db.get(account).name;
+                    auto cached = cache_idx.find(name);
+                    if (cached == cache_idx.end() || cached->witnesses.size() != witnesses.size() ||
+                        !std::equal(witnesses.begin(), witnesses.end(), cached->witnesses.begin())
+                    ) {
+                        update_witness_votes(name);
+                        ++updated;
+                    }
+                }
+
+                // accounts which have no votes anymore
+                for (auto itr = cache_idx.begin(); itr != cache_idx.end();) {
+                    const auto &votes = *itr;
+                    ++itr;
+                    const auto *voter = _db.find_account(votes.account);
+                    auto vitr = voter ? vote_idx.lower_bound(boost::make_tuple(voter->id)) : vote_idx.end();
+                    if (vitr == vote_idx.end() || vitr->account != voter->id) {
+                        _db.remove(votes);
+                        ++updated;
+                    }
+                }
+
+                if (updated) {
+                    ilog("Updated witness votes of ${n} accounts", ("n", updated));
+                }
+            }
+
+            void plugin::api_impl::on_pre_apply_block(const signed_block &block) {
+                declining_accounts.clear();
+                const auto &request_idx = _db.get_index<decline_voting_rights_request_index>().indices().get<by_effective_date>();
+                for (auto itr = request_idx.begin();
+                     itr != request_idx.end() && itr->effective_date <= block.timestamp; ++itr) {
+                    declining_accounts.push_back(_db.get(itr->account).name);
+                }
+            }
+
+            void plugin::api_impl::on_applied_block(const signed_block &block) {
+                // votes of accounts are removed without operations when they lose voting rights
+                for (const auto &account: declining_accounts) {
+                    update_witness_votes(account);
+                }
+                declining_accounts.clear();
+            }
+
+            struct plugin::api_impl::witness_votes_visitor {
+                plugin::api_impl &_impl;
+
+                typedef void result_type;
+
+                template<typename T>
+                void operator()(const T &) const {
+                }
+
+                void operator()(const account_witness_vote_operation &op) const {
+                    _impl.update_witness_votes(op.account);
+                }
+
+                void operator()(const account_witness_proxy_operation &op) const {
+                    _impl.update_witness_votes(op.account);
+                }
+            };
+
+            void plugin::api_impl::on_post_apply_operation(const operation_notification &note) {
+                note.op.visit(witness_votes_visitor{*this});
+            }
+
+
             DEFINE_API(plugin, lookup_account_names) {
                 CHECK_ARG_SIZE(1)
                 return my->database().with_weak_read_lock([&]() {
@@ -732,23 +1075,13 @@ namespace golos {
                 uint32_t limit
             ) const {
                 FC_ASSERT(limit <= 1000);
-                const auto &witnesses_by_id = database().get_index<witness_index>().indices().get<by_id>();
+                const auto &witnesses_by_name = database().get_index<witness_index>().indices().get<by_name>();
 
-                // get all the names and look them all up, sort them, then figure out what
-                // records to return.  This could be optimized, but we expect the
-                // number of witnesses to be few and the frequency of calls to be rare
                 std::set<account_name_type> witnesses_by_account_name;
-                for (const witness_api_object &witness : witnesses_by_id) {
-                    if (witness.owner >= lower_bound_name) { // we can ignore anything below lower_bound_name
-                        witnesses_by_account_name.insert(witness.owner);
-                    }
-                }
-
-                auto end_iter = witnesses_by_account_name.begin();
-                while (end_iter != witnesses_by_account_name.end() && limit--) {
-                    ++end_iter;
+                for (auto itr = witnesses_by_name.lower_bound(account_name_type(lower_bound_name));
+                     itr != witnesses_by_name.end() && witnesses_by_account_name.size() < limit; ++itr) {
+                    witnesses_by_account_name.insert(witnesses_by_account_name.end(), itr->owner);
                 }
-                witnesses_by_account_name.erase(end_iter, witnesses_by_account_name.end());
                 return witnesses_by_account_name;
             }
 
@@ -913,8 +1246,28 @@ namespace golos {
             std::map<uint32_t, applied_operation> plugin::api_impl::get_account_history(
                 std::string account,
                 uint64_t from,
-                uint32_t limit
+                uint32_t limit,
+                uint64_t op_mask
             ) const {
+                if (op_mask != all_operations_mask) {
+                    FC_ASSERT(_account_history != nullptr &&
+                              _account_history->get_state() == appbase::abstract_plugin::started,
+                              "Filtering of account history by operation type requires account_history plugin");
+                    std::map<uint32_t, applied_operation> result;
+                    for (const auto &item : _account_history->get_account_history(account, from, limit, op_mask)) {
+                        result[item.first] = item.second;
+                    }
+                    return result;
+                }
+
+                if (_account_history != nullptr && _account_history->is_archive_enabled()) {
+                    std::map<uint32_t, applied_operation> result;
+                    for (const auto &item : _account_history->get_account_history(account, from, limit)) {
+                        result[item.first] = item.second;
+                    }
+                    return result;
+                }
+
                 FC_ASSERT(limit <= 10000, "Limit of ${l} is greater than maxmimum allowed", ("l", limit));
                 FC_ASSERT(from >= limit, "From must be greater than limit");
                 //   idump((account)(from)(limit));
@@ -934,13 +1287,18 @@ namespace golos {
 
 
             DEFINE_API(plugin, get_account_history) {
-                CHECK_ARG_SIZE(3)
+                FC_ASSERT(args.args->size() == 3 || args.args->size() == 4,
+                          "Expected 3 or 4 arguments, was ${n}", ("n", args.args->size()));
                 auto account = args.args->at(0).as<std::string>();
                 auto from = args.args->at(1).as<uint64_t>();
                 auto limit = args.args->at(2).as<uint32_t>();
+                uint64_t op_mask = all_operations_mask;
+                if (args.args->size() == 4) {
+                    op_mask = args.args->at(3).as<uint64_t>();
+                }
 
                 return my->database().with_weak_read_lock([&]() {
-                    return my->get_account_history(account, from, limit);
+                    return my->get_account_history(account, from, limit, op_mask);
                 });
             }
 
@@ -1029,6 +1387,13 @@ namespace golos {
                         result.transaction_num = itr->trx_in_block;
                         return result;
                     }
+                    if (my->_transaction_lookup != nullptr &&
+                        my->_transaction_lookup->get_state() == appbase::abstract_plugin::started) {
+                        auto result = my->_transaction_lookup->find_transaction(id);
+                        if (result.valid()) {
+                            return *result;
+                        }
+                    }
                     FC_ASSERT(false, "Unknown Transaction ${t}", ("t", id));
                 });
             }
@@ -1055,18 +1420,44 @@ namespace golos {
                 return info;
             }
 
+            void plugin::set_program_options(
+                boost::program_options::options_description &cli,
+                boost::program_options::options_description &cfg
+            ) {
+                cfg.add_options()
+                    ("get-accounts-threads", boost::program_options::value<uint32_t>()->default_value(1),
+                     "number of threads assembling accounts of a big get_accounts request");
+            }
+
             void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 ilog("database_api plugin: plugin_initialize() begin");
                 my = std::make_unique<api_impl>();
+                my->get_accounts_threads = std::max<uint32_t>(1, options.at("get-accounts-threads").as<uint32_t>());
+                my->start_accounts_workers();
                 JSON_RPC_REGISTER_API(plugin_name)
                 my->database().applied_block.connect([this](const protocol::signed_block &) {
                     this->clear_block_applied_callback();
                 });
+
+                auto &db = my->database();
+                add_plugin_index<account_witness_votes_index>(db);
+                db.pre_apply_block.connect([this](const protocol::signed_block &block) {
+                    my->on_pre_apply_block(block);
+                });
+                db.applied_block.connect([this](const protocol::signed_block &block) {
+                    my->on_applied_block(block);
+                });
+                db.post_apply_operation.connect([this](const operation_notification &note) {
+                    my->on_post_apply_operation(note);
+                });
                 ilog("database_api plugin: plugin_initialize() end");
             }
 
             void plugin::plugin_startup() {
                 my->startup();
+                my->database().with_strong_write_lock([&]() {
+                    my->rebuild_witness_votes();
+                });
             }
         }
     }
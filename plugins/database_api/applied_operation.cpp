@@ -14,6 +14,12 @@ namespace golos {
                 op = fc::raw::unpack<protocol::operation>(op_obj.serialized_op);
             }
 
+            applied_operation::applied_operation(const account_history::archived_operation &op_obj)
+                    : trx_id(op_obj.trx_id), block(op_obj.block), trx_in_block(op_obj.trx_in_block),
+                      op_in_trx(op_obj.op_in_trx), virtual_op(op_obj.virtual_op), timestamp(op_obj.timestamp) {
+                op = fc::raw::unpack<protocol::operation>(op_obj.serialized_op);
+            }
+
         }
     }
 }
@@ -3,6 +3,7 @@
 #include <golos/protocol/operations.hpp>
 #include <golos/chain/steem_object_types.hpp>
 #include <golos/chain/history_object.hpp>
+#include <golos/plugins/account_history/history_archive.hpp>
 
 namespace golos {
     namespace plugins {
@@ -13,6 +14,8 @@ namespace golos {
 
                 applied_operation(const golos::chain::operation_object &op_obj);
 
+                applied_operation(const account_history::archived_operation &op_obj);
+
                 golos::protocol::transaction_id_type trx_id;
                 uint32_t block = 0;
                 uint32_t trx_in_block = 0;
@@ -112,6 +112,9 @@ namespace golos {
 
             using get_account_history_return_type = std::map<uint32_t, applied_operation>;
 
+            /// Operation type mask of get_account_history selecting all operations, bit N is operation::which() == N
+            constexpr uint64_t all_operations_mask = uint64_t(-1);
+
             using chain_properties_17 = chain_properties;
             using price_17 = price;
 
@@ -122,6 +125,7 @@ namespace golos {
             DEFINE_API_ARGS(get_block_header,                 msg_pack, optional<block_header>)
             DEFINE_API_ARGS(get_block,                        msg_pack, optional<signed_block>)
             DEFINE_API_ARGS(get_ops_in_block,                 msg_pack, std::vector<applied_operation>)
+            DEFINE_API_ARGS(get_virtual_ops_in_range,         msg_pack, std::vector<applied_operation>)
             DEFINE_API_ARGS(set_block_applied_callback,       msg_pack, void_type)
             DEFINE_API_ARGS(get_config,                       msg_pack, variant_object)
             DEFINE_API_ARGS(get_dynamic_global_properties,    msg_pack, dynamic_global_property_api_object)
@@ -181,7 +185,7 @@ namespace golos {
                         (chain::plugin)
                 )
 
-                void set_program_options(boost::program_options::options_description &cli, boost::program_options::options_description &cfg) override{}
+                void set_program_options(boost::program_options::options_description &cli, boost::program_options::options_description &cfg) override;
 
                 void plugin_initialize(const boost::program_options::variables_map &options) override;
 
@@ -255,6 +259,15 @@ namespace golos {
                                      */
                                     (get_ops_in_block)
 
+                                    /**
+                                     *  @brief Get virtual operations of a range of blocks, requires store-virtual-operations
+                                     *  @param from_block Height of the first block
+                                     *  @param block_count Number of blocks, up to 1000
+                                     *  @return virtual operations of the blocks in the order they were applied,
+                                     *  fails with the first stored block if from_block is before it
+                                     */
+                                    (get_virtual_ops_in_range)
+
 
 
                                     /**
@@ -433,6 +446,8 @@ namespace golos {
                                      *
                                      *  @param from - the absolute sequence number, -1 means most recent, limit is the number of operations before from.
                                      *  @param limit - the maximum number of items that can be queried (0 to 1000], must be less than from
+                                     *  @param op_mask - optional, bit N selects operations with operation::which() == N;
+                                     *  with a mask, up to limit matched operations not newer than from are returned
                                      */
                                     (get_account_history)
 
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <golos/chain/account_object.hpp>
+#include <golos/chain/steem_object_types.hpp>
+#include <golos/protocol/types.hpp>
+
+namespace golos {
+    namespace plugins {
+        namespace database_api {
+
+            using golos::protocol::account_name_type;
+            using chainbase::object;
+            using chainbase::allocator;
+            using chainbase::shared_vector;
+            using golos::chain::by_id;
+            using golos::chain::by_account;
+
+#ifndef DATABASE_API_SPACE_ID
+#define DATABASE_API_SPACE_ID 13
+#endif
+
+            enum database_api_object_types {
+                account_witness_votes_object_type = (DATABASE_API_SPACE_ID << 8)
+            };
+
+            /**
+             *  Names of witnesses the account votes for, sorted by name.
+             *
+             *  It duplicates the witness_vote_index for accounts with votes, so the account
+             *  API doesn't have to join votes with witnesses. It is rebuilt from the
+             *  witness_vote_index after every change of votes of the account.
+             */
+            class account_witness_votes_object
+                    : public object<account_witness_votes_object_type, account_witness_votes_object> {
+            public:
+                template<typename Constructor, typename Allocator>
+                account_witness_votes_object(Constructor &&c, allocator<Allocator> a)
+                        : witnesses(a.get_segment_manager()) {
+                    c(*this);
+                }
+
+                id_type id;
+
+                account_name_type account;
+                shared_vector<account_name_type> witnesses;
+            };
+
+            typedef account_witness_votes_object::id_type account_witness_votes_id_type;
+
+            using namespace boost::multi_index;
+
+            typedef multi_index_container<
+                    account_witness_votes_object,
+                    indexed_by<
+                            ordered_unique<tag<by_id>,
+                                    member<account_witness_votes_object, account_witness_votes_id_type, &account_witness_votes_object::id>>,
+                            ordered_unique<tag<by_account>,
+                                    member<account_witness_votes_object, account_name_type, &account_witness_votes_object::account>>>,
+                    allocator<account_witness_votes_object>>
+                    account_witness_votes_index;
+
+        }
+    }
+} // golos::plugins::database_api
+
+FC_REFLECT((golos::plugins::database_api::account_witness_votes_object), (id)(account)(witnesses))
+CHAINBASE_SET_INDEX_TYPE(golos::plugins::database_api::account_witness_votes_object,
+                         golos::plugins::database_api::account_witness_votes_index)
@@ -24,7 +24,9 @@ using namespace golos::chain;
 
 struct plugin::plugin_impl {
 public:
-    plugin_impl() : db_(appbase::app().get_plugin<plugins::chain::plugin>().db()) {
+    plugin_impl()
+        : chain_(appbase::app().get_plugin<plugins::chain::plugin>()),
+          db_(chain_.db()) {
     }
 
     // APIs
@@ -85,6 +87,7 @@ public:
     boost::signals2::connection applied_block_connection;
     std::map< protocol::block_id_type, std::vector< std::function< void( golos::chain::database& ) > > > _debug_updates;
 private:
+    plugins::chain::plugin & chain_;
     golos::chain::database & db_;
 };
 
@@ -182,6 +185,7 @@ void plugin::plugin_impl::debug_update (
     // What the last block does has been changed by adding to node_property_object, so we have to re-apply it
     db.pop_block();
     db.push_block( *head_block, skip );
+    chain_.wait_block_consumers_capacity();
 }
 
 void plugin::set_logging(const bool islogging)
@@ -273,7 +277,7 @@ uint32_t plugin::plugin_impl::debug_generate_blocks(
             }
         }
 
-        db.generate_block( scheduled_time, scheduled_witness_name, *debug_private_key, skip );
+        chain_.generate_block( scheduled_time, scheduled_witness_name, *debug_private_key, skip );
         ++produced;
         slot = new_slot;
     }
@@ -359,6 +363,7 @@ uint32_t plugin::plugin_impl::debug_push_blocks(
 
             try{
                 database().push_block( result.first, skip_flags );
+                chain_.wait_block_consumers_capacity();
             }
             catch( const fc::exception& e ) {
                 elog( "Got exception pushing block ${bn} : ${bid} (${i} of ${n})", ("bn", result.first.block_num())("bid", result.first.id())("i", i)("n", count) );
@@ -0,0 +1,109 @@
+#include <golos/plugins/follow/computed_feed.hpp>
+#include <golos/plugins/follow/follow_forward.hpp>
+
+#include <algorithm>
+
+namespace golos {
+    namespace plugins {
+        namespace follow {
+
+            computed_feed::computed_feed(
+                    const golos::chain::database &db, account_name_type account, uint32_t start_entry_id)
+                    : _db(db),
+                      _blog_idx(db.get_index<blog_index>().indices().get<by_blog>()) {
+                collect_following(account);
+                start(start_entry_id ? start_entry_id : ~uint32_t(0));
+            }
+
+            computed_feed::computed_feed(
+                    const golos::chain::database &db, account_name_type account, const comment_object &start_comment)
+                    : _db(db),
+                      _blog_idx(db.get_index<blog_index>().indices().get<by_blog>()) {
+                collect_following(account);
+                auto start_entry_id = newest_entry_id(start_comment.id);
+                FC_ASSERT(start_entry_id != 0, "Comment is not in account's feed");
+                start(start_entry_id);
+            }
+
+            uint32_t computed_feed::entry_id(const blog_object &b) {
+                return uint32_t(b.id._id) + 1;
+            }
+
+            void computed_feed::collect_following(account_name_type account) {
+                const auto &idx = _db.get_index<follow_index>().indices().get<by_follower_following>();
+                for (auto itr = idx.lower_bound(account); itr != idx.end() && itr->follower == account; ++itr) {
+                    if (itr->what & (1 << blog)) {
+                        _following.insert(itr->following);
+                    }
+                }
+            }
+
+            void computed_feed::start(uint32_t start_entry_id) {
+                for (const auto &blogger: _following) {
+                    push(_blog_idx.lower_bound(blogger), blogger, start_entry_id);
+                }
+            }
+
+            uint32_t computed_feed::newest_entry_id(comment_object::id_type comment) const {
+                uint32_t result = 0;
+                const auto &comment_idx = _db.get_index<blog_index>().indices().get<by_comment>();
+                for (auto itr = comment_idx.lower_bound(comment);
+                     itr != comment_idx.end() && itr->comment == comment; ++itr) {
+                    if (_following.count(itr->account)) {
+                        result = std::max(result, entry_id(*itr));
+                    }
+                }
+                return result;
+            }
+
+            void computed_feed::push(blog_iterator itr, account_name_type blogger, uint32_t start_entry_id) {
+                // blog entries are ordered newest first, so skip the ones after the start of the page
+                for (; itr != _blog_idx.end() && itr->account == blogger; ++itr) {
+                    auto id = entry_id(*itr);
+                    if (id <= start_entry_id) {
+                        _heap.push_back({id, itr});
+                        std::push_heap(_heap.begin(), _heap.end());
+                        return;
+                    }
+                }
+            }
+
+            bool computed_feed::next(entry &e) {
+                while (!_heap.empty()) {
+                    std::pop_heap(_heap.begin(), _heap.end());
+                    auto top = _heap.back();
+                    _heap.pop_back();
+
+                    const auto &b = *top.itr;
+                    push(std::next(top.itr), b.account, top.entry_id);
+
+                    // a post comes only at its newest entry, which can be on a previous page
+                    if (newest_entry_id(b.comment) != top.entry_id) {
+                        continue;
+                    }
+
+                    e = entry();
+                    e.comment = b.comment;
+                    e.entry_id = top.entry_id;
+
+                    const auto &comment = _db.get(b.comment);
+                    const auto &comment_idx = _db.get_index<blog_index>().indices().get<by_comment>();
+                    for (auto itr = comment_idx.lower_bound(b.comment);
+                         itr != comment_idx.end() && itr->comment == b.comment; ++itr) {
+                        if (itr->account == comment.author || !_following.count(itr->account)) {
+                            continue;
+                        }
+                        e.reblogged_by.push_back(itr->account);
+                        if (e.first_reblogged_by == account_name_type() || itr->reblogged_on < e.first_reblogged_on) {
+                            e.first_reblogged_by = itr->account;
+                            e.first_reblogged_on = itr->reblogged_on;
+                        }
+                    }
+                    return true;
+                }
+                return false;
+            }
+
+        }
+    }
+} // golos::follow
@@ -148,7 +148,7 @@ namespace golos {
                     const auto &feed_idx = db().get_index<feed_index>().indices().get<by_feed>();
                     const auto &comment_idx = db().get_index<feed_index>().indices().get<by_comment>();
                     const auto &idx = db().get_index<follow_index>().indices().get<by_following_follower>();
-                    auto itr = idx.find(o.account);
+                    auto itr = _plugin->store_feeds() ? idx.find(o.account) : idx.end();
 
                     while (itr != idx.end() && itr->following == o.account) {
 
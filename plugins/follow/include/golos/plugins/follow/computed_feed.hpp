@@ -0,0 +1,76 @@
+#pragma once
+
+#include <golos/plugins/follow/follow_objects.hpp>
+#include <golos/chain/database.hpp>
+
+#include <set>
+#include <vector>
+
+namespace golos {
+    namespace plugins {
+        namespace follow {
+            using fc::time_point_sec;
+
+            /**
+             *  Assembles a feed of an account from blogs of the accounts it follows.
+             *
+             *  Used instead of feed_object when follow-store-feeds is disabled: feeds are
+             *  the biggest part of the follow plugin data, as each post is copied into the
+             *  feed of every follower, while blogs and follows are already kept.
+             *
+             *  Entries come newest first, a post comes once at its newest entry in the blogs,
+             *  so a reblogged post appears at its latest reblog. An entry id is the id of the
+             *  blog_object of the entry plus one: blog objects are created in the order entries
+             *  appear, so ids are unique and the next page starts from the last entry id minus one.
+             */
+            class computed_feed final {
+            public:
+                struct entry {
+                    comment_object::id_type comment;
+                    std::vector<account_name_type> reblogged_by;
+                    account_name_type first_reblogged_by;
+                    time_point_sec first_reblogged_on;
+                    uint32_t entry_id = 0;
+                };
+
+                /// Starts from entries not newer than start_entry_id, 0 - from the newest one
+                computed_feed(const golos::chain::database &db, account_name_type account, uint32_t start_entry_id = 0);
+
+                /// Starts from the entry of start_comment, which should be in the feed
+                computed_feed(const golos::chain::database &db, account_name_type account, const comment_object &start_comment);
+
+                /// Moves to the next entry, returns false at the end of the feed
+                bool next(entry &e);
+
+            private:
+                using blog_iterator = blog_index::index<by_blog>::type::const_iterator;
+
+                struct cursor {
+                    uint32_t entry_id;
+                    blog_iterator itr;
+
+                    bool operator<(const cursor &other) const {
+                        return entry_id < other.entry_id;
+                    }
+                };
+
+                static uint32_t entry_id(const blog_object &b);
+
+                void collect_following(account_name_type account);
+
+                void start(uint32_t start_entry_id);
+
+                /// The id of the newest entry of the comment in the followed blogs, 0 if it isn't in the feed
+                uint32_t newest_entry_id(comment_object::id_type comment) const;
+
+                void push(blog_iterator itr, account_name_type blogger, uint32_t start_entry_id);
+
+                const golos::chain::database &_db;
+                const blog_index::index<by_blog>::type &_blog_idx;
+                std::set<account_name_type> _following;
+                std::vector<cursor> _heap;
+            };
+
+        }
+    }
+} // golos::follow
@@ -64,6 +64,8 @@ namespace golos {
 
                 uint32_t max_feed_size();
 
+                bool store_feeds();
+
                 void plugin_startup() override;
 
                 void plugin_shutdown() override {}
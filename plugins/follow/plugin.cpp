@@ -1,6 +1,7 @@
 #include <golos/plugins/follow/follow_objects.hpp>
 #include <golos/plugins/follow/follow_operations.hpp>
 #include <golos/plugins/follow/follow_evaluators.hpp>
+#include <golos/plugins/follow/computed_feed.hpp>
 #include <golos/protocol/config.hpp>
 #include <golos/chain/database.hpp>
 #include <golos/chain/generic_custom_operation_interpreter.hpp>
@@ -147,7 +148,7 @@ namespace golos {
 
                         const auto &idx = db.get_index<follow_index>().indices().get<by_following_follower>();
                         const auto &comment_idx = db.get_index<feed_index>().indices().get<by_comment>();
-                        auto itr = idx.find(op.author);
+                        auto itr = _plugin.store_feeds() ? idx.find(op.author) : idx.end();
 
                         const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
 
@@ -359,6 +360,8 @@ namespace golos {
 
                 uint32_t max_feed_size_ = 500;
 
+                bool store_feeds_ = true;
+
                 std::shared_ptr<generic_custom_operation_interpreter<
                         follow::follow_plugin_operation>> _custom_operation_interpreter;
             };
@@ -371,7 +374,10 @@ namespace golos {
                                                     boost::program_options::options_description &cfg) {
                 cli.add_options()
                     ("follow-max-feed-size", boost::program_options::value<uint32_t>()->default_value(500),
-                        "Set the maximum size of cached feed for an account");
+                        "Set the maximum size of cached feed for an account")
+                    ("follow-store-feeds", boost::program_options::value<bool>()->default_value(true),
+                        "Keep feeds of accounts in shared memory. "
+                        "If false, feeds are assembled on request from blogs of followed accounts");
                 cfg.add(cli);
             }
 
@@ -382,6 +388,8 @@ namespace golos {
                     auto &db = pimpl->database();
                     pimpl->plugin_initialize(*this);
 
+                    // not a block consumer: the reputation change of a vote is computed from the previous
+                    // vote, which is only seen before the operation, and follow objects are kept in chainbase
                     db.pre_apply_operation.connect([&](const operation_notification &o) {
                         pimpl->pre_operation(o, *this);
                     });
@@ -400,6 +408,10 @@ namespace golos {
                         pimpl->max_feed_size_ = feed_size;
                     }
 
+                    if (options.count("follow-store-feeds")) {
+                        pimpl->store_feeds_ = options["follow-store-feeds"].as<bool>();
+                    }
+
                     JSON_RPC_REGISTER_API ( name() ) ;
                 } FC_CAPTURE_AND_RETHROW()
             }
@@ -411,6 +423,10 @@ namespace golos {
                 return pimpl->max_feed_size_;
             }
 
+            bool plugin::store_feeds() {
+                return pimpl->store_feeds_;
+            }
+
             plugin::~plugin() {
 
             }
@@ -494,6 +510,28 @@ namespace golos {
                 result.reserve(limit);
 
                 const auto &db = database();
+
+                if (!store_feeds_) {
+                    computed_feed feed(db, account, entry_id);
+                    computed_feed::entry itr;
+                    while (result.size() < limit && feed.next(itr)) {
+                        const auto &comment = db.get(itr.comment);
+                        feed_entry entry;
+                        entry.author = comment.author;
+                        entry.permlink = to_string(comment.permlink);
+                        entry.entry_id = itr.entry_id;
+                        if (itr.first_reblogged_by != account_name_type()) {
+                            entry.reblog_by.reserve(itr.reblogged_by.size());
+                            for (const auto &a : itr.reblogged_by) {
+                                entry.reblog_by.push_back(a);
+                            }
+                            entry.reblog_on = itr.first_reblogged_on;
+                        }
+                        result.push_back(entry);
+                    }
+                    return result;
+                }
+
                 const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
                 auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
 
@@ -533,6 +571,26 @@ namespace golos {
                 result.reserve(limit);
 
                 const auto &db = database();
+
+                if (!store_feeds_) {
+                    computed_feed feed(db, account, entry_id);
+                    computed_feed::entry itr;
+                    while (result.size() < limit && feed.next(itr)) {
+                        comment_feed_entry entry;
+                        entry.comment = db.get(itr.comment);
+                        entry.entry_id = itr.entry_id;
+                        if (itr.first_reblogged_by != account_name_type()) {
+                            entry.reblog_by.reserve(itr.reblogged_by.size());
+                            for (const auto &a : itr.reblogged_by) {
+                                entry.reblog_by.push_back(a);
+                            }
+                            entry.reblog_on = itr.first_reblogged_on;
+                        }
+                        result.push_back(entry);
+                    }
+                    return result;
+                }
+
                 const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
                 auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
 
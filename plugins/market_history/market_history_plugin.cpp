@@ -405,6 +405,8 @@ namespace golos {
                     _my.reset(new market_history_plugin_impl(*this));
                     golos::chain::database& db = _my->database();
 
+                    // not a block consumer: buckets and order history are chainbase objects,
+                    // which have to be popped with the block
                     db.post_apply_operation.connect(
                             [&](const golos::chain::operation_notification &o) { _my->update_market_histories(o); });
                     golos::chain::add_plugin_index<bucket_index>(db);
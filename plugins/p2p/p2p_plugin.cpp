@@ -10,6 +10,9 @@
 #include <boost/range/algorithm/reverse.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 
+#include <memory>
+#include <unordered_map>
+
 using std::string;
 using std::vector;
 
@@ -29,6 +32,7 @@ namespace golos {
             using golos::protocol::signed_block_header;
             using golos::protocol::signed_block;
             using golos::protocol::block_id_type;
+            using golos::protocol::transaction_id_type;
             using golos::chain::database;
             using golos::chain::chain_id_type;
 
@@ -88,6 +92,7 @@ namespace golos {
                     vector<fc::ip::endpoint> seeds;
                     string user_agent;
                     uint32_t max_connections = 0;
+                    vector<fc::ip::address> plaintext_peers;
                     bool force_validate = false;
                     bool block_producer = false;
 
@@ -96,6 +101,11 @@ namespace golos {
                     chain::plugin &chain;
 
                     fc::thread p2p_thread;
+
+                    /// transactions are validated on a pool of threads, only pushing them takes the write lock
+                    std::vector<std::unique_ptr<fc::thread>> transaction_threads;
+                    uint32_t next_transaction_thread = 0;
+                    std::unordered_map<transaction_id_type, fc::future<void>> transactions_being_validated;
                 };
 
                 ////////////////////////////// Begin node_delegate Implementation //////////////////////////////
@@ -161,7 +171,37 @@ namespace golos {
 
                 void p2p_plugin_impl::handle_transaction(const trx_message &trx_msg) {
                     try {
-                        chain.accept_transaction(trx_msg.trx);
+                        // the same transaction can come from several peers at once, it gets the result of the first one
+                        auto trx_id = trx_msg.trx.id();
+                        auto itr = transactions_being_validated.find(trx_id);
+                        if (itr != transactions_being_validated.end()) {
+                            auto validation = itr->second;
+                            validation.wait();
+                            return;
+                        }
+
+                        auto &thread = *transaction_threads[next_transaction_thread++ % transaction_threads.size()];
+                        auto validation = thread.async([&]() {
+                            // a transaction we already have is valid, its signatures aren't verified again
+                            bool is_known = chain.db().with_weak_read_lock([&]() {
+                                return chain.db().is_known_transaction(trx_id);
+                            });
+                            if (is_known) {
+                                return;
+                            }
+
+                            // signatures are recovered without a lock and the rest is checked under the read lock,
+                            // so several transactions are validated at once, only pushing takes the write lock
+                            chain.accept_transaction(trx_msg.trx);
+                        }, "accept_transaction");
+                        transactions_being_validated.emplace(trx_id, validation);
+                        try {
+                            validation.wait();
+                        } catch (...) {
+                            transactions_being_validated.erase(trx_id);
+                            throw;
+                        }
+                        transactions_being_validated.erase(trx_id);
                     } FC_CAPTURE_AND_RETHROW((trx_msg))
                 }
 
@@ -443,7 +483,12 @@ namespace golos {
                     ("seed-node", boost::program_options::value<vector<string>>()->composing(),
                         "The IP address and port of a remote peer to sync with. Deprecated in favor of p2p-seed-node.")
                     ("p2p-seed-node", boost::program_options::value<vector<string>>()->composing(),
-                        "The IP address and port of a remote peer to sync with.");
+                        "The IP address and port of a remote peer to sync with.")
+                    ("p2p-transaction-validation-threads", boost::program_options::value<uint32_t>()->default_value(2),
+                        "Number of threads validating transactions received from peers.")
+                    ("p2p-plaintext-peer", boost::program_options::value<vector<string>>()->composing(),
+                        "The IP address of a trusted peer (e.g. on a private link), the connection with it isn't encrypted "
+                        "if it lists this node too. The peer must support unencrypted connections.");
                 cli.add_options()
                     ("force-validate", boost::program_options::bool_switch()->default_value(false),
                         "Force validation of all transactions. Deprecated in favor of p2p-force-validate")
@@ -490,6 +535,18 @@ namespace golos {
                     }
                 }
 
+                if (options.count("p2p-plaintext-peer")) {
+                    for (const string &address : options.at("p2p-plaintext-peer").as<vector<string>>()) {
+                        my->plaintext_peers.push_back(fc::ip::address(address));
+                    }
+                }
+
+                auto transaction_threads = std::max<uint32_t>(
+                    options.at("p2p-transaction-validation-threads").as<uint32_t>(), 1);
+                for (uint32_t i = 0; i < transaction_threads; ++i) {
+                    my->transaction_threads.emplace_back(new fc::thread("p2p transactions " + std::to_string(i)));
+                }
+
                 my->force_validate = options.at("p2p-force-validate").as<bool>();
 
                 if (!my->force_validate && options.at("force-validate").as<bool>()) {
@@ -503,6 +560,7 @@ namespace golos {
                     my->node.reset(new golos::network::node(my->user_agent));
                     my->node->load_configuration(app().data_dir() / "p2p");
                     my->node->set_node_delegate(&(*my));
+                    my->node->set_plaintext_peers(my->plaintext_peers);
 
                     if (my->endpoint) {
                         ilog("Configuring P2P to listen at ${ep}", ("ep", my->endpoint));
@@ -539,6 +597,9 @@ namespace golos {
                 ilog("Shutting down P2P Plugin");
                 my->node->close();
                 my->p2p_thread.quit();
+                for (auto &thread: my->transaction_threads) {
+                    thread->quit();
+                }
                 my->node.reset();
             }
 
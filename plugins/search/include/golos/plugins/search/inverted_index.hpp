@@ -0,0 +1,94 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/filesystem.hpp>
+
+#include <boost/container/flat_map.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace golos {
+namespace plugins {
+namespace search {
+
+using term_id_type = uint32_t;
+using document_id_type = uint32_t;
+
+/**
+ * Splits text into lower-cased terms. Letters and digits of ASCII, Latin-1 and Cyrillic
+ * form terms, everything else (punctuation, markup, symbols, emoji) separates them.
+ * Terms shorter than 2 or longer than 32 code points are dropped.
+ */
+std::vector<std::string> tokenize(const std::string &text);
+
+struct search_document {
+    std::string author;
+    std::string permlink;
+    std::string language;
+    uint32_t length = 0;
+    std::vector<std::pair<term_id_type, uint16_t>> terms;
+};
+
+struct search_hit {
+    document_id_type id = 0;
+    double score = 0;
+};
+
+/**
+ * In-memory inverted index over comment text, ranked with BM25.
+ *
+ * Lives outside of chainbase: it is not covered by undo sessions, so callers
+ * must check hits against the current state before returning them.
+ */
+class inverted_index final {
+public:
+    using filter_type = std::function<bool(const search_document &)>;
+
+    /// Replaces the document for author/permlink (or adds a new one)
+    void update(
+        const std::string &author, const std::string &permlink, const std::string &language,
+        const std::string &title, const std::string &body);
+
+    void remove(const std::string &author, const std::string &permlink);
+
+    std::vector<search_hit> search(const std::string &query, uint32_t limit, const filter_type &filter) const;
+
+    const search_document &get_document(document_id_type id) const;
+
+    std::size_t size() const {
+        return documents_.size();
+    }
+
+    void clear();
+
+    void save(const fc::path &file, uint32_t block_num) const;
+
+    /// @return block number the index was saved at, or 0 if there is no file
+    uint32_t load(const fc::path &file);
+
+private:
+    using posting_list = boost::container::flat_map<document_id_type, uint16_t>;
+
+    term_id_type get_term_id(const std::string &term);
+
+    void remove_document(document_id_type id);
+
+    std::vector<std::string> terms_;
+    std::unordered_map<std::string, term_id_type> term_ids_;
+    std::vector<posting_list> postings_;
+
+    std::unordered_map<document_id_type, search_document> documents_;
+    std::unordered_map<std::string, document_id_type> by_permlink_;
+    document_id_type next_id_ = 0;
+    uint64_t total_length_ = 0;
+};
+
+} } } // golos::plugins::search
+
+FC_REFLECT((golos::plugins::search::search_document), (author)(permlink)(language)(length)(terms))
+FC_REFLECT((golos::plugins::search::search_hit), (id)(score))
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <appbase/application.hpp>
+#include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/json_rpc/utility.hpp>
+#include <golos/plugins/json_rpc/plugin.hpp>
+
+#include <boost/program_options.hpp>
+#include <string>
+#include <vector>
+
+namespace golos {
+namespace plugins {
+namespace search {
+
+using golos::plugins::json_rpc::msg_pack;
+
+struct search_result {
+    std::string author;
+    std::string permlink;
+    std::string title;
+    std::string language;
+    double score = 0;
+};
+
+DEFINE_API_ARGS(search_content, msg_pack, std::vector<search_result>)
+
+/**
+ * Full-text search over post titles and bodies.
+ *
+ * The index is kept in memory outside of the shared memory file and is saved to
+ * search-index-file on shutdown. It must be rebuilt with --replay-blockchain
+ * if the node was stopped abnormally.
+ */
+class plugin final : public appbase::plugin<plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES((chain::plugin) (json_rpc::plugin))
+
+    constexpr const static char *plugin_name = "search";
+
+    static const std::string &name() {
+        static std::string name = plugin_name;
+        return name;
+    }
+
+    plugin();
+
+    ~plugin();
+
+    void set_program_options(
+        boost::program_options::options_description &cli,
+        boost::program_options::options_description &cfg) override;
+
+    void plugin_initialize(const boost::program_options::variables_map &options) override;
+
+    void plugin_startup() override;
+
+    void plugin_shutdown() override;
+
+    DECLARE_API((search_content))
+
+private:
+    struct plugin_impl;
+
+    std::unique_ptr<plugin_impl> my;
+};
+
+} } } // golos::plugins::search
+
+FC_REFLECT((golos::plugins::search::search_result), (author)(permlink)(title)(language)(score))
@@ -0,0 +1,343 @@
+#include <golos/plugins/search/inverted_index.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace golos {
+namespace plugins {
+namespace search {
+
+struct index_snapshot {
+    uint32_t block_num = 0;
+    std::vector<std::string> terms;
+    std::vector<search_document> documents;
+};
+
+} } } // golos::plugins::search
+
+FC_REFLECT((golos::plugins::search::index_snapshot), (block_num)(terms)(documents))
+
+namespace golos {
+namespace plugins {
+namespace search {
+
+namespace {
+
+constexpr std::size_t min_term_length = 2;
+constexpr std::size_t max_term_length = 32;
+constexpr uint16_t title_weight = 3;
+
+constexpr double bm25_k1 = 1.2;
+constexpr double bm25_b = 0.75;
+
+// Decodes one UTF-8 code point, returns 0 on malformed input (treated as a separator)
+uint32_t next_code_point(const std::string &text, std::size_t &pos) {
+    auto c = static_cast<unsigned char>(text[pos++]);
+    if (c < 0x80) {
+        return c;
+    }
+
+    std::size_t extra;
+    uint32_t cp;
+    if ((c & 0xE0) == 0xC0) {
+        extra = 1;
+        cp = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        extra = 2;
+        cp = c & 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        extra = 3;
+        cp = c & 0x07;
+    } else {
+        return 0;
+    }
+
+    for (; extra > 0; --extra) {
+        if (pos >= text.size() || (static_cast<unsigned char>(text[pos]) & 0xC0) != 0x80) {
+            return 0;
+        }
+        cp = (cp << 6) | (static_cast<unsigned char>(text[pos++]) & 0x3F);
+    }
+    return cp;
+}
+
+// Returns the lower-case form of a term character, or 0 for a separator
+uint32_t fold_code_point(uint32_t cp) {
+    if (cp < 0x80) {
+        if (cp >= 'A' && cp <= 'Z') {
+            return cp + 0x20;
+        }
+        if ((cp >= 'a' && cp <= 'z') || (cp >= '0' && cp <= '9')) {
+            return cp;
+        }
+        return 0;
+    }
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) {
+        return cp + 0x20;
+    }
+    if (cp >= 0xDF && cp <= 0x24F && cp != 0xF7) {
+        return cp;
+    }
+    if (cp >= 0x400 && cp <= 0x40F) {
+        return cp + 0x50;
+    }
+    if (cp >= 0x410 && cp <= 0x42F) {
+        return cp + 0x20;
+    }
+    if (cp >= 0x430 && cp <= 0x4FF) {
+        return cp;
+    }
+    return 0;
+}
+
+void append_utf8(std::string &out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+void count_terms(const std::string &text, uint16_t weight, std::unordered_map<std::string, uint32_t> &counts) {
+    for (auto &term: tokenize(text)) {
+        counts[term] += weight;
+    }
+}
+
+} // anonymous namespace
+
+std::vector<std::string> tokenize(const std::string &text) {
+    std::vector<std::string> result;
+    std::string term;
+    std::size_t term_length = 0;
+
+    auto flush = [&]() {
+        if (term_length >= min_term_length && term_length <= max_term_length) {
+            result.push_back(term);
+        }
+        term.clear();
+        term_length = 0;
+    };
+
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        auto cp = fold_code_point(next_code_point(text, pos));
+        if (cp == 0) {
+            flush();
+            continue;
+        }
+        append_utf8(term, cp);
+        ++term_length;
+    }
+    flush();
+
+    return result;
+}
+
+term_id_type inverted_index::get_term_id(const std::string &term) {
+    auto itr = term_ids_.find(term);
+    if (itr != term_ids_.end()) {
+        return itr->second;
+    }
+
+    term_id_type id = terms_.size();
+    terms_.push_back(term);
+    postings_.emplace_back();
+    term_ids_.emplace(term, id);
+    return id;
+}
+
+void inverted_index::update(
+    const std::string &author, const std::string &permlink, const std::string &language,
+    const std::string &title, const std::string &body
+) {
+    remove(author, permlink);
+
+    std::unordered_map<std::string, uint32_t> counts;
+    count_terms(title, title_weight, counts);
+    count_terms(body, 1, counts);
+    if (counts.empty()) {
+        return;
+    }
+
+    auto id = next_id_++;
+    auto &doc = documents_[id];
+    doc.author = author;
+    doc.permlink = permlink;
+    doc.language = language;
+    doc.terms.reserve(counts.size());
+
+    for (const auto &count: counts) {
+        auto tf = static_cast<uint16_t>(std::min<uint32_t>(count.second, UINT16_MAX));
+        auto term_id = get_term_id(count.first);
+        doc.terms.emplace_back(term_id, tf);
+        doc.length += tf;
+        postings_[term_id].emplace(id, tf);
+    }
+
+    total_length_ += doc.length;
+    by_permlink_[author + '/' + permlink] = id;
+}
+
+void inverted_index::remove(const std::string &author, const std::string &permlink) {
+    auto itr = by_permlink_.find(author + '/' + permlink);
+    if (itr == by_permlink_.end()) {
+        return;
+    }
+    remove_document(itr->second);
+    by_permlink_.erase(itr);
+}
+
+void inverted_index::remove_document(document_id_type id) {
+    auto itr = documents_.find(id);
+    if (itr == documents_.end()) {
+        return;
+    }
+    for (const auto &term: itr->second.terms) {
+        postings_[term.first].erase(id);
+    }
+    total_length_ -= itr->second.length;
+    documents_.erase(itr);
+}
+
+const search_document &inverted_index::get_document(document_id_type id) const {
+    auto itr = documents_.find(id);
+    FC_ASSERT(itr != documents_.end(), "Unknown search document ${id}", ("id", id));
+    return itr->second;
+}
+
+std::vector<search_hit> inverted_index::search(
+    const std::string &query, uint32_t limit, const filter_type &filter
+) const {
+    std::vector<search_hit> result;
+    if (documents_.empty() || limit == 0) {
+        return result;
+    }
+
+    auto query_terms = tokenize(query);
+    std::sort(query_terms.begin(), query_terms.end());
+    query_terms.erase(std::unique(query_terms.begin(), query_terms.end()), query_terms.end());
+
+    const double total_docs = documents_.size();
+    const double avg_length = double(total_length_) / total_docs;
+
+    std::unordered_map<document_id_type, double> scores;
+    for (const auto &term: query_terms) {
+        auto term_itr = term_ids_.find(term);
+        if (term_itr == term_ids_.end()) {
+            continue;
+        }
+
+        const auto &posting = postings_[term_itr->second];
+        if (posting.empty()) {
+            continue;
+        }
+
+        const double df = posting.size();
+        const double idf = std::log(1.0 + (total_docs - df + 0.5) / (df + 0.5));
+
+        for (const auto &entry: posting) {
+            const auto &doc = documents_.at(entry.first);
+            const double tf = entry.second;
+            const double norm = bm25_k1 * (1.0 - bm25_b + bm25_b * doc.length / avg_length);
+            scores[entry.first] += idf * tf * (bm25_k1 + 1.0) / (tf + norm);
+        }
+    }
+
+    result.reserve(scores.size());
+    for (const auto &score: scores) {
+        if (!filter || filter(documents_.at(score.first))) {
+            result.push_back({score.first, score.second});
+        }
+    }
+
+    auto cmp = [](const search_hit &a, const search_hit &b) {
+        return a.score > b.score || (a.score == b.score && a.id > b.id);
+    };
+
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + limit, result.end(), cmp);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), cmp);
+    }
+
+    return result;
+}
+
+void inverted_index::clear() {
+    terms_.clear();
+    term_ids_.clear();
+    postings_.clear();
+    documents_.clear();
+    by_permlink_.clear();
+    next_id_ = 0;
+    total_length_ = 0;
+}
+
+void inverted_index::save(const fc::path &file, uint32_t block_num) const {
+    index_snapshot snapshot;
+    snapshot.block_num = block_num;
+    snapshot.terms = terms_;
+    snapshot.documents.reserve(documents_.size());
+    for (const auto &doc: documents_) {
+        snapshot.documents.push_back(doc.second);
+    }
+
+    auto data = fc::raw::pack(snapshot);
+    fc::path tmp = file.string() + ".tmp";
+    {
+        std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+        FC_ASSERT(out, "Can't open search index file ${f}", ("f", tmp));
+        out.write(data.data(), data.size());
+        FC_ASSERT(out, "Can't write search index file ${f}", ("f", tmp));
+    }
+    fc::rename(tmp, file);
+}
+
+uint32_t inverted_index::load(const fc::path &file) {
+    clear();
+    if (!fc::exists(file)) {
+        return 0;
+    }
+
+    std::vector<char> data(fc::file_size(file));
+    {
+        std::ifstream in(file.string(), std::ios::binary);
+        FC_ASSERT(in, "Can't open search index file ${f}", ("f", file));
+        in.read(data.data(), data.size());
+        FC_ASSERT(in, "Can't read search index file ${f}", ("f", file));
+    }
+
+    auto snapshot = fc::raw::unpack<index_snapshot>(data);
+
+    terms_ = std::move(snapshot.terms);
+    postings_.resize(terms_.size());
+    for (term_id_type id = 0; id < terms_.size(); ++id) {
+        term_ids_.emplace(terms_[id], id);
+    }
+
+    for (auto &doc: snapshot.documents) {
+        auto id = next_id_++;
+        for (const auto &term: doc.terms) {
+            FC_ASSERT(term.first < postings_.size(), "Corrupted search index file ${f}", ("f", file));
+            postings_[term.first].emplace(id, term.second);
+        }
+        total_length_ += doc.length;
+        by_permlink_[doc.author + '/' + doc.permlink] = id;
+        documents_.emplace(id, std::move(doc));
+    }
+
+    return snapshot.block_num;
+}
+
+} } } // golos::plugins::search
@@ -0,0 +1,282 @@
+#include <golos/plugins/search/plugin.hpp>
+#include <golos/plugins/search/inverted_index.hpp>
+#include <golos/plugins/social_network/languages/language_object.hpp>
+#include <golos/plugins/social_network/api_object/comment_api_object.hpp>
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/comment_object.hpp>
+#include <golos/chain/operation_notification.hpp>
+
+#include <deque>
+#include <mutex>
+
+namespace golos {
+namespace plugins {
+namespace search {
+
+using namespace golos::protocol;
+using namespace golos::chain;
+using golos::plugins::social_network::comment_api_object;
+
+struct plugin::plugin_impl final {
+public:
+    plugin_impl() : db_(appbase::app().get_plugin<chain::plugin>().db()) {
+    }
+
+    golos::chain::database &database() {
+        return db_;
+    }
+
+    void on_block(const chain::applied_block_notification &block);
+
+    template<typename Lambda>
+    bool read_state(Lambda &&callback);
+
+    void remove_deleted_comments(uint32_t last_irreversible_block);
+
+    std::vector<search_result> search_content(
+        const std::string &query, uint32_t limit, const std::string &language) const;
+
+    struct operation_visitor;
+
+    bool index_replies = false;
+    fc::path index_file;
+    uint32_t loaded_block_num = 0;
+
+    mutable std::mutex index_mutex;
+    inverted_index index;
+
+    // a deleted comment is removed from the index when the block becomes irreversible, as a fork
+    // switch may bring the comment back; until then search_content() skips it
+    struct pending_removal {
+        uint32_t block_num;
+        account_name_type author;
+        std::string permlink;
+    };
+    std::deque<pending_removal> pending_removals;
+
+    static constexpr uint32_t max_read_attempts = 10;
+
+private:
+    golos::chain::database &db_;
+};
+
+template<typename Lambda>
+bool plugin::plugin_impl::read_state(Lambda &&callback) {
+    if (!chain::block_consumer::in_consumer_thread()) {
+        callback();
+        return true;
+    }
+    // a consumer running on its own thread takes a read lock, which can time out under a heavy load;
+    // the writer doesn't wait for consumers under the write lock, so the lock is given on a retry
+    for (uint32_t attempt = 1;; ++attempt) {
+        try {
+            db_.with_weak_read_lock(callback);
+            return true;
+        } catch (...) {
+            if (attempt >= max_read_attempts) {
+                return false;
+            }
+        }
+    }
+}
+
+struct plugin::plugin_impl::operation_visitor {
+    using result_type = void;
+
+    plugin_impl &impl;
+    uint32_t block_num;
+
+    operation_visitor(plugin_impl &i, uint32_t b) : impl(i), block_num(b) {
+    }
+
+    template<typename T>
+    void operator()(const T &) const {
+    }
+
+    void operator()(const comment_operation &op) const {
+        if (!impl.index_replies && op.parent_author != STEEMIT_ROOT_POST_PARENT) {
+            return;
+        }
+
+        // comment_operation may carry a diff, so index the resulting text of the comment
+        auto &db = impl.database();
+        std::string language;
+        std::string title;
+        std::string body;
+        bool found = false;
+        auto read_comment = [&]() {
+            const auto *comment = db.find_comment(op.author, op.permlink);
+            if (comment == nullptr) {
+                return;
+            }
+            comment_api_object c(*comment);
+            language = social_network::languages::get_language(c);
+            title = std::move(c.title);
+            body = std::move(c.body);
+            found = true;
+        };
+        // a consumer running on its own thread sees the state of a later block, which is fine for an index
+        if (!impl.read_state(read_comment)) {
+            wlog("search: can't read comment ${a}/${p} to index it, the read lock timed out",
+                 ("a", op.author)("p", op.permlink));
+            return;
+        }
+        if (!found) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(impl.index_mutex);
+        impl.index.update(op.author, op.permlink, language, title, body);
+    }
+
+    void operator()(const delete_comment_operation &op) const {
+        impl.pending_removals.push_back({block_num, op.author, op.permlink});
+    }
+};
+
+void plugin::plugin_impl::on_block(const chain::applied_block_notification &block) {
+    for (const auto &note: block.operations) {
+        note.op.visit(operation_visitor(*this, block.block_num));
+    }
+    remove_deleted_comments(block.last_irreversible_block);
+}
+
+void plugin::plugin_impl::remove_deleted_comments(uint32_t last_irreversible_block) {
+    while (!pending_removals.empty() && pending_removals.front().block_num <= last_irreversible_block) {
+        const auto &removal = pending_removals.front();
+        // the deleting block could be popped by a fork switch before it became irreversible
+        bool exists = false;
+        if (!read_state([&]() {
+            exists = db_.find_comment(removal.author, removal.permlink) != nullptr;
+        })) {
+            // retried with the next block
+            return;
+        }
+        if (!exists) {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            index.remove(removal.author, removal.permlink);
+        }
+        pending_removals.pop_front();
+    }
+}
+
+std::vector<search_result> plugin::plugin_impl::search_content(
+    const std::string &query, uint32_t limit, const std::string &language
+) const {
+    std::vector<search_result> result;
+
+    // The index isn't covered by undo sessions: skip documents whose comments were removed
+    // by a fork switch, or deleted in a block, which isn't irreversible yet
+    auto filter = [&](const search_document &doc) {
+        if (!language.empty() && doc.language != language) {
+            return false;
+        }
+        return db_.find_comment(doc.author, doc.permlink) != nullptr;
+    };
+
+    std::lock_guard<std::mutex> lock(index_mutex);
+    auto hits = index.search(query, limit, filter);
+
+    result.reserve(hits.size());
+    for (const auto &hit: hits) {
+        const auto &doc = index.get_document(hit.id);
+        const auto &comment = db_.get_comment(doc.author, doc.permlink);
+
+        search_result item;
+        item.author = doc.author;
+        item.permlink = doc.permlink;
+        item.title = to_string(comment.title);
+        item.language = doc.language;
+        item.score = hit.score;
+        result.push_back(std::move(item));
+    }
+
+    return result;
+}
+
+DEFINE_API(plugin, search_content) {
+    FC_ASSERT(args.args->size() >= 1 && args.args->size() <= 3, "Expected 1-3 arguments, was ${n}",
+              ("n", args.args->size()));
+    auto query = args.args->at(0).as<std::string>();
+    uint32_t limit = 20;
+    std::string language;
+    if (args.args->size() > 1) {
+        limit = args.args->at(1).as<uint32_t>();
+    }
+    if (args.args->size() > 2) {
+        language = args.args->at(2).as<std::string>();
+    }
+    FC_ASSERT(limit <= 100, "limit can't be more than 100");
+
+    auto &db = my->database();
+    return db.with_weak_read_lock([&]() {
+        return my->search_content(query, limit, language);
+    });
+}
+
+plugin::plugin() {
+}
+
+plugin::~plugin() {
+}
+
+void plugin::set_program_options(
+    boost::program_options::options_description &cli,
+    boost::program_options::options_description &cfg
+) {
+    cfg.add_options()
+        ("search-index-file", boost::program_options::value<boost::filesystem::path>()->default_value("search-index.bin"),
+            "the location of the full-text search index file (absolute path or relative to application data dir)")
+        ("search-index-replies", boost::program_options::value<bool>()->default_value(false),
+            "index replies in addition to top-level posts");
+}
+
+void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
+    ilog("Initializing search plugin");
+
+    my.reset(new plugin_impl);
+
+    auto index_file = options.at("search-index-file").as<boost::filesystem::path>();
+    if (index_file.is_relative()) {
+        my->index_file = appbase::app().data_dir() / index_file;
+    } else {
+        my->index_file = index_file;
+    }
+    my->index_replies = options.at("search-index-replies").as<bool>();
+
+    if (options.count("replay-blockchain") && options.at("replay-blockchain").as<bool>()) {
+        ilog("search: replay requested, the index will be rebuilt");
+        fc::remove_all(my->index_file);
+    } else {
+        my->loaded_block_num = my->index.load(my->index_file);
+    }
+
+    appbase::app().get_plugin<chain::plugin>().add_block_consumer(name(), [&](const chain::applied_block_notification &block) {
+        my->on_block(block);
+    });
+
+    JSON_RPC_REGISTER_API(name());
+}
+
+void plugin::plugin_startup() {
+    auto head_block_num = my->database().head_block_num();
+    if (my->loaded_block_num != head_block_num) {
+        wlog("search: index was saved at block ${i}, but head block is ${h}, run with --replay-blockchain to rebuild it",
+             ("i", my->loaded_block_num)("h", head_block_num));
+    }
+    ilog("search: ${n} documents in index", ("n", my->index.size()));
+}
+
+void plugin::plugin_shutdown() {
+    appbase::app().get_plugin<chain::plugin>().wait_block_consumers();
+
+    // the saved index matches the head block, which the node continues from
+    auto head_block_num = my->database().head_block_num();
+    my->remove_deleted_comments(head_block_num);
+    std::lock_guard<std::mutex> lock(my->index_mutex);
+    my->index.save(my->index_file, head_block_num);
+    ilog("search: saved ${n} documents at block ${b}", ("n", my->index.size())("b", head_block_num));
+}
+
+} } } // golos::plugins::search
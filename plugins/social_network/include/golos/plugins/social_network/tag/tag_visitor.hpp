@@ -11,10 +11,11 @@ namespace golos {
             namespace tags {
 
                 struct operation_visitor {
-                    operation_visitor(database &db);;
+                    operation_visitor(database &db, const tag_index_set &indices);
                     typedef void result_type;
 
                     database &_db;
+                    const tag_index_set &_indices;
 
                     void remove_stats(const tag_object &tag, const tag_stats_object &stats) const;
 
@@ -22,6 +23,10 @@ namespace golos {
 
                     void remove_tag(const tag_object &tag) const;
 
+                    void remove_tag_sort(const tag_object &tag) const;
+
+                    void update_tag_sort(const tag_object &tag, double hot, double trending) const;
+
                     const tag_stats_object &get_stats(const std::string &tag) const;
 
                     comment_metadata filter_tags(const comment_object &c) const;
@@ -47,7 +47,9 @@ namespace golos {
                 tag_object_type = (TAG_SPACE_ID << 8),
                 tag_stats_object_type = (TAG_SPACE_ID << 8) + 1,
                 peer_stats_object_type = (TAG_SPACE_ID << 8) + 2,
-                author_tag_stats_object_type = (TAG_SPACE_ID << 8) + 3
+                author_tag_stats_object_type = (TAG_SPACE_ID << 8) + 3,
+                tag_settings_object_type = (TAG_SPACE_ID << 8) + 4,
+                tag_sort_object_type = (TAG_SPACE_ID << 8) + 5
             };
 
             /**
@@ -80,8 +82,6 @@ namespace golos {
                 int64_t net_rshares = 0;
                 int32_t net_votes = 0;
                 int32_t children = 0;
-                double hot = 0;
-                double trending = 0;
 
                 share_type promoted_balance = 0;
 
@@ -111,23 +111,6 @@ namespace golos {
                 virtual bool operator()(const T &first, const T &second) const = 0;
             };
 
-            class by_cashout : public comparable_index<tag_object> {
-            public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<tag_name_type>()(first.name, second.name) &&
-                           std::less<time_point_sec>()(first.cashout, second.cashout) &&
-                           std::less<tag_id_type>()(first.id, second.id);
-                }
-            }; /// all posts regardless of depth
-
-            class by_net_rshares : public comparable_index<tag_object> {
-            public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::greater<int64_t>()(first.net_rshares, second.net_rshares) &&
-                           std::less<tag_id_type>()(first.id, second.id);
-                }
-            }; /// all comments regardless of depth
-
             class by_parent_created : public comparable_index<tag_object> {
             public:
                 virtual bool operator()(const tag_object &first, const tag_object &second) const override {
@@ -137,217 +120,266 @@ namespace golos {
                 }
             };
 
-            class by_parent_active : public comparable_index<tag_object> {
+            class by_author_comment : public comparable_index<tag_object> {
             public:
                 virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<time_point_sec>()(first.active, second.active) &&
+                    return std::less<account_object::id_type>()(first.author, second.author) &&
+                           std::less<comment_object::id_type>()(first.comment, second.comment) &&
                            std::less<tag_id_type>()(first.id, second.id);
                 }
             };
 
-            class by_parent_promoted : public comparable_index<tag_object> {
-            public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<share_type>()(first.promoted_balance, second.promoted_balance) &&
-                           std::less<tag_id_type>()(first.id, second.id);
-                }
-            };
+            struct by_comment;
+            struct by_tag;
 
-            class by_parent_net_rshares : public comparable_index<tag_object> {
-            public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<int64_t>()(first.net_rshares, second.net_rshares) &&
-                           std::less<tag_id_type>()(first.id, second.id);
-                }
-            }; /// all top level posts by direct pending payout
+            /**
+             *  Only the orderings which are needed by every node are kept here: none of their keys change on a vote.
+             *  Orderings used by optional API methods live in @ref tag_sort_index.
+             */
+            typedef multi_index_container<tag_object,
+                    indexed_by<ordered_unique<tag<by_id>, member<tag_object, tag_object::id_type, &tag_object::id>>,
+                            ordered_unique<tag<by_comment>, composite_key<tag_object,
+                                    member<tag_object, comment_object::id_type, &tag_object::comment>,
+                                    member<tag_object, tag_object::id_type, &tag_object::id> >,
+                                    composite_key_compare<std::less<comment_object::id_type>, std::less<tag_id_type>>>,
+                            ordered_unique<tag<by_author_comment>, composite_key<tag_object,
+                                    member<tag_object, account_object::id_type, &tag_object::author>,
+                                    member<tag_object, comment_object::id_type, &tag_object::comment>,
+                                    member<tag_object, tag_id_type, &tag_object::id> >,
+                                    composite_key_compare<std::less<account_object::id_type>,
+                                            std::less<comment_object::id_type>, std::less<tag_id_type>>>,
+                            ordered_unique<tag<by_parent_created>, composite_key<tag_object,
 
-            class by_parent_net_votes : public comparable_index<tag_object> {
+                                    member<tag_object, tag_name_type, &tag_object::name>,
+                                    member<tag_object, comment_object::id_type, &tag_object::parent>,
+
+                                    member<tag_object, time_point_sec, &tag_object::created>,
+                                    member<tag_object, tag_id_type, &tag_object::id> >,
+                                    composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
+                                            std::greater<time_point_sec>, std::less<tag_id_type>>> >,
+                    allocator<tag_object> > tag_index;
+
+            /**
+             *  Sort keys of a tag_object which change on votes: the hot and trending scores and copies of the keys
+             *  used by get_discussions_by_active, _by_cashout, _by_payout, _by_votes, _by_children and _by_promoted.
+             *  They are kept apart from the tag_object, so that a vote relinks only this object instead of the whole
+             *  tag_index, and all of them are kept in one object, so that a vote modifies it once.
+             *
+             *  The index is created only if one of these methods is enabled, see @ref tag_index_set. The keys of
+             *  the disabled methods stay zero, so their orderings are never relinked.
+             *
+             *  Both scores are `sign * log10(net_rshares / S) + created / T`: the time term is fixed at creation and
+             *  acts as a global decay offset, so the ranking never needs to be recalculated as time passes.
+             *  The scores change only when a vote moves net_rshares across a multiple of S, as net_rshares / S is
+             *  an integer division, and never change for the ancestors of a voted reply.
+             */
+            class tag_sort_object : public object<tag_sort_object_type, tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<int32_t>()(first.net_votes, second.net_votes) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                template<typename Constructor, typename Allocator>
+                tag_sort_object(Constructor &&c, allocator<Allocator> a) {
+                    c(*this);
                 }
-            }; /// all top level posts by direct votes
 
-            class by_parent_children_rshares2 : public comparable_index<tag_object> {
-            public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<fc::uint128_t>()(first.children_rshares2, second.children_rshares2) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                tag_sort_object() {
                 }
-            }; /// all top level posts by total cumulative payout (aka payout)
 
-            class by_parent_trending : public comparable_index<tag_object> {
+                id_type id;
+
+                tag_id_type tag;
+                tag_name_type name;
+                comment_object::id_type parent;
+                comment_object::id_type comment;
+                time_point_sec active;
+                time_point_sec cashout;
+                int64_t net_rshares = 0;
+                int32_t net_votes = 0;
+                int32_t children = 0;
+                share_type promoted_balance = 0;
+                double hot = 0;
+                double trending = 0;
+            };
+
+            typedef object_id<tag_sort_object> tag_sort_id_type;
+
+            class by_parent_trending : public comparable_index<tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
                     return std::less<comment_object::id_type>()(first.parent, second.parent) &&
                            std::greater<double>()(first.trending, second.trending) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                           std::less<tag_sort_id_type>()(first.id, second.id);
                 }
             }; /// all top level posts by total cumulative payout (aka payout)
 
-            class by_parent_children : public comparable_index<tag_object> {
+            class by_parent_hot : public comparable_index<tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
                     return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<int32_t>()(first.children, second.children) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                           std::greater<double>()(first.hot, second.hot) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
                 }
-            }; /// all top level posts with the most discussion (replies at all levels)
+            };
+
+            struct by_tag_object;
 
-            class by_parent_hot : public comparable_index<tag_object> {
+            class by_cashout : public comparable_index<tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
-                           std::greater<double>()(first.hot, second.hot) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
+                    return std::less<tag_name_type>()(first.name, second.name) &&
+                           std::less<time_point_sec>()(first.cashout, second.cashout) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
                 }
-            };
+            }; /// all posts regardless of depth
 
-            class by_author_parent_created : public comparable_index<tag_object> {
+            class by_net_rshares : public comparable_index<tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<account_object::id_type>()(first.author, second.author) &&
-                           std::greater<time_point_sec>()(first.created, second.created) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
+                    return std::greater<int64_t>()(first.net_rshares, second.net_rshares) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
                 }
-            };  /// all blog posts by author with tag
+            }; /// all comments regardless of depth
 
-            class by_author_comment : public comparable_index<tag_object> {
+            class by_parent_active : public comparable_index<tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<account_object::id_type>()(first.author, second.author) &&
-                           std::less<comment_object::id_type>()(first.comment, second.comment) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
+                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
+                           std::greater<time_point_sec>()(first.active, second.active) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
                 }
             };
 
-            class by_reward_fund_net_rshares : public comparable_index<tag_object> {
+            class by_parent_promoted : public comparable_index<tag_sort_object> {
             public:
-                virtual bool operator()(const tag_object &first, const tag_object &second) const override {
-                    return std::less<bool>()(first.is_post(), second.is_post()) &&
-                           std::greater<int64_t>()(first.net_rshares, second.net_rshares) &&
-                           std::less<tag_id_type>()(first.id, second.id);
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
+                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
+                           std::greater<share_type>()(first.promoted_balance, second.promoted_balance) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
                 }
             };
 
-            struct by_comment;
-            struct by_tag;
-
-            typedef multi_index_container<tag_object,
-                    indexed_by<ordered_unique<tag<by_id>, member<tag_object, tag_object::id_type, &tag_object::id>>,
-                            ordered_unique<tag<by_comment>, composite_key<tag_object,
-                                    member<tag_object, comment_object::id_type, &tag_object::comment>,
-                                    member<tag_object, tag_object::id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<comment_object::id_type>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_author_comment>, composite_key<tag_object,
-                                    member<tag_object, account_object::id_type, &tag_object::author>,
-                                    member<tag_object, comment_object::id_type, &tag_object::comment>,
-                                    member<tag_object, tag_id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<account_object::id_type>,
-                                            std::less<comment_object::id_type>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_created>, composite_key<tag_object,
-
-                                    member<tag_object, tag_name_type, &tag_object::name>,
-                                    member<tag_object, comment_object::id_type, &tag_object::parent>,
-
-                                    member<tag_object, time_point_sec, &tag_object::created>,
-                                    member<tag_object, tag_id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<time_point_sec>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_active>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, comment_object::id_type, &tag_object::parent>,
-                                            member<tag_object, time_point_sec, &tag_object::active>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<time_point_sec>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_promoted>, composite_key<tag_object,
+            class by_parent_net_votes : public comparable_index<tag_sort_object> {
+            public:
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
+                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
+                           std::greater<int32_t>()(first.net_votes, second.net_votes) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
+                }
+            }; /// all top level posts by direct votes
 
-                                    member<tag_object, tag_name_type, &tag_object::name>,
-                                    member<tag_object, comment_object::id_type, &tag_object::parent>,
+            class by_parent_children : public comparable_index<tag_sort_object> {
+            public:
+                virtual bool operator()(const tag_sort_object &first, const tag_sort_object &second) const override {
+                    return std::less<comment_object::id_type>()(first.parent, second.parent) &&
+                           std::greater<int32_t>()(first.children, second.children) &&
+                           std::less<tag_sort_id_type>()(first.id, second.id);
+                }
+            }; /// all top level posts with the most discussion (replies at all levels)
 
-                                    member<tag_object, share_type, &tag_object::promoted_balance>,
-                                    member<tag_object, tag_id_type, &tag_object::id> >,
+            typedef multi_index_container<tag_sort_object,
+                    indexed_by<ordered_unique<tag<by_id>,
+                            member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id>>,
+                            ordered_unique<tag<by_tag_object>,
+                                    member<tag_sort_object, tag_id_type, &tag_sort_object::tag>>,
+                            ordered_unique<tag<by_comment>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::comment>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
+                                    composite_key_compare<std::less<comment_object::id_type>,
+                                            std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_parent_hot>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::parent>,
+                                    member<tag_sort_object, double, &tag_sort_object::hot>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<share_type>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_net_rshares>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, comment_object::id_type, &tag_object::parent>,
-                                            member<tag_object, int64_t, &tag_object::net_rshares>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::greater<double>, std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_parent_trending>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::parent>,
+                                    member<tag_sort_object, double, &tag_sort_object::trending>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<int64_t>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_net_votes>, composite_key<tag_object,
-
-                                    member<tag_object, tag_name_type, &tag_object::name>,
-                                    member<tag_object, comment_object::id_type, &tag_object::parent>,
-
-                                    member<tag_object, int32_t, &tag_object::net_votes>,
-                                    member<tag_object, tag_id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<int32_t>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_children>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, comment_object::id_type, &tag_object::parent>,
-                                            member<tag_object, int32_t, &tag_object::children>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::greater<double>, std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_parent_active>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::parent>,
+                                    member<tag_sort_object, time_point_sec, &tag_sort_object::active>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<int32_t>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_hot>, composite_key<tag_object,
-
-                                    member<tag_object, tag_name_type, &tag_object::name>,
-                                    member<tag_object, comment_object::id_type, &tag_object::parent>,
-                                    member<tag_object, double, &tag_object::hot>,
-                                    member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::greater<time_point_sec>, std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_parent_promoted>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::parent>,
+                                    member<tag_sort_object, share_type, &tag_sort_object::promoted_balance>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<double>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_trending>, composite_key<tag_object,
-
-                                    member<tag_object, tag_name_type, &tag_object::name>,
-                                    member<tag_object, comment_object::id_type, &tag_object::parent>,
-                                    member<tag_object, double, &tag_object::trending>,
-                                    member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::greater<share_type>, std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_parent_net_votes>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::parent>,
+                                    member<tag_sort_object, int32_t, &tag_sort_object::net_votes>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<double>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_parent_children_rshares2>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, comment_object::id_type, &tag_object::parent>,
-                                            member<tag_object, fc::uint128_t, &tag_object::children_rshares2>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::greater<int32_t>, std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_parent_children>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, comment_object::id_type, &tag_sort_object::parent>,
+                                    member<tag_sort_object, int32_t, &tag_sort_object::children>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<comment_object::id_type>,
-                                            std::greater<fc::uint128_t>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_cashout>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, time_point_sec, &tag_object::cashout>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::greater<int32_t>, std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_cashout>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, time_point_sec, &tag_sort_object::cashout>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::less<time_point_sec>,
-                                            std::less<tag_id_type>>>, ordered_unique<tag<by_net_rshares>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, int64_t, &tag_object::net_rshares>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
+                                            std::less<tag_sort_id_type>>>,
+                            ordered_unique<tag<by_net_rshares>, composite_key<tag_sort_object,
+                                    member<tag_sort_object, tag_name_type, &tag_sort_object::name>,
+                                    member<tag_sort_object, int64_t, &tag_sort_object::net_rshares>,
+                                    member<tag_sort_object, tag_sort_id_type, &tag_sort_object::id> >,
                                     composite_key_compare<std::less<tag_name_type>, std::greater<int64_t>,
-                                            std::less<tag_id_type>>>, ordered_unique<tag<by_author_parent_created>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            member<tag_object, account_object::id_type, &tag_object::author>,
-
-                                            member<tag_object, time_point_sec, &tag_object::created>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<tag_name_type>, std::less<account_object::id_type>,
-                                            std::greater<time_point_sec>, std::less<tag_id_type>>>,
-                            ordered_unique<tag<by_reward_fund_net_rshares>,
-                                    composite_key<tag_object, member<tag_object, tag_name_type, &tag_object::name>,
-                                            const_mem_fun<tag_object, bool, &tag_object::is_post>,
-                                            member<tag_object, int64_t, &tag_object::net_rshares>,
-                                            member<tag_object, tag_id_type, &tag_object::id> >,
-                                    composite_key_compare<std::less<tag_name_type>, std::less<bool>,
-                                            std::greater<int64_t>, std::less<tag_id_type>>> >,
-                    allocator<tag_object> > tag_index;
+                                            std::less<tag_sort_id_type>>> >,
+                    allocator<tag_sort_object> > tag_sort_index;
+
+            /**
+             *  Secondary tag indices which are created and maintained only when one of the API methods using them
+             *  is enabled. @ref tag_sort_index is created if any of them is enabled.
+             */
+            struct tag_index_set {
+                bool scores = true;  ///< hot and trending scores: get_discussions_by_trending, get_discussions_by_hot
+                bool sorting = true; ///< other sort keys: active, cashout, payout, votes, children, promoted
+
+                bool any() const {
+                    return scores || sorting;
+                }
+
+                bool operator==(const tag_index_set &other) const {
+                    return scores == other.scores && sorting == other.sorting;
+                }
+            };
+
+            /**
+             *  The tag indices the state was built with. Changing them requires a replay, as the indices
+             *  aren't filled for already applied blocks.
+             */
+            class tag_settings_object : public object<tag_settings_object_type, tag_settings_object> {
+            public:
+                template<typename Constructor, typename Allocator>
+                tag_settings_object(Constructor &&c, allocator<Allocator> a) {
+                    c(*this);
+                }
+
+                tag_settings_object() {
+                }
+
+                id_type id;
+
+                tag_index_set indices;
+            };
+
+            typedef multi_index_container<tag_settings_object,
+                    indexed_by<ordered_unique<tag<by_id>,
+                            member<tag_settings_object, tag_settings_object::id_type, &tag_settings_object::id>>>,
+                    allocator<tag_settings_object> > tag_settings_index;
 
             /**
              *  The purpose of this index is to quickly identify how popular various tags by maintaining various sums over
@@ -547,9 +579,17 @@ namespace golos {
 
 
 //FC_REFLECT((golos::plugins::social_network::tags::tag_object), (id)(name)(created)(active)(cashout)(net_rshares)(net_votes)(hot)(promoted_balance)(children)(children_rshares2)(mode)(author)(parent)(comment))
-FC_REFLECT((golos::plugins::social_network::tags::tag_object), (id)(name)(created)(active)(cashout)(net_rshares)(net_votes)(hot)(promoted_balance)(children)(children_rshares2)(author)(parent)(comment))
+FC_REFLECT((golos::plugins::social_network::tags::tag_object), (id)(name)(created)(active)(cashout)(net_rshares)(net_votes)(promoted_balance)(children)(children_rshares2)(author)(parent)(comment))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::social_network::tags::tag_object, golos::plugins::social_network::tags::tag_index)
 
+FC_REFLECT((golos::plugins::social_network::tags::tag_index_set), (scores)(sorting))
+
+FC_REFLECT((golos::plugins::social_network::tags::tag_settings_object), (id)(indices))
+CHAINBASE_SET_INDEX_TYPE(golos::plugins::social_network::tags::tag_settings_object, golos::plugins::social_network::tags::tag_settings_index)
+
+FC_REFLECT((golos::plugins::social_network::tags::tag_sort_object), (id)(tag)(name)(parent)(comment)(active)(cashout)(net_rshares)(net_votes)(children)(promoted_balance)(hot)(trending))
+CHAINBASE_SET_INDEX_TYPE(golos::plugins::social_network::tags::tag_sort_object, golos::plugins::social_network::tags::tag_sort_index)
+
 FC_REFLECT((golos::plugins::social_network::tags::tag_stats_object), (id)(tag)(total_children_rshares2)(total_payout)(net_votes)(top_posts)(comments))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::social_network::tags::tag_stats_object, golos::plugins::social_network::tags::tag_stats_index)
 
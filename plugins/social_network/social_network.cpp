@@ -1,4 +1,5 @@
 #include <boost/program_options/options_description.hpp>
+#include <boost/algorithm/string.hpp>
 #include <golos/plugins/social_network/social_network.hpp>
 #include <golos/plugins/social_network/tag/tags_object.hpp>
 #include <golos/plugins/social_network/languages/language_object.hpp>
@@ -8,6 +9,7 @@
 #include <golos/plugins/social_network/api_object/vote_state.hpp>
 #include <golos/plugins/social_network/languages/language_object.hpp>
 #include <golos/chain/steem_objects.hpp>
+#include <golos/plugins/follow/computed_feed.hpp>
 
 // These visitors creates additional tables, we don't really need them in LOW_MEM mode
 #ifndef IS_LOW_MEM
@@ -99,6 +101,38 @@ namespace golos {
 
                 void startup() {
                     follow_api_ = appbase::app().find_plugin<golos::plugins::follow::plugin>();
+#ifndef IS_LOW_MEM
+                    check_tag_settings();
+#endif
+                }
+
+                void store_tag_settings() {
+                    auto &db = database();
+                    if (db.find<tags::tag_settings_object>()) {
+                        return;
+                    }
+                    db.create<tags::tag_settings_object>([&](tags::tag_settings_object &o) {
+                        o.indices = tag_indices;
+                    });
+                }
+
+                /// tag indices aren't filled for already applied blocks, so they can be changed only by a replay
+                void check_tag_settings() {
+                    auto &db = database();
+                    db.with_strong_write_lock([&]() {
+                        const auto *settings = db.find<tags::tag_settings_object>();
+                        if (!settings) {
+                            FC_ASSERT(db.head_block_num() == 0,
+                                      "Tag indices were built by an older version, restart with --replay-blockchain");
+                            store_tag_settings();
+                        } else {
+                            FC_ASSERT(settings->indices == tag_indices,
+                                      "Tag indices were built for ${built}, but the tags-discussions-api option needs "
+                                      "${needed}, restart with --replay-blockchain",
+                                      ("built", settings->indices)("needed", tag_indices));
+                        }
+                    });
+                    tag_settings_checked = true;
                 }
 
                 void on_operation(const operation_notification &note){
@@ -106,7 +140,7 @@ namespace golos {
                         /// plugins shouldn't ever throw
 #ifndef IS_LOW_MEM
                         note.op.visit(languages::operation_visitor(database(), cache_languages));
-                        note.op.visit(tags::operation_visitor(database()));
+                        note.op.visit(tags::operation_visitor(database(), tag_indices));
 #endif
                     } catch (const fc::exception &e) {
                         edump((e.to_detail_string()));
@@ -220,6 +254,18 @@ namespace golos {
                     const std::string &author, const std::string &permlink
                 ) const;
 
+                std::vector<discussion> get_content_replies(
+                    const std::string &author, const std::string &permlink,
+                    const std::string &start_author, const std::string &start_permlink, uint32_t limit
+                ) const;
+
+                std::vector<discussion> get_all_content_replies(
+                    const std::string &author, const std::string &permlink, uint32_t depth,
+                    const std::string &start_author, const std::string &start_permlink, uint32_t limit
+                ) const;
+
+                bool is_reply_of(const comment_object &reply, const comment_object &parent) const;
+
                 std::vector<tag_api_object> get_trending_tags(std::string after, uint32_t limit) const;
 
                 std::vector<std::pair<std::string, uint32_t>> get_tags_used_by_author(const std::string &author) const;
@@ -276,7 +322,19 @@ namespace golos {
 
                 get_languages_r get_languages() ;
 
+                void check_discussions_api(const std::string &sort) const {
+                    FC_ASSERT(discussions_api.empty() || discussions_api.count(sort),
+                              "get_discussions_by_${sort} is disabled on this node, see the tags-discussions-api option",
+                              ("sort", sort));
+                }
+
                 std::set<std::string> cache_languages;
+
+                /// sort orders of get_discussions_by_* served by node, empty means all of them
+                std::set<std::string> discussions_api;
+                tags::tag_index_set tag_indices;
+                /// until then the state may be rebuilt by a replay, which stores the current settings
+                bool tag_settings_checked = false;
             private:
                 golos::chain::database& database_;
                 golos::plugins::follow::plugin* follow_api_ = nullptr;
@@ -316,22 +374,61 @@ namespace golos {
 
             }
 
-            void social_network_t::set_program_options(boost::program_options::options_description &, boost::program_options::options_description &config_file_options) {
-
+            void social_network_t::set_program_options(boost::program_options::options_description &cli, boost::program_options::options_description &cfg) {
+                cli.add_options()
+                    ("tags-discussions-api", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(),
+                        "Sort orders of get_discussions_by_* to serve: created, trending, hot, active, cashout, payout, votes, "
+                        "children, promoted. Tag indices of disabled orders are not built, the node refuses to start "
+                        "if the option is changed without a replay. Default: all");
+                cfg.add(cli);
             }
 
             void social_network_t::plugin_initialize(const boost::program_options::variables_map &options) {
                 pimpl.reset(new impl());
+
+                if (options.count("tags-discussions-api")) {
+                    for (auto &arg : options.at("tags-discussions-api").as<std::vector<std::string>>()) {
+                        std::vector<std::string> sorts;
+                        boost::split(sorts, arg, boost::is_any_of(" \t,"));
+
+                        for (const std::string &sort : sorts) {
+                            if (sort.size()) {
+                                pimpl->discussions_api.insert(sort);
+                            }
+                        }
+                    }
+
+                    auto enabled = [&](const std::string &sort) {
+                        return pimpl->discussions_api.count(sort) != 0;
+                    };
+
+                    pimpl->tag_indices.scores = enabled("trending") || enabled("hot");
+                    pimpl->tag_indices.sorting = enabled("active") || enabled("cashout") || enabled("payout") ||
+                                                 enabled("votes") || enabled("children") || enabled("promoted");
+
+                    ilog("social_network: serving discussions by ${s}", ("s", pimpl->discussions_api));
+                }
 // Disable index creation for tag and language visitors
 #ifndef IS_LOW_MEM
                 auto &db = pimpl->database();
+                // not a block consumer: tags are chainbase objects changed in the undo session of the block,
+                // and their scores are computed from the comment right after the operation
                 pimpl->database().post_apply_operation.connect([&](const operation_notification &note) {
                     pimpl->on_operation(note);
                 });
+                pimpl->database().pre_apply_block.connect([&](const golos::protocol::signed_block &) {
+                    if (!pimpl->tag_settings_checked) {
+                        pimpl->store_tag_settings();
+                    }
+                });
                 add_plugin_index<tags::tag_index>(db);
                 add_plugin_index<tags::tag_stats_index>(db);
                 add_plugin_index<tags::peer_stats_index>(db);
                 add_plugin_index<tags::author_tag_stats_index>(db);
+                add_plugin_index<tags::tag_settings_index>(db);
+                if (pimpl->tag_indices.any()) {
+                    add_plugin_index<tags::tag_sort_index>(db);
+                }
 
                 add_plugin_index<languages::language_index>(db);
                 add_plugin_index<languages::language_stats_index>(db);
@@ -389,12 +486,60 @@ namespace golos {
                 return result;
             }
 
+            std::vector<discussion> social_network_t::impl::get_content_replies(
+                const std::string &author, const std::string &permlink,
+                const std::string &start_author, const std::string &start_permlink, uint32_t limit
+            ) const {
+                FC_ASSERT(limit <= 100);
+                std::vector<discussion> result;
+
+                const auto &parent = database().get_comment(author, permlink);
+                const auto &by_parent_idx = database().get_index<comment_index>().indices().get<by_parent>();
+                auto itr = by_parent_idx.lower_bound(boost::make_tuple(parent.author, permlink));
+                if (!start_author.empty() || !start_permlink.empty()) {
+                    const auto &start = database().get_comment(start_author, start_permlink);
+                    FC_ASSERT(start.parent_author == parent.author && start.parent_permlink == parent.permlink,
+                        "${a}/${p} is not a reply to ${pa}/${pp}",
+                        ("a", start_author)("p", start_permlink)("pa", author)("pp", permlink));
+                    itr = by_parent_idx.iterator_to(start);
+                }
+
+                result.reserve(limit);
+                while (
+                    itr != by_parent_idx.end() && result.size() < limit &&
+                    itr->parent_author == parent.author && itr->parent_permlink == parent.permlink
+                ) {
+                    result.emplace_back(*itr);
+                    result.back().active_votes = get_active_votes(result.back().author, result.back().permlink);
+                    set_pending_payout(result.back());
+                    ++itr;
+                }
+                return result;
+            }
+
+            /**
+             *  Without the optional arguments returns all direct replies to author/permlink.
+             *
+             *  The paginated form is (author, permlink, start_author, start_permlink, limit):
+             *  the first call should pass empty start_author and start_permlink,
+             *  subsequent calls should pass the author and permlink of the last returned reply,
+             *  which will be the first one in the next page.
+             */
             DEFINE_API(social_network_t, get_content_replies) {
-                CHECK_ARG_SIZE(2)
+                FC_ASSERT(args.args->size() == 2 || args.args->size() == 5, "Expected 2 or 5 arguments, was ${n}",
+                          ("n", args.args->size()));
                 auto author = args.args->at(0).as<string>();
                 auto permlink = args.args->at(1).as<string>();
+                if (args.args->size() == 2) {
+                    return pimpl->database().with_weak_read_lock([&]() {
+                        return pimpl->get_content_replies(author, permlink);
+                    });
+                }
+                auto start_author = args.args->at(2).as<string>();
+                auto start_permlink = args.args->at(3).as<string>();
+                auto limit = args.args->at(4).as<uint32_t>();
                 return pimpl->database().with_weak_read_lock([&]() {
-                    return pimpl->get_content_replies(author, permlink);
+                    return pimpl->get_content_replies(author, permlink, start_author, start_permlink, limit);
                 });
             }
 
@@ -415,12 +560,104 @@ namespace golos {
                 return result;
             }
 
+            bool social_network_t::impl::is_reply_of(const comment_object &reply, const comment_object &parent) const {
+                if (reply.root_comment != parent.root_comment || reply.depth <= parent.depth) {
+                    return false;
+                }
+                if (parent.id == parent.root_comment) {
+                    return true;
+                }
+
+                const auto *itr = &reply;
+                while (itr->depth > parent.depth) {
+                    itr = &database().get_comment(itr->parent_author, itr->parent_permlink);
+                }
+                return itr->id == parent.id;
+            }
+
+            std::vector<discussion> social_network_t::impl::get_all_content_replies(
+                const std::string &author, const std::string &permlink, uint32_t depth,
+                const std::string &start_author, const std::string &start_permlink, uint32_t limit
+            ) const {
+                FC_ASSERT(limit <= 100);
+                std::vector<discussion> result;
+
+                const auto &parent = database().get_comment(author, permlink);
+                const auto &by_parent_idx = database().get_index<comment_index>().indices().get<by_parent>();
+                const uint32_t max_depth = depth ? parent.depth + depth : std::numeric_limits<uint32_t>::max();
+
+                // the tree is walked depth-first over by_parent, so only the returned replies are visited;
+                // each level holds a comment and the iterator to its next reply
+                using reply_iterator = decltype(by_parent_idx.begin());
+                std::vector<std::pair<const comment_object *, reply_iterator>> levels;
+                if (!start_author.empty() || !start_permlink.empty()) {
+                    const auto &start = database().get_comment(start_author, start_permlink);
+                    FC_ASSERT(is_reply_of(start, parent) && start.depth <= max_depth,
+                        "${a}/${p} is not a reply to ${pa}/${pp}",
+                        ("a", start_author)("p", start_permlink)("pa", author)("pp", permlink));
+                    // restore the walk at start from the chain of its parents
+                    for (const auto *itr = &start; itr->id != parent.id;) {
+                        const auto &itr_parent = database().get_comment(itr->parent_author, itr->parent_permlink);
+                        levels.emplace_back(&itr_parent, by_parent_idx.iterator_to(*itr));
+                        itr = &itr_parent;
+                    }
+                    std::reverse(levels.begin(), levels.end());
+                } else {
+                    levels.emplace_back(&parent, by_parent_idx.lower_bound(boost::make_tuple(parent.author, permlink)));
+                }
+
+                result.reserve(limit);
+                while (!levels.empty() && result.size() < limit) {
+                    auto &level = levels.back();
+                    if (level.second == by_parent_idx.end() ||
+                        level.second->parent_author != level.first->author ||
+                        level.second->parent_permlink != level.first->permlink
+                    ) {
+                        levels.pop_back();
+                        continue;
+                    }
+                    const auto &reply = *level.second;
+                    ++level.second;
+
+                    result.emplace_back(reply);
+                    result.back().active_votes = get_active_votes(result.back().author, result.back().permlink);
+                    set_pending_payout(result.back());
+
+                    if (reply.depth < max_depth && reply.children > 0) {
+                        levels.emplace_back(&reply, by_parent_idx.lower_bound(
+                            boost::make_tuple(reply.author, to_string(reply.permlink))));
+                    }
+                }
+                return result;
+            }
+
+            /**
+             *  Without the optional arguments returns the whole reply tree of author/permlink,
+             *  with discussion::replies filled for each comment.
+             *
+             *  The paginated form is (author, permlink, depth, start_author, start_permlink, limit):
+             *  replies not deeper than depth levels below author/permlink (0 - any depth) are returned depth-first,
+             *  each comment is followed by its replies in creation order, with discussion::replies left empty,
+             *  use parent_author/parent_permlink to build the tree.
+             *  The first call should pass empty start_author and start_permlink, subsequent calls should
+             *  pass the author and permlink of the last returned reply, which will be the first one in the next page.
+             */
             DEFINE_API(social_network_t, get_all_content_replies) {
-                CHECK_ARG_SIZE(2)
+                FC_ASSERT(args.args->size() == 2 || args.args->size() == 6, "Expected 2 or 6 arguments, was ${n}",
+                          ("n", args.args->size()));
                 auto author = args.args->at(0).as<string>();
                 auto permlink = args.args->at(1).as<string>();
+                if (args.args->size() == 2) {
+                    return pimpl->database().with_weak_read_lock([&]() {
+                        return pimpl->get_all_content_replies(author, permlink);
+                    });
+                }
+                auto depth = args.args->at(2).as<uint32_t>();
+                auto start_author = args.args->at(3).as<string>();
+                auto start_permlink = args.args->at(4).as<string>();
+                auto limit = args.args->at(5).as<uint32_t>();
                 return pimpl->database().with_weak_read_lock([&]() {
-                    return pimpl->get_all_content_replies(author, permlink);
+                    return pimpl->get_all_content_replies(author, permlink, depth, start_author, start_permlink, limit);
                 });
             }
 
@@ -498,10 +735,51 @@ namespace golos {
             ) const {
                 std::vector<discussion> result;
 
+                const auto &tag_idx = database().get_index<DatabaseIndex>().indices().template get<DiscussionIndex>();
+
+                auto is_selected = [&](comment_object::id_type comment) {
+                    if (select_set.empty()) {
+                        return true;
+                    }
+                    for (auto tag_itr = tag_idx.lower_bound(comment);
+                         tag_itr != tag_idx.end() && tag_itr->comment == comment; ++tag_itr) {
+                        if (select_set.find(tag_itr->name) != select_set.end()) {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+
+                const bool store_feeds = appbase::app().get_plugin<follow::plugin>().store_feeds();
+
                 for (const auto &iterator : query.select_authors) {
                     const auto &account = database().get_account(iterator);
 
-                    const auto &tag_idx = database().get_index<DatabaseIndex>().indices().template get<DiscussionIndex>();
+                    if (!store_feeds) {
+                        // blogs are seeked directly to the entry of the start comment
+                        auto feed = start_author.size() || start_permlink.size()
+                            ? follow::computed_feed(database(), account.name, database().get_comment(start_author, start_permlink))
+                            : follow::computed_feed(database(), account.name);
+                        follow::computed_feed::entry entry;
+
+                        while (result.size() < query.limit && feed.next(entry)) {
+                            try {
+                                if (!is_selected(entry.comment)) {
+                                    continue;
+                                }
+
+                                result.push_back(get_discussion(entry.comment));
+                                if (entry.first_reblogged_by != account_name_type()) {
+                                    result.back().reblogged_by = std::move(entry.reblogged_by);
+                                    result.back().first_reblogged_by = entry.first_reblogged_by;
+                                    result.back().first_reblogged_on = entry.first_reblogged_on;
+                                }
+                            } catch (const fc::exception &e) {
+                                edump((e.to_detail_string()));
+                            }
+                        }
+                        continue;
+                    }
 
                     const auto &c_idx = database().get_index<follow::feed_index>().indices().get<follow::by_comment>();
                     const auto &f_idx = database().get_index<follow::feed_index>().indices().get<follow::by_feed>();
@@ -518,21 +796,9 @@ namespace golos {
                             break;
                         }
                         try {
-                            if (!select_set.empty()) {
-                                auto tag_itr = tag_idx.lower_bound(feed_itr->comment);
-
-                                bool found = false;
-                                while (tag_itr != tag_idx.end() && tag_itr->comment == feed_itr->comment) {
-                                    if (select_set.find(tag_itr->name) != select_set.end()) {
-                                        found = true;
-                                        break;
-                                    }
-                                    ++tag_itr;
-                                }
-                                if (!found) {
-                                    ++feed_itr;
-                                    continue;
-                                }
+                            if (!is_selected(feed_itr->comment)) {
+                                ++feed_itr;
+                                continue;
                             }
 
                             result.push_back(get_discussion(feed_itr->comment));
@@ -840,7 +1106,6 @@ namespace golos {
 
                     try {
                         discussion insert_discussion = get_discussion(tidx_itr->comment, query.truncate_body);
-                        insert_discussion.promoted = asset(tidx_itr->promoted_balance, SBD_SYMBOL);
 
                         if (filter(insert_discussion)) {
                             ++filter_count;
@@ -919,8 +1184,8 @@ namespace golos {
 
 
 
-            template<typename FirstCompare, typename SecondCompare>
-            std::vector<discussion> merge(std::multimap<tags::tag_object, discussion, FirstCompare> &result1,
+            template<typename FirstObject, typename FirstCompare, typename SecondCompare>
+            std::vector<discussion> merge(std::multimap<FirstObject, discussion, FirstCompare> &result1,
                                           std::multimap<languages::language_object, discussion,
                                                   SecondCompare> &result2) {
                 //TODO:std::set_intersection(
@@ -952,6 +1217,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_trending) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("trending");
                 return pimpl->database().with_weak_read_lock([&]() {
                     std::vector<discussion> return_result;
 #ifndef IS_LOW_MEM
@@ -959,12 +1225,12 @@ namespace golos {
                     auto parent = pimpl->get_parent(query);
 
                     std::multimap<
-                            tags::tag_object,
+                            tags::tag_sort_object,
                             discussion,
                             tags::by_parent_trending
                     > map_result = pimpl->select<
-                            tags::tag_object,
-                            tags::tag_index,
+                            tags::tag_sort_object,
+                            tags::tag_sort_index,
                             tags::by_parent_trending,
                             tags::by_comment>(
                             query.select_tags,
@@ -975,7 +1241,7 @@ namespace golos {
                             [&](const comment_api_object &c) -> bool {
                                 return false;
                             },
-                            [&](const tags::tag_object &) -> bool {
+                            [&](const tags::tag_sort_object &) -> bool {
                                 return false;
                             },
                             parent,
@@ -1025,8 +1291,8 @@ namespace golos {
                 query.validate();
                 auto parent = get_parent(query);
 
-                std::multimap<tags::tag_object, discussion, tags::by_parent_promoted> map_result = select <
-                        tags::tag_object, tags::tag_index, tags::by_parent_promoted, tags::by_comment >
+                std::multimap<tags::tag_sort_object, discussion, tags::by_parent_promoted> map_result = select <
+                        tags::tag_sort_object, tags::tag_sort_index, tags::by_parent_promoted, tags::by_comment >
                         (
                                 query.select_tags,
                                         query,
@@ -1040,7 +1306,7 @@ namespace golos {
                                         ),
                                         [&](const comment_api_object &c) -> bool {
                                             return false; },
-                                        [&](const tags::tag_object &) -> bool {
+                                        [&](const tags::tag_sort_object &) -> bool {
                                             return false;
                                         },
                                         parent,
@@ -1072,6 +1338,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_promoted) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("promoted");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_promoted(query);
                 });
@@ -1148,6 +1415,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_created) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("created");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_created(query);
                 });
@@ -1161,8 +1429,8 @@ namespace golos {
                 auto parent = get_parent(query);
 
 
-                std::multimap<tags::tag_object, discussion, tags::by_parent_active> map_result = select <
-                        tags::tag_object, tags::tag_index, tags::by_parent_active, tags::by_comment >
+                std::multimap<tags::tag_sort_object, discussion, tags::by_parent_active> map_result = select <
+                        tags::tag_sort_object, tags::tag_sort_index, tags::by_parent_active, tags::by_comment >
                         (query.select_tags, query, parent, std::bind(
                                 tags_filter, query,
                                 std::placeholders::_1,
@@ -1171,7 +1439,7 @@ namespace golos {
                                 }), [&](
                                 const comment_api_object &c) -> bool {
                             return false;
-                        }, [&](const tags::tag_object &) -> bool {
+                        }, [&](const tags::tag_sort_object &) -> bool {
                             return false;
                         }, parent, fc::time_point_sec::maximum());
 
@@ -1196,6 +1464,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_active) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("active");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_active(query);
                 });
@@ -1208,8 +1477,8 @@ namespace golos {
 #ifndef IS_LOW_MEM
                 query.validate();
                 auto parent = get_parent(query);
-                std::multimap<tags::tag_object, discussion, tags::by_cashout> map_result = select <
-                        tags::tag_object, tags::tag_index, tags::by_cashout, tags::by_comment >
+                std::multimap<tags::tag_sort_object, discussion, tags::by_cashout> map_result = select <
+                        tags::tag_sort_object, tags::tag_sort_index, tags::by_cashout, tags::by_comment >
                         (query.select_tags, query, parent, std::bind(
                                 tags_filter, query, std::placeholders::_1,
                                 [&](const comment_api_object &c) -> bool {
@@ -1217,7 +1486,7 @@ namespace golos {
                                 }), [&](
                                 const comment_api_object &c) -> bool {
                             return false;
-                        }, [&](const tags::tag_object &) -> bool {
+                        }, [&](const tags::tag_sort_object &) -> bool {
                             return false;
                         }, fc::time_point::now() - fc::minutes(60));
 
@@ -1248,6 +1517,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_cashout) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("cashout");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_cashout(query);
                 });
@@ -1256,20 +1526,21 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_payout) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("payout");
                 return pimpl->database().with_weak_read_lock([&]() {
                     std::vector<discussion> return_result;
 #ifndef IS_LOW_MEM
                     query.validate();
                     auto parent = pimpl->get_parent(query);
 
-                    std::multimap<tags::tag_object, discussion, tags::by_net_rshares> map_result = pimpl->select<
-                            tags::tag_object, tags::tag_index, tags::by_net_rshares, tags::by_comment>(
+                    std::multimap<tags::tag_sort_object, discussion, tags::by_net_rshares> map_result = pimpl->select<
+                            tags::tag_sort_object, tags::tag_sort_index, tags::by_net_rshares, tags::by_comment>(
                             query.select_tags, query, parent, std::bind(tags_filter, query, std::placeholders::_1,
                                                                         [&](const comment_api_object &c) -> bool {
                                                                             return c.children_rshares2 <= 0;
                                                                         }), [&](const comment_api_object &c) -> bool {
                                 return false;
-                            }, [&](const tags::tag_object &) -> bool {
+                            }, [&](const tags::tag_sort_object &) -> bool {
                                 return false;
                             });
 
@@ -1298,8 +1569,8 @@ namespace golos {
                 query.validate();
                 auto parent = get_parent(query);
 
-                std::multimap<tags::tag_object, discussion, tags::by_parent_net_votes> map_result = select <
-                        tags::tag_object, tags::tag_index, tags::by_parent_net_votes, tags::by_comment >
+                std::multimap<tags::tag_sort_object, discussion, tags::by_parent_net_votes> map_result = select <
+                        tags::tag_sort_object, tags::tag_sort_index, tags::by_parent_net_votes, tags::by_comment >
                         (query.select_tags, query, parent, std::bind(
                                 tags_filter, query,
                                 std::placeholders::_1,
@@ -1308,7 +1579,7 @@ namespace golos {
                                 }), [&](
                                 const comment_api_object &c) -> bool {
                             return false;
-                        }, [&](const tags::tag_object &) -> bool {
+                        }, [&](const tags::tag_sort_object &) -> bool {
                             return false;
                         }, parent, std::numeric_limits<
                                 int32_t>::max());
@@ -1335,6 +1606,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_votes) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("votes");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_votes(query);
                 });
@@ -1349,9 +1621,9 @@ namespace golos {
                 query.validate();
                 auto parent = get_parent(query);
 
-                std::multimap<tags::tag_object, discussion, tags::by_parent_children> map_result =
+                std::multimap<tags::tag_sort_object, discussion, tags::by_parent_children> map_result =
 
-                        select < tags::tag_object, tags::tag_index, tags::by_parent_children, tags::by_comment >
+                        select < tags::tag_sort_object, tags::tag_sort_index, tags::by_parent_children, tags::by_comment >
                                 (query.select_tags, query, parent, std::bind(
                                         tags_filter, query,
                                         std::placeholders::_1,
@@ -1360,7 +1632,7 @@ namespace golos {
                                         }), [&](
                                         const comment_api_object &c) -> bool {
                                     return false;
-                                }, [&](const tags::tag_object &) -> bool {
+                                }, [&](const tags::tag_sort_object &) -> bool {
                                     return false;
                                 }, parent, std::numeric_limits<
                                         int32_t>::max());
@@ -1387,6 +1659,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_children) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("children");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_children(query);
                 });
@@ -1400,8 +1673,8 @@ namespace golos {
                 query.validate();
                 auto parent = get_parent(query);
 
-                std::multimap<tags::tag_object, discussion, tags::by_parent_hot> map_result = select <
-                        tags::tag_object, tags::tag_index, tags::by_parent_hot, tags::by_comment >
+                std::multimap<tags::tag_sort_object, discussion, tags::by_parent_hot> map_result = select <
+                        tags::tag_sort_object, tags::tag_sort_index, tags::by_parent_hot, tags::by_comment >
                         (query.select_tags, query, parent, std::bind(
                                 tags_filter, query,
                                 std::placeholders::_1,
@@ -1410,7 +1683,7 @@ namespace golos {
                                 }), [&](
                                 const comment_api_object &c) -> bool {
                             return false;
-                        }, [&](const tags::tag_object &) -> bool {
+                        }, [&](const tags::tag_sort_object &) -> bool {
                             return false;
                         }, parent, std::numeric_limits<double>::max());
 
@@ -1441,6 +1714,7 @@ namespace golos {
             DEFINE_API(social_network_t, get_discussions_by_hot) {
                 CHECK_ARG_SIZE(1)
                 auto query = args.args->at(0).as<discussion_query>();
+                pimpl->check_discussions_api("hot");
                 return pimpl->database().with_weak_read_lock([&]() {
                     return pimpl->get_discussions_by_hot(query);
                 });
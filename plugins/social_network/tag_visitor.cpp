@@ -5,7 +5,9 @@ namespace golos {
             namespace tags {
 
 
-                operation_visitor::operation_visitor(database &db) : _db(db) {}
+                operation_visitor::operation_visitor(database &db, const tag_index_set &indices)
+                        : _db(db), _indices(indices) {
+                }
 
                 void operation_visitor::remove_stats(const tag_object &tag, const tag_stats_object &stats) const {
                     _db.modify(stats, [&](tag_stats_object &s) {
@@ -31,8 +33,65 @@ namespace golos {
                     });
                 }
 
+                void operation_visitor::remove_tag_sort(const tag_object &tag) const {
+                    if (!_indices.any()) {
+                        return;
+                    }
+
+                    const auto &idx = _db.get_index<tag_sort_index>().indices().get<by_tag_object>();
+                    auto itr = idx.find(tag.id);
+                    if (itr != idx.end()) {
+                        _db.remove(*itr);
+                    }
+                }
+
+                void operation_visitor::update_tag_sort(const tag_object &tag, double hot, double trending) const {
+                    if (!_indices.any()) {
+                        return;
+                    }
+
+                    // keys of disabled methods stay zero
+                    if (!_indices.scores) {
+                        hot = 0;
+                        trending = 0;
+                    }
+
+                    auto fill = [&](tag_sort_object &obj) {
+                        if (_indices.sorting) {
+                            obj.active = tag.active;
+                            obj.cashout = tag.cashout;
+                            obj.net_rshares = tag.net_rshares;
+                            obj.net_votes = tag.net_votes;
+                            obj.children = tag.children;
+                            obj.promoted_balance = tag.promoted_balance;
+                        }
+                        obj.hot = hot;
+                        obj.trending = trending;
+                    };
+
+                    const auto &idx = _db.get_index<tag_sort_index>().indices().get<by_tag_object>();
+                    auto itr = idx.find(tag.id);
+                    if (itr == idx.end()) {
+                        _db.create<tag_sort_object>([&](tag_sort_object &obj) {
+                            obj.tag = tag.id;
+                            obj.name = tag.name;
+                            obj.parent = tag.parent;
+                            obj.comment = tag.comment;
+                            fill(obj);
+                        });
+                    } else if (itr->hot != hot || itr->trending != trending || (_indices.sorting && (
+                               itr->active != tag.active || itr->cashout != tag.cashout ||
+                               itr->net_rshares != tag.net_rshares || itr->net_votes != tag.net_votes ||
+                               itr->children != tag.children || itr->promoted_balance != tag.promoted_balance))
+                    ) {
+                        /// most votes on replies and all updates of ancestors leave the keys untouched
+                        _db.modify(*itr, fill);
+                    }
+                }
+
                 void operation_visitor::remove_tag(const tag_object &tag) const {
                     /// TODO: update tag stats object
+                    remove_tag_sort(tag);
                     _db.remove(tag);
 
                     const auto &idx = _db.get_index<author_tag_stats_index>().indices().get<by_author_tag_posts>();
@@ -98,24 +157,45 @@ namespace golos {
                 void operation_visitor::update_tag(const tag_object &current, const comment_object &comment, double hot,
                                                    double trending) const {
                     const auto &stats = get_stats(current.name);
-                    remove_stats(current, stats);
 
                     if (comment.cashout_time != fc::time_point_sec::maximum()) {
-                        _db.modify(current, [&](tag_object &obj) {
-                            obj.active = comment.active;
-                            obj.cashout = _db.calculate_discussion_payout_time(comment);
-                            obj.children = comment.children;
-                            obj.net_rshares = comment.net_rshares.value;
-                            obj.net_votes = comment.net_votes;
-                            obj.children_rshares2 = comment.children_rshares2;
-                            obj.hot = hot;
-                            obj.trending = trending;
-                            if (obj.cashout == fc::time_point_sec()) {
-                                obj.promoted_balance = 0;
-                            }
-                        });
-                        add_stats(current, stats);
+                        auto cashout = _db.calculate_discussion_payout_time(comment);
+                        auto old_children_rshares2 = current.children_rshares2;
+                        auto old_net_votes = current.net_votes;
+
+                        if (current.active != comment.active || current.cashout != cashout ||
+                            current.children != comment.children || current.net_rshares != comment.net_rshares.value ||
+                            current.net_votes != comment.net_votes ||
+                            current.children_rshares2 != comment.children_rshares2 ||
+                            (cashout == fc::time_point_sec() && current.promoted_balance != 0)
+                        ) {
+                            _db.modify(current, [&](tag_object &obj) {
+                                obj.active = comment.active;
+                                obj.cashout = cashout;
+                                obj.children = comment.children;
+                                obj.net_rshares = comment.net_rshares.value;
+                                obj.net_votes = comment.net_votes;
+                                obj.children_rshares2 = comment.children_rshares2;
+                                if (obj.cashout == fc::time_point_sec()) {
+                                    obj.promoted_balance = 0;
+                                }
+                            });
+                        }
+
+                        if (old_children_rshares2 != current.children_rshares2 || old_net_votes != current.net_votes) {
+                            _db.modify(stats, [&](tag_stats_object &s) {
+                                if (current.is_post()) {
+                                    s.total_children_rshares2 -= old_children_rshares2;
+                                    s.total_children_rshares2 += current.children_rshares2;
+                                }
+                                s.net_votes += current.net_votes - old_net_votes;
+                            });
+                        }
+
+                        update_tag_sort(current, hot, trending);
                     } else {
+                        remove_stats(current, stats);
+                        remove_tag_sort(current);
                         _db.remove(current);
                     }
                 }
@@ -143,10 +223,9 @@ namespace golos {
                         obj.net_rshares = comment.net_rshares.value;
                         obj.children_rshares2 = comment.children_rshares2;
                         obj.author = author;
-                        obj.hot = hot;
-                        obj.trending = trending;
                     });
                     add_stats(tag_obj, get_stats(tag));
+                    update_tag_sort(tag_obj, hot, trending);
 
 
                     const auto &idx = _db.get_index<author_tag_stats_index>().indices().get<by_author_tag_posts>();
@@ -295,6 +374,8 @@ namespace golos {
 
                             auto c = _db.find_comment(acnt, perm);
                             if (c && c->parent_author.size() == 0) {
+                                auto hot = calculate_hot(c->net_rshares, c->created);
+                                auto trending = calculate_trending(c->net_rshares, c->created);
                                 const auto &comment_idx = _db.get_index<tag_index>().indices().get<by_comment>();
                                 auto citr = comment_idx.lower_bound(c->id);
                                 while (citr != comment_idx.end() && citr->comment == c->id) {
@@ -303,6 +384,7 @@ namespace golos {
                                             t.promoted_balance += op.amount.amount;
                                         }
                                     });
+                                    update_tag_sort(*citr, hot, trending);
                                     ++citr;
                                 }
                             } else {
@@ -332,6 +414,7 @@ namespace golos {
                         const auto *obj = _db.find<comment_object>(itr->comment);
                         ++itr;
                         if (!obj) {
+                            remove_tag_sort(tobj);
                             _db.remove(tobj);
                         }
                     }
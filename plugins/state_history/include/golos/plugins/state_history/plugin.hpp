@@ -0,0 +1,144 @@
+#pragma once
+
+#include <appbase/application.hpp>
+#include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/json_rpc/utility.hpp>
+#include <golos/plugins/json_rpc/plugin.hpp>
+#include <golos/chain/comment_object.hpp>
+#include <golos/protocol/asset.hpp>
+#include <golos/protocol/types.hpp>
+
+namespace golos {
+namespace plugins {
+namespace state_history {
+
+using golos::plugins::json_rpc::msg_pack;
+using golos::protocol::account_name_type;
+using golos::protocol::asset;
+using golos::protocol::share_type;
+using fc::time_point_sec;
+
+/// Balances and vesting of an account
+struct account_state {
+    account_name_type name;
+
+    asset balance;
+    asset savings_balance;
+    asset sbd_balance;
+    asset savings_sbd_balance;
+
+    asset vesting_shares;
+    asset vesting_withdraw_rate;
+    time_point_sec next_vesting_withdrawal;
+    share_type withdrawn;
+    share_type to_withdraw;
+
+    share_type curation_rewards;
+    share_type posting_rewards;
+};
+
+/// Votes and payout of a comment
+struct comment_state {
+    account_name_type author;
+    std::string permlink;
+
+    share_type net_rshares;
+    share_type abs_rshares;
+    share_type vote_rshares;
+    int32_t net_votes = 0;
+
+    time_point_sec cashout_time;
+    time_point_sec last_payout;
+    golos::chain::comment_mode mode = golos::chain::first_payout;
+
+    asset total_payout_value;
+    asset curator_payout_value;
+    asset beneficiary_payout_value;
+    share_type author_rewards;
+};
+
+/// State of an account at the requested block, block is where the state was recorded
+struct historical_account_state {
+    uint32_t block = 0;
+    account_state state;
+};
+
+/// State of a comment at the requested block, block is where the state was recorded
+struct historical_comment_state {
+    uint32_t block = 0;
+    comment_state state;
+};
+
+DEFINE_API_ARGS(get_accounts_at_block, msg_pack, std::vector<fc::optional<historical_account_state>>)
+DEFINE_API_ARGS(get_content_at_block,  msg_pack, fc::optional<historical_comment_state>)
+
+/**
+ *  Answers queries about states of accounts and comments at past blocks.
+ *
+ *  States of accounts and comments changed by operations (including virtual ones) are
+ *  recorded after each block. A snapshot of states of all accounts is started every
+ *  state-history-snapshot-interval blocks and after a restart, which catches changes without
+ *  operations; it records state-history-snapshot-accounts-per-block accounts in each block.
+ *  Unchanged states aren't stored again. States of irreversible blocks are kept
+ *  in a state_journal on disk, states of reversible blocks are kept in memory.
+ *  States are found by names, so the history of a deleted comment is available too.
+ *
+ *  History is available since the block the plugin was enabled at, or since the beginning
+ *  after a replay. States of the blocks, which were reversible on a restart of the node,
+ *  are lost: queries about them are refused from the journaled block till the end of the
+ *  snapshot after the restart. Comments changed by transactions of the lost blocks are
+ *  recorded again after the restart.
+ */
+class plugin final : public appbase::plugin<plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES(
+        (chain::plugin)
+        (json_rpc::plugin)
+    )
+
+    constexpr const static char *plugin_name = "state_history";
+
+    static const std::string &name() {
+        static std::string name = plugin_name;
+        return name;
+    }
+
+    plugin();
+
+    ~plugin();
+
+    void set_program_options(
+        boost::program_options::options_description &cli,
+        boost::program_options::options_description &cfg) override;
+
+    void plugin_initialize(const boost::program_options::variables_map &options) override;
+
+    void plugin_startup() override;
+
+    void plugin_shutdown() override;
+
+    DECLARE_API(
+        (get_accounts_at_block)
+        (get_content_at_block)
+    )
+
+private:
+    struct plugin_impl;
+
+    std::unique_ptr<plugin_impl> my;
+};
+
+} } } // golos::plugins::state_history
+
+FC_REFLECT((golos::plugins::state_history::account_state),
+    (name)(balance)(savings_balance)(sbd_balance)(savings_sbd_balance)
+    (vesting_shares)(vesting_withdraw_rate)(next_vesting_withdrawal)(withdrawn)(to_withdraw)
+    (curation_rewards)(posting_rewards))
+
+FC_REFLECT((golos::plugins::state_history::comment_state),
+    (author)(permlink)(net_rshares)(abs_rshares)(vote_rshares)(net_votes)
+    (cashout_time)(last_payout)(mode)
+    (total_payout_value)(curator_payout_value)(beneficiary_payout_value)(author_rewards))
+
+FC_REFLECT((golos::plugins::state_history::historical_account_state), (block)(state))
+FC_REFLECT((golos::plugins::state_history::historical_comment_state), (block)(state))
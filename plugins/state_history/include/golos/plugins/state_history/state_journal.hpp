@@ -0,0 +1,149 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace boost {
+namespace interprocess {
+class file_mapping;
+class mapped_region;
+} } // boost::interprocess
+
+namespace golos {
+namespace plugins {
+namespace state_history {
+
+/// Blocks from first to last inclusive
+struct block_range {
+    uint32_t first = 0;
+    uint32_t last = 0;
+};
+
+/**
+ *  Append-only storage of serialized states of objects by block.
+ *
+ *  Objects are identified by 64-bit non-zero keys. records.log keeps the serialized states one after
+ *  another, index.log keeps a fixed-size entry per record: the key, the block, the offset and
+ *  the size of the record and a hash of its data. Entries of an object are chained from the newest
+ *  one: each entry refers to the previous entry of the object and to an older one by a skip pointer,
+ *  so a state at any block is found in a logarithmic number of reads of the index.
+ *  heads.idx is a memory mapped hash table of the newest entry of each object. A state equal to
+ *  the last recorded state of the object isn't appended, so repeated snapshots of unchanged objects
+ *  cost nothing. Only entries appended after the last commit are kept in memory.
+ *
+ *  head.state keeps the last journaled block and the sizes of the logs at that block,
+ *  anything written after them (by an unclean shutdown) is truncated on open.
+ */
+class state_journal final {
+public:
+    state_journal();
+
+    ~state_journal();
+
+    void open(const fc::path &dir);
+
+    void close();
+
+    /// Removes all journaled states
+    void wipe();
+
+    bool is_open() const {
+        return _is_open;
+    }
+
+    uint32_t head_block() const {
+        return _head_block;
+    }
+
+    /// Number of objects with journaled states
+    uint64_t size() const;
+
+    /// Records the state of the object at the block, the block must be after the previous records of the object
+    void append(uint64_t key, uint32_t block, const std::vector<char> &data);
+
+    /// Flushes appended states and marks everything up to block as journaled
+    void commit(uint32_t block);
+
+    /**
+     *  The last state of the object recorded not later than block.
+     *  @return the block of the state or 0 if there is no such state
+     */
+    uint32_t find(uint64_t key, uint32_t block, std::vector<char> &data) const;
+
+    /**
+     *  Marks blocks whose states weren't recorded, it is saved with the next commit.
+     *  A range with the same first block as the last marked one replaces it.
+     */
+    void add_lost_blocks(const block_range &range);
+
+    const std::vector<block_range> &lost_blocks() const {
+        return _lost_blocks;
+    }
+
+private:
+    /// Entry of index.log, numbers of entries are one-based, 0 is no entry
+    struct index_entry {
+        uint64_t key = 0;
+        uint64_t offset = 0;
+        uint64_t hash = 0;
+        uint64_t prev = 0;   ///< the previous entry of the object
+        uint64_t skip = 0;   ///< an older entry of the object, at skip_height(height)
+        uint32_t block = 0;
+        uint32_t size = 0;
+        uint32_t height = 0; ///< number of the previous entries of the object
+        uint32_t reserved = 0;
+    };
+
+    struct head_slot;
+
+    struct object_head {
+        uint64_t entry = 0; ///< the newest entry of the object
+        uint64_t hash = 0;  ///< hash of the newest state
+    };
+
+    object_head find_head(uint64_t key) const;
+
+    index_entry read_entry(uint64_t number) const;
+
+    void set_head(uint64_t key, const object_head &head);
+
+    head_slot *heads() const;
+
+    void map_heads();
+
+    void unmap_heads();
+
+    void write_state(uint64_t heads_entries);
+
+    fc::path _dir;
+    bool _is_open = false;
+    uint32_t _head_block = 0;
+    std::vector<block_range> _lost_blocks;
+
+    mutable std::ofstream _records_out; ///< flushed before reading the records appended after the last commit
+    std::ofstream _index_out;
+    uint64_t _records_size = 0;
+    uint64_t _index_entries = 0;
+
+    mutable std::mutex _read_mutex;
+    mutable std::ifstream _records_in;
+    mutable std::ifstream _index_in;
+
+    std::unique_ptr<boost::interprocess::file_mapping> _heads_mapping;
+    std::unique_ptr<boost::interprocess::mapped_region> _heads_region;
+
+    // appended after the last commit
+    std::vector<index_entry> _pending_entries;
+    std::unordered_map<uint64_t, object_head> _pending_heads;
+    uint64_t _pending_objects = 0;
+};
+
+} } } // golos::plugins::state_history
+
+FC_REFLECT((golos::plugins::state_history::block_range), (first)(last))
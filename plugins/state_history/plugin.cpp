@@ -0,0 +1,551 @@
+#include <golos/plugins/state_history/plugin.hpp>
+#include <golos/plugins/state_history/state_journal.hpp>
+#include <golos/plugins/account_history/plugin.hpp>
+
+#include <golos/chain/account_object.hpp>
+#include <golos/chain/database.hpp>
+#include <golos/chain/operation_notification.hpp>
+
+#include <fc/crypto/city.hpp>
+
+#include <boost/container/flat_set.hpp>
+
+#include <deque>
+#include <limits>
+#include <map>
+#include <set>
+
+namespace golos {
+namespace plugins {
+namespace state_history {
+
+using golos::protocol::signed_block;
+using golos::chain::operation_notification;
+using golos::chain::account_object;
+using golos::chain::comment_object;
+
+/// Kinds of objects in the journal, the kind is kept in the highest byte of the key
+enum state_kind : uint64_t {
+    account_state_kind = 1,
+    comment_state_kind = 2
+};
+
+// objects are found by names, so the history of a deleted comment is kept,
+// a collision of hashes is detected by the name in the state
+static inline uint64_t make_key(state_kind kind, const std::string &name) {
+    return (uint64_t(kind) << 56) | (fc::city_hash64(name.data(), name.size()) & ((uint64_t(1) << 56) - 1));
+}
+
+static inline uint64_t account_key(const account_name_type &name) {
+    return make_key(account_state_kind, std::string(name));
+}
+
+static inline uint64_t comment_key(const account_name_type &author, const std::string &permlink) {
+    return make_key(comment_state_kind, std::string(author) + "/" + permlink);
+}
+
+static account_state make_account_state(const account_object &account) {
+    account_state result;
+    result.name = account.name;
+    result.balance = account.balance;
+    result.savings_balance = account.savings_balance;
+    result.sbd_balance = account.sbd_balance;
+    result.savings_sbd_balance = account.savings_sbd_balance;
+    result.vesting_shares = account.vesting_shares;
+    result.vesting_withdraw_rate = account.vesting_withdraw_rate;
+    result.next_vesting_withdrawal = account.next_vesting_withdrawal;
+    result.withdrawn = account.withdrawn;
+    result.to_withdraw = account.to_withdraw;
+    result.curation_rewards = account.curation_rewards;
+    result.posting_rewards = account.posting_rewards;
+    return result;
+}
+
+static comment_state make_comment_state(const comment_object &comment) {
+    comment_state result;
+    result.author = comment.author;
+    result.permlink = golos::chain::to_string(comment.permlink);
+    result.net_rshares = comment.net_rshares;
+    result.abs_rshares = comment.abs_rshares;
+    result.vote_rshares = comment.vote_rshares;
+    result.net_votes = comment.net_votes;
+    result.cashout_time = comment.cashout_time;
+    result.last_payout = comment.last_payout;
+    result.mode = comment.mode;
+    result.total_payout_value = comment.total_payout_value;
+    result.curator_payout_value = comment.curator_payout_value;
+    result.beneficiary_payout_value = comment.beneficiary_payout_value;
+    result.author_rewards = comment.author_rewards;
+    return result;
+}
+
+struct plugin::plugin_impl final {
+public:
+    plugin_impl() : db_(appbase::app().get_plugin<chain::plugin>().db()) {
+    }
+
+    golos::chain::database &database() {
+        return db_;
+    }
+
+    void on_pre_apply_block(const signed_block &block);
+
+    void on_post_apply_operation(const operation_notification &note);
+
+    void on_applied_block(const signed_block &block);
+
+    void journal_irreversible_blocks();
+
+    struct reversible_block;
+
+    void snapshot_accounts(reversible_block &b, uint32_t limit);
+
+    template<typename State>
+    bool find_state(uint64_t key, uint32_t block, uint32_t &state_block, State &state) const;
+
+    std::vector<fc::optional<historical_account_state>> get_accounts_at_block(
+        const std::vector<account_name_type> &names, uint32_t block) const;
+
+    fc::optional<historical_comment_state> get_content_at_block(
+        const account_name_type &author, const std::string &permlink, uint32_t block) const;
+
+    /// Throws if states at the block weren't journaled
+    void check_recorded(uint32_t block) const;
+
+    void start_recording_lost_blocks();
+
+    struct comment_visitor;
+
+    // a snapshot records states of all accounts in the order of ids, a part in each block
+    struct snapshot_progress {
+        bool active = false;
+        int64_t next_account = 0;
+    };
+
+    struct reversible_block {
+        uint32_t num = 0;
+        snapshot_progress snapshot_before; ///< restored when the block is popped
+        bool ends_lost_blocks = false; ///< the snapshot after a restart is finished in the block
+        std::map<uint64_t, std::vector<char>> states; ///< an empty state marks a deleted object
+    };
+
+    state_journal journal;
+    std::deque<reversible_block> reversible_blocks;
+    uint32_t journaled_block = 0;
+
+    // objects changed by operations of the block being applied
+    boost::container::flat_set<account_name_type> changed_accounts;
+    std::set<std::pair<account_name_type, std::string>> changed_comments;
+    bool all_accounts_changed = false;
+
+    // states of blocks since lost_since aren't complete until the snapshot after a restart is finished,
+    // comments changed by transactions of the lost blocks are recorded with the next block
+    uint32_t lost_since = 0;
+    std::set<std::pair<account_name_type, std::string>> lost_comments;
+
+    // a snapshot of all accounts is started every snapshot_interval blocks
+    uint32_t snapshot_interval = 100000;
+    uint32_t snapshot_accounts_per_block = 1000;
+    snapshot_progress snapshot;
+
+    // the journal is flushed to disk every commit_interval blocks and on shutdown
+    uint32_t commit_interval = 1000;
+
+private:
+    golos::chain::database &db_;
+};
+
+struct plugin::plugin_impl::comment_visitor {
+    using result_type = void;
+
+    plugin_impl &impl;
+    std::set<std::pair<account_name_type, std::string>> &comments;
+
+    comment_visitor(plugin_impl &i, std::set<std::pair<account_name_type, std::string>> &c)
+        : impl(i), comments(c) {
+    }
+
+    void add(const account_name_type &author, const std::string &permlink) const {
+        comments.emplace(author, permlink);
+    }
+
+    template<typename Op>
+    void operator()(const Op &) const {
+    }
+
+    void operator()(const golos::protocol::comment_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::vote_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::comment_options_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::delete_comment_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::author_reward_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::curation_reward_operation &op) const {
+        add(op.comment_author, op.comment_permlink);
+    }
+
+    void operator()(const golos::protocol::comment_reward_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::comment_payout_update_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::comment_benefactor_reward_operation &op) const {
+        add(op.author, op.permlink);
+    }
+
+    void operator()(const golos::protocol::hardfork_operation &) const {
+        // hardforks may change balances of any account
+        impl.all_accounts_changed = true;
+    }
+};
+
+void plugin::plugin_impl::on_pre_apply_block(const signed_block &block) {
+    // operations of pending transactions are applied again with the block
+    changed_accounts.clear();
+    changed_comments.clear();
+    all_accounts_changed = false;
+}
+
+void plugin::plugin_impl::on_post_apply_operation(const operation_notification &note) {
+    account_history::operation_get_impacted_accounts(note.op, changed_accounts);
+    note.op.visit(comment_visitor(*this, changed_comments));
+}
+
+void plugin::plugin_impl::on_applied_block(const signed_block &block) {
+    const auto num = block.block_num();
+
+    if (num == 1 && journaled_block > 0) {
+        wlog("State history: the chain is being replayed, wiping the journal");
+        journal.wipe();
+        reversible_blocks.clear();
+        journaled_block = 0;
+        lost_since = 0;
+        lost_comments.clear();
+    }
+
+    // blocks popped by a fork switch
+    while (!reversible_blocks.empty() && reversible_blocks.back().num >= num) {
+        snapshot = reversible_blocks.back().snapshot_before;
+        reversible_blocks.pop_back();
+    }
+
+    if (num > journaled_block) {
+        reversible_block b;
+        b.num = num;
+        b.snapshot_before = snapshot;
+
+        if (num % snapshot_interval == 0 && !snapshot.active) {
+            snapshot.active = true;
+            snapshot.next_account = 0;
+        }
+
+        if (all_accounts_changed || num == 1) {
+            // accounts of the genesis are created without operations, hardforks are rare
+            snapshot.next_account = 0;
+            snapshot_accounts(b, std::numeric_limits<uint32_t>::max());
+        } else if (snapshot.active) {
+            snapshot_accounts(b, snapshot_accounts_per_block);
+        }
+        b.ends_lost_blocks = lost_since != 0 && b.snapshot_before.active && !snapshot.active;
+
+        // recorded in each block until one is journaled, as the block may be popped
+        changed_comments.insert(lost_comments.begin(), lost_comments.end());
+
+        // rewards of the producer don't always have an operation
+        changed_accounts.insert(block.witness);
+        for (const auto &name: changed_accounts) {
+            const auto *account = db_.find_account(name);
+            if (account != nullptr) {
+                b.states.emplace(account_key(name), fc::raw::pack(make_account_state(*account)));
+            }
+        }
+
+        for (const auto &c: changed_comments) {
+            const auto *comment = db_.find_comment(c.first, c.second);
+            if (comment != nullptr) {
+                b.states.emplace(comment_key(c.first, c.second), fc::raw::pack(make_comment_state(*comment)));
+            } else {
+                b.states.emplace(comment_key(c.first, c.second), std::vector<char>());
+            }
+        }
+
+        reversible_blocks.push_back(std::move(b));
+    }
+
+    changed_accounts.clear();
+    changed_comments.clear();
+    all_accounts_changed = false;
+
+    journal_irreversible_blocks();
+}
+
+void plugin::plugin_impl::snapshot_accounts(reversible_block &b, uint32_t limit) {
+    const auto &idx = db_.get_index<golos::chain::account_index>().indices().get<golos::chain::by_id>();
+    auto itr = idx.lower_bound(account_object::id_type(snapshot.next_account));
+    for (; itr != idx.end() && limit > 0; ++itr, --limit) {
+        b.states.emplace(account_key(itr->name), fc::raw::pack(make_account_state(*itr)));
+    }
+    snapshot.active = itr != idx.end();
+    snapshot.next_account = snapshot.active ? itr->id._id : 0;
+}
+
+void plugin::plugin_impl::journal_irreversible_blocks() {
+    const auto last_irreversible_block = db_.last_non_undoable_block_num();
+
+    while (!reversible_blocks.empty() && reversible_blocks.front().num <= last_irreversible_block) {
+        const auto &b = reversible_blocks.front();
+        for (const auto &state: b.states) {
+            journal.append(state.first, b.num, state.second);
+        }
+        if (b.ends_lost_blocks) {
+            journal.add_lost_blocks({lost_since, b.num - 1});
+            lost_since = 0;
+        }
+        lost_comments.clear();
+        journaled_block = b.num;
+        reversible_blocks.pop_front();
+    }
+    // blocks applied before the plugin was enabled have no states
+    journaled_block = std::max(journaled_block, last_irreversible_block);
+
+    if (journaled_block >= journal.head_block() + commit_interval) {
+        journal.commit(journaled_block);
+    }
+}
+
+template<typename State>
+bool plugin::plugin_impl::find_state(uint64_t key, uint32_t block, uint32_t &state_block, State &state) const {
+    for (auto itr = reversible_blocks.rbegin(); itr != reversible_blocks.rend(); ++itr) {
+        if (itr->num > block) {
+            continue;
+        }
+        auto s = itr->states.find(key);
+        if (s != itr->states.end()) {
+            if (s->second.empty()) {
+                return false;
+            }
+            state = fc::raw::unpack<State>(s->second);
+            state_block = itr->num;
+            return true;
+        }
+    }
+
+    std::vector<char> data;
+    state_block = journal.find(key, block, data);
+    if (state_block == 0 || data.empty()) {
+        return false;
+    }
+    state = fc::raw::unpack<State>(data);
+    return true;
+}
+
+void plugin::plugin_impl::check_recorded(uint32_t block) const {
+    for (const auto &lost: journal.lost_blocks()) {
+        if (block < lost.first || block > lost.last) {
+            continue;
+        }
+        FC_ASSERT(lost.last != std::numeric_limits<uint32_t>::max(),
+            "States of blocks since ${f} are being recorded again after a restart of the node, "
+            "they weren't journaled before it", ("f", lost.first));
+        FC_THROW_EXCEPTION(fc::assert_exception,
+            "States of blocks ${f}..${l} weren't journaled before a restart of the node",
+            ("f", lost.first)("l", lost.last));
+    }
+}
+
+void plugin::plugin_impl::start_recording_lost_blocks() {
+    const auto head_block = db_.head_block_num();
+    const auto &lost_blocks = journal.lost_blocks();
+    const bool restarted_snapshot = !lost_blocks.empty() &&
+        lost_blocks.back().last == std::numeric_limits<uint32_t>::max();
+    if (journal.head_block() >= head_block && !restarted_snapshot) {
+        return;
+    }
+
+    // a snapshot not finished before the restart is started again, the lost blocks are the same
+    block_range lost = {journal.head_block() + 1, std::numeric_limits<uint32_t>::max()};
+    if (restarted_snapshot) {
+        lost.first = lost_blocks.back().first;
+    }
+    journal.add_lost_blocks(lost);
+    journal.commit(journal.head_block());
+
+    // states of reversible blocks are lost on restart, as well as of blocks after an unclean shutdown
+    ilog("State history journal is at block ${j}, the head block is ${h}, states of all accounts will be recorded",
+        ("j", journal.head_block())("h", head_block));
+    lost_since = lost.first;
+    snapshot.active = true;
+    snapshot.next_account = 0;
+
+    // comments aren't in the snapshot, but all their changes except payouts come from transactions
+    for (auto num = journal.head_block() + 1; num <= head_block; ++num) {
+        auto block = db_.fetch_block_by_number(num);
+        if (!block) {
+            continue;
+        }
+        for (const auto &trx: block->transactions) {
+            for (const auto &op: trx.operations) {
+                op.visit(comment_visitor(*this, lost_comments));
+            }
+        }
+    }
+}
+
+std::vector<fc::optional<historical_account_state>> plugin::plugin_impl::get_accounts_at_block(
+    const std::vector<account_name_type> &names, uint32_t block
+) const {
+    check_recorded(block);
+
+    std::vector<fc::optional<historical_account_state>> result;
+    result.reserve(names.size());
+    for (const auto &name: names) {
+        result.emplace_back();
+        historical_account_state s;
+        if (find_state(account_key(name), block, s.block, s.state) && s.state.name == name) {
+            result.back() = std::move(s);
+        }
+    }
+    return result;
+}
+
+fc::optional<historical_comment_state> plugin::plugin_impl::get_content_at_block(
+    const account_name_type &author, const std::string &permlink, uint32_t block
+) const {
+    check_recorded(block);
+
+    fc::optional<historical_comment_state> result;
+    historical_comment_state s;
+    if (find_state(comment_key(author, permlink), block, s.block, s.state) &&
+        s.state.author == author && s.state.permlink == permlink
+    ) {
+        // a payout after the state is recorded unless it was in blocks lost on restart
+        for (const auto &lost: journal.lost_blocks()) {
+            if (s.block >= lost.first || block <= lost.last || s.state.cashout_time == fc::time_point_sec::maximum()) {
+                continue;
+            }
+            auto last_lost = db_.fetch_block_by_number(lost.last);
+            FC_ASSERT(!last_lost || s.state.cashout_time > last_lost->timestamp,
+                "State of ${a}/${p} at block ${b} is unknown, it was paid out in blocks ${f}..${l}, "
+                "which weren't journaled before a restart of the node",
+                ("a", author)("p", permlink)("b", block)("f", lost.first)("l", lost.last));
+        }
+        result = std::move(s);
+    }
+    return result;
+}
+
+DEFINE_API(plugin, get_accounts_at_block) {
+    FC_ASSERT(args.args->size() == 2, "Expected 2 arguments, was ${n}", ("n", args.args->size()));
+    auto names = args.args->at(0).as<std::vector<account_name_type>>();
+    auto block = args.args->at(1).as<uint32_t>();
+    FC_ASSERT(names.size() <= 1000, "Can't query more than 1000 accounts at once, was ${n}", ("n", names.size()));
+
+    auto &db = my->database();
+    return db.with_weak_read_lock([&]() {
+        FC_ASSERT(block <= db.head_block_num(), "Block ${b} is after the head block ${h}",
+            ("b", block)("h", db.head_block_num()));
+        return my->get_accounts_at_block(names, block);
+    });
+}
+
+DEFINE_API(plugin, get_content_at_block) {
+    FC_ASSERT(args.args->size() == 3, "Expected 3 arguments, was ${n}", ("n", args.args->size()));
+    auto author = args.args->at(0).as<account_name_type>();
+    auto permlink = args.args->at(1).as<std::string>();
+    auto block = args.args->at(2).as<uint32_t>();
+
+    auto &db = my->database();
+    return db.with_weak_read_lock([&]() {
+        FC_ASSERT(block <= db.head_block_num(), "Block ${b} is after the head block ${h}",
+            ("b", block)("h", db.head_block_num()));
+        return my->get_content_at_block(author, permlink, block);
+    });
+}
+
+plugin::plugin() {
+}
+
+plugin::~plugin() {
+}
+
+void plugin::set_program_options(
+    boost::program_options::options_description &cli,
+    boost::program_options::options_description &cfg
+) {
+    cfg.add_options()
+        ("state-history-dir",
+            boost::program_options::value<boost::filesystem::path>()->default_value("state-history"),
+            "the location of the state history journal (absolute path or relative to application data dir)")
+        ("state-history-snapshot-interval",
+            boost::program_options::value<uint32_t>()->default_value(100000),
+            "a snapshot of states of all accounts is started every this number of blocks")
+        ("state-history-snapshot-accounts-per-block",
+            boost::program_options::value<uint32_t>()->default_value(1000),
+            "number of accounts recorded by a snapshot in each block");
+}
+
+void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
+    ilog("Initializing state history plugin");
+
+    my.reset(new plugin_impl);
+
+    my->snapshot_interval = options.at("state-history-snapshot-interval").as<uint32_t>();
+    FC_ASSERT(my->snapshot_interval > 0, "state-history-snapshot-interval should be positive");
+    my->snapshot_accounts_per_block = options.at("state-history-snapshot-accounts-per-block").as<uint32_t>();
+    FC_ASSERT(my->snapshot_accounts_per_block > 0, "state-history-snapshot-accounts-per-block should be positive");
+
+    auto dir = options.at("state-history-dir").as<boost::filesystem::path>();
+    if (dir.is_relative()) {
+        dir = appbase::app().data_dir() / dir;
+    }
+    // the journal must be ready before the chain plugin starts a replay
+    my->journal.open(dir);
+    my->journaled_block = my->journal.head_block();
+
+    auto &db = my->database();
+    db.pre_apply_block.connect([&](const signed_block &block) {
+        my->on_pre_apply_block(block);
+    });
+    db.post_apply_operation.connect([&](const operation_notification &note) {
+        my->on_post_apply_operation(note);
+    });
+    db.applied_block.connect([&](const signed_block &block) {
+        try {
+            my->on_applied_block(block);
+        } FC_CAPTURE_AND_LOG((block.block_num()))
+    });
+
+    JSON_RPC_REGISTER_API(name());
+}
+
+void plugin::plugin_startup() {
+    auto &db = my->database();
+    db.with_weak_read_lock([&]() {
+        my->start_recording_lost_blocks();
+    });
+}
+
+void plugin::plugin_shutdown() {
+    if (my->journal.is_open()) {
+        my->journal.commit(my->journaled_block);
+        my->journal.close();
+    }
+}
+
+} } } // golos::plugins::state_history
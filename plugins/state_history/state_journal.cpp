@@ -0,0 +1,437 @@
+#include <golos/plugins/state_history/state_journal.hpp>
+
+#include <fc/crypto/city.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+
+#define LOG_READ  (std::ios::in | std::ios::binary)
+#define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
+
+namespace golos {
+namespace plugins {
+namespace state_history {
+
+namespace detail {
+
+struct journal_state {
+    uint32_t version = 0;
+    uint32_t head_block = 0;
+    uint64_t records_size = 0;
+    uint64_t index_entries = 0;
+    uint64_t heads_entries = 0; ///< heads.idx refers to the entries before it
+    std::vector<block_range> lost_blocks;
+};
+
+} // detail
+
+} } } // golos::plugins::state_history
+
+FC_REFLECT((golos::plugins::state_history::detail::journal_state),
+    (version)(head_block)(records_size)(index_entries)(heads_entries)(lost_blocks))
+
+namespace golos {
+namespace plugins {
+namespace state_history {
+
+namespace bip = boost::interprocess;
+
+using detail::journal_state;
+
+/// Slot of heads.idx, the first slot is the header with the number of objects and the capacity
+struct state_journal::head_slot {
+    uint64_t key = 0;
+    uint64_t entry = 0;
+    uint64_t hash = 0;
+};
+
+static const uint32_t journal_version = 2;
+
+static const char *records_file = "records.log";
+static const char *index_file = "index.log";
+static const char *heads_file = "heads.idx";
+static const char *state_file = "head.state";
+
+static const uint64_t initial_heads_capacity = 1 << 16;
+
+// the height of the entry pointed by the skip pointer, as in the skip lists of chain indices of bitcoin
+static inline uint32_t invert_lowest_one(uint32_t n) {
+    return n & (n - 1);
+}
+
+static inline uint32_t skip_height(uint32_t height) {
+    if (height < 2) {
+        return 0;
+    }
+    return (height & 1) ? invert_lowest_one(invert_lowest_one(height - 1)) + 1 : invert_lowest_one(height);
+}
+
+static inline uint64_t slot_of(uint64_t key, uint64_t capacity) {
+    return (key * 0x9E3779B97F4A7C15ULL) & (capacity - 1);
+}
+
+state_journal::state_journal() {
+}
+
+state_journal::~state_journal() {
+    close();
+}
+
+void state_journal::open(const fc::path &dir) {
+    static_assert(sizeof(index_entry) == 56, "index.log entries are written as is");
+
+    close();
+
+    _dir = dir;
+    fc::create_directories(_dir);
+
+    auto records_path = _dir / records_file;
+    auto index_path = _dir / index_file;
+    auto heads_path = _dir / heads_file;
+    auto state_path = _dir / state_file;
+
+    journal_state state;
+    state.version = journal_version;
+    if (fc::exists(state_path)) {
+        std::ifstream in(state_path.generic_string(), LOG_READ);
+        fc::raw::unpack(in, state);
+        FC_ASSERT(state.version == journal_version,
+            "State history journal at ${d} has format version ${v}, expected ${e}, run with --replay-blockchain",
+            ("d", _dir)("v", state.version)("e", journal_version));
+    }
+
+    // drop the tail written after the last commit
+    for (const auto &file: {std::make_pair(records_path, state.records_size),
+                            std::make_pair(index_path, state.index_entries * sizeof(index_entry))}) {
+        if (!fc::exists(file.first)) {
+            std::ofstream create(file.first.generic_string(), LOG_WRITE);
+        }
+        FC_ASSERT(fc::file_size(file.first) >= file.second,
+            "State history journal file ${f} is shorter than recorded in ${s}",
+            ("f", file.first)("s", state_path));
+        boost::filesystem::resize_file(file.first, file.second);
+    }
+
+    // a table grown by the last commit replaces the old one only when complete
+    fc::remove_all(fc::path(heads_path.generic_string() + ".tmp"));
+    if (!fc::exists(heads_path)) {
+        state.heads_entries = 0;
+        std::ofstream create(heads_path.generic_string(), LOG_WRITE);
+        create.close();
+        boost::filesystem::resize_file(heads_path, (initial_heads_capacity + 1) * sizeof(head_slot));
+        map_heads();
+        heads()->entry = initial_heads_capacity;
+    } else {
+        map_heads();
+    }
+
+    _head_block = state.head_block;
+    _lost_blocks = state.lost_blocks;
+    _records_size = state.records_size;
+    _index_entries = state.index_entries;
+    _pending_entries.clear();
+    _pending_heads.clear();
+    _pending_objects = 0;
+
+    _records_in.open(records_path.generic_string(), LOG_READ);
+    _index_in.open(index_path.generic_string(), LOG_READ);
+
+    // heads of the entries committed after the last update of the table
+    for (uint64_t number = state.heads_entries + 1; number <= _index_entries; ++number) {
+        auto entry = read_entry(number);
+        FC_ASSERT(entry.offset + entry.size <= _records_size, "State history journal index doesn't match records log");
+        set_head(entry.key, {number, entry.hash});
+    }
+    _heads_region->flush();
+
+    _records_out.open(records_path.generic_string(), LOG_WRITE);
+    _index_out.open(index_path.generic_string(), LOG_WRITE);
+
+    _is_open = true;
+
+    if (state.heads_entries != _index_entries) {
+        write_state(_index_entries);
+    }
+
+    ilog("State history journal opened at block ${b} with ${n} objects", ("b", _head_block)("n", size()));
+}
+
+void state_journal::close() {
+    if (!_is_open) {
+        return;
+    }
+    _records_out.close();
+    _index_out.close();
+    _records_in.close();
+    _index_in.close();
+    _heads_region->flush();
+    unmap_heads();
+    _pending_entries.clear();
+    _pending_heads.clear();
+    _is_open = false;
+}
+
+void state_journal::wipe() {
+    auto dir = _dir;
+    close();
+    fc::remove_all(dir / records_file);
+    fc::remove_all(dir / index_file);
+    fc::remove_all(dir / heads_file);
+    fc::remove_all(dir / state_file);
+    open(dir);
+}
+
+void state_journal::map_heads() {
+    auto heads_path = (_dir / heads_file).generic_string();
+    _heads_mapping.reset(new bip::file_mapping(heads_path.c_str(), bip::read_write));
+    _heads_region.reset(new bip::mapped_region(*_heads_mapping, bip::read_write));
+}
+
+void state_journal::unmap_heads() {
+    _heads_region.reset();
+    _heads_mapping.reset();
+}
+
+state_journal::head_slot *state_journal::heads() const {
+    return reinterpret_cast<head_slot *>(_heads_region->get_address());
+}
+
+uint64_t state_journal::size() const {
+    return heads()->key + _pending_objects;
+}
+
+state_journal::object_head state_journal::find_head(uint64_t key) const {
+    auto pending = _pending_heads.find(key);
+    if (pending != _pending_heads.end()) {
+        return pending->second;
+    }
+
+    const auto *table = heads();
+    const auto capacity = table->entry;
+    for (auto slot = slot_of(key, capacity);; slot = (slot + 1) & (capacity - 1)) {
+        const auto &s = table[slot + 1];
+        if (s.key == key) {
+            return {s.entry, s.hash};
+        }
+        if (s.key == 0) {
+            return {};
+        }
+    }
+}
+
+void state_journal::set_head(uint64_t key, const object_head &head) {
+    auto *table = heads();
+    auto capacity = table->entry;
+    if ((table->key + 1) * 4 > capacity * 3) {
+        // the table doubles, it is read under the read lock of the database and changed under the write lock
+        auto heads_path = _dir / heads_file;
+        auto tmp_path = fc::path(heads_path.generic_string() + ".tmp");
+        {
+            std::ofstream create(tmp_path.generic_string(), LOG_WRITE);
+        }
+        boost::filesystem::resize_file(tmp_path, (capacity * 2 + 1) * sizeof(head_slot));
+        {
+            bip::file_mapping mapping(tmp_path.generic_string().c_str(), bip::read_write);
+            bip::mapped_region region(mapping, bip::read_write);
+            auto *grown = reinterpret_cast<head_slot *>(region.get_address());
+            grown->key = table->key;
+            grown->entry = capacity * 2;
+            for (uint64_t i = 1; i <= capacity; ++i) {
+                if (table[i].key == 0) {
+                    continue;
+                }
+                auto slot = slot_of(table[i].key, capacity * 2);
+                while (grown[slot + 1].key != 0) {
+                    slot = (slot + 1) & (capacity * 2 - 1);
+                }
+                grown[slot + 1] = table[i];
+            }
+            region.flush();
+        }
+        unmap_heads();
+        fc::rename(tmp_path, heads_path);
+        map_heads();
+        table = heads();
+        capacity = table->entry;
+    }
+
+    for (auto slot = slot_of(key, capacity);; slot = (slot + 1) & (capacity - 1)) {
+        auto &s = table[slot + 1];
+        if (s.key == 0) {
+            s.key = key;
+            ++table->key;
+        }
+        if (s.key == key) {
+            s.entry = head.entry;
+            s.hash = head.hash;
+            return;
+        }
+    }
+}
+
+state_journal::index_entry state_journal::read_entry(uint64_t number) const {
+    if (number > _index_entries) {
+        return _pending_entries[number - _index_entries - 1];
+    }
+
+    std::lock_guard<std::mutex> lock(_read_mutex);
+
+    index_entry entry;
+    _index_in.clear();
+    _index_in.seekg((number - 1) * sizeof(entry));
+    _index_in.read((char *)&entry, sizeof(entry));
+    FC_ASSERT(_index_in, "Can't read entry ${n} from state history journal index", ("n", number));
+    return entry;
+}
+
+void state_journal::append(uint64_t key, uint32_t block, const std::vector<char> &data) {
+    FC_ASSERT(key != 0, "Key 0 can't be recorded in state history journal");
+
+    auto head = find_head(key);
+    auto hash = fc::city_hash64(data.data(), data.size());
+
+    index_entry entry;
+    if (head.entry != 0) {
+        auto prev = read_entry(head.entry);
+        FC_ASSERT(prev.block < block,
+            "State of ${k} at block ${b} is recorded after block ${l}",
+            ("k", key)("b", block)("l", prev.block));
+        if (head.hash == hash) {
+            return;
+        }
+
+        entry.prev = head.entry;
+        entry.height = prev.height + 1;
+
+        // the ancestor at the skip height, found by the skip pointers of the previous entries
+        int64_t target = skip_height(entry.height);
+        auto walk = prev;
+        auto walk_number = head.entry;
+        while (walk.height > target) {
+            int64_t walk_skip = skip_height(walk.height);
+            int64_t walk_skip_prev = skip_height(walk.height - 1);
+            if (walk.skip != 0 && (walk_skip == target ||
+                (walk_skip > target && !(walk_skip_prev < walk_skip - 2 && walk_skip_prev >= target)))
+            ) {
+                walk_number = walk.skip;
+            } else {
+                walk_number = walk.prev;
+            }
+            walk = read_entry(walk_number);
+        }
+        entry.skip = entry.height > 1 ? walk_number : 0;
+    } else {
+        ++_pending_objects;
+    }
+
+    entry.key = key;
+    entry.offset = _records_size;
+    entry.hash = hash;
+    entry.block = block;
+    entry.size = data.size();
+
+    _records_out.write(data.data(), data.size());
+    _records_size += data.size();
+
+    _pending_entries.push_back(entry);
+    _pending_heads[key] = {_index_entries + _pending_entries.size(), hash};
+}
+
+void state_journal::commit(uint32_t block) {
+    _head_block = block;
+    if (_pending_entries.empty()) {
+        write_state(_index_entries);
+        return;
+    }
+
+    _index_out.write((const char *)_pending_entries.data(), _pending_entries.size() * sizeof(index_entry));
+    _records_out.flush();
+    _index_out.flush();
+    auto heads_entries = _index_entries;
+    _index_entries += _pending_entries.size();
+
+    // heads.idx is brought up to date after the entries are committed, so it is redone from index.log after a crash
+    write_state(heads_entries);
+    for (const auto &head: _pending_heads) {
+        set_head(head.first, head.second);
+    }
+    _heads_region->flush();
+    _pending_entries.clear();
+    _pending_heads.clear();
+    _pending_objects = 0;
+    write_state(_index_entries);
+}
+
+void state_journal::write_state(uint64_t heads_entries) {
+    journal_state state;
+    state.version = journal_version;
+    state.head_block = _head_block;
+    state.records_size = _records_size;
+    state.index_entries = _index_entries;
+    state.heads_entries = heads_entries;
+    state.lost_blocks = _lost_blocks;
+
+    auto state_path = _dir / state_file;
+    auto tmp_path = fc::path(state_path.generic_string() + ".tmp");
+    {
+        std::ofstream out(tmp_path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.exceptions(std::fstream::failbit | std::fstream::badbit);
+        auto data = fc::raw::pack(state);
+        out.write(data.data(), data.size());
+    }
+    fc::rename(tmp_path, state_path);
+}
+
+void state_journal::add_lost_blocks(const block_range &range) {
+    if (!_lost_blocks.empty() && _lost_blocks.back().first == range.first) {
+        _lost_blocks.back() = range;
+    } else {
+        _lost_blocks.push_back(range);
+    }
+}
+
+uint32_t state_journal::find(uint64_t key, uint32_t block, std::vector<char> &data) const {
+    auto head = find_head(key);
+    if (head.entry == 0) {
+        return 0;
+    }
+
+    // from the newest entry to the last one not later than block, skipping while the skipped entry is still later
+    auto number = head.entry;
+    auto entry = read_entry(number);
+    while (entry.block > block) {
+        if (entry.skip != 0) {
+            auto skipped = read_entry(entry.skip);
+            if (skipped.block > block) {
+                number = entry.skip;
+                entry = skipped;
+                continue;
+            }
+        }
+        if (entry.prev == 0) {
+            return 0;
+        }
+        number = entry.prev;
+        entry = read_entry(number);
+    }
+
+    std::lock_guard<std::mutex> lock(_read_mutex);
+
+    _records_out.flush();
+    _records_in.clear();
+    _records_in.seekg(entry.offset);
+
+    data.resize(entry.size);
+    _records_in.read(data.data(), data.size());
+    FC_ASSERT(_records_in, "Can't read state of ${k} at block ${b} from state history journal",
+        ("k", key)("b", entry.block));
+
+    return entry.block;
+}
+
+} } } // golos::plugins::state_history
@@ -315,6 +315,9 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
         }
         _my->stat_sender = std::shared_ptr<statistics_sender>(new statistics_sender(statsd_default_port) );
 
+        // not a block consumer: counters read the chain state at the moment of the operation (creation time
+        // of a comment, changes of a vote, a withdraw rate before it's changed), which is gone after the block,
+        // and the statistics are already sent on the io_service thread
         db.applied_block.connect([&](const signed_block &b) {
             _my->on_block(b);
         });
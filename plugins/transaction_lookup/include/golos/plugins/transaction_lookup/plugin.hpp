@@ -0,0 +1,68 @@
+#pragma once
+
+#include <appbase/application.hpp>
+#include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/json_rpc/utility.hpp>
+#include <golos/plugins/json_rpc/plugin.hpp>
+#include <golos/protocol/transaction.hpp>
+
+namespace golos {
+namespace plugins {
+namespace transaction_lookup {
+
+using golos::plugins::json_rpc::msg_pack;
+using golos::protocol::annotated_signed_transaction;
+using golos::protocol::transaction_id_type;
+
+DEFINE_API_ARGS(get_transaction, msg_pack, annotated_signed_transaction)
+
+/**
+ *  Finds transactions by id at any depth of the chain.
+ *
+ *  Positions of transactions of irreversible blocks are kept in an on-disk hash table,
+ *  which is filled as blocks become irreversible (including replay), positions of
+ *  transactions of reversible blocks are kept in memory. The transactions themselves are
+ *  read from the blocks.
+ */
+class plugin final : public appbase::plugin<plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES(
+        (chain::plugin)
+        (json_rpc::plugin)
+    )
+
+    constexpr const static char *plugin_name = "transaction_lookup";
+
+    static const std::string &name() {
+        static std::string name = plugin_name;
+        return name;
+    }
+
+    plugin();
+
+    ~plugin();
+
+    void set_program_options(
+        boost::program_options::options_description &cli,
+        boost::program_options::options_description &cfg) override;
+
+    void plugin_initialize(const boost::program_options::variables_map &options) override;
+
+    void plugin_startup() override;
+
+    void plugin_shutdown() override;
+
+    /// The transaction with its block number and position in block
+    fc::optional<annotated_signed_transaction> find_transaction(const transaction_id_type &id) const;
+
+    DECLARE_API(
+        (get_transaction)
+    )
+
+private:
+    struct plugin_impl;
+
+    std::unique_ptr<plugin_impl> my;
+};
+
+} } } // golos::plugins::transaction_lookup
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace boost {
+namespace interprocess {
+class file_mapping;
+class mapped_region;
+} } // boost::interprocess
+
+namespace golos {
+namespace plugins {
+namespace transaction_lookup {
+
+using golos::protocol::transaction_id_type;
+
+struct trx_position {
+    uint32_t block = 0;
+    uint32_t trx_in_block = 0;
+};
+
+/**
+ *  On-disk hash table mapping transaction ids to their positions in blocks.
+ *
+ *  The file is memory mapped and holds 16-byte slots with open addressing: the first 8 bytes
+ *  of the transaction id and its position. Different transactions may share a key,
+ *  so find() returns candidates, which should be checked against the blocks.
+ *  The table doubles when it becomes half full.
+ *
+ *  Inserting the same position twice has no effect, so blocks after the last committed one
+ *  can be indexed again after an unclean shutdown.
+ */
+class position_table final {
+public:
+    position_table();
+
+    ~position_table();
+
+    void open(const fc::path &file);
+
+    void close();
+
+    bool is_open() const {
+        return _header != nullptr;
+    }
+
+    /// The last committed block
+    uint32_t head_block() const;
+
+    uint64_t size() const;
+
+    void insert(const transaction_id_type &id, const trx_position &position);
+
+    std::vector<trx_position> find(const transaction_id_type &id) const;
+
+    /// Flushes the table to disk and marks everything up to block as indexed
+    void commit(uint32_t block);
+
+private:
+    struct header;
+    struct slot;
+
+    void map(const fc::path &file);
+
+    void unmap();
+
+    void grow();
+
+    fc::path _file;
+    std::unique_ptr<boost::interprocess::file_mapping> _mapping;
+    std::unique_ptr<boost::interprocess::mapped_region> _region;
+    header *_header = nullptr;
+    slot *_slots = nullptr;
+};
+
+} } } // golos::plugins::transaction_lookup
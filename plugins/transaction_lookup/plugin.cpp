@@ -0,0 +1,204 @@
+#include <golos/plugins/transaction_lookup/plugin.hpp>
+#include <golos/plugins/transaction_lookup/position_table.hpp>
+
+#include <golos/chain/database.hpp>
+
+#include <deque>
+
+namespace golos {
+namespace plugins {
+namespace transaction_lookup {
+
+using golos::protocol::signed_block;
+
+struct plugin::plugin_impl final {
+public:
+    plugin_impl() : db_(appbase::app().get_plugin<chain::plugin>().db()) {
+    }
+
+    golos::chain::database &database() {
+        return db_;
+    }
+
+    void on_applied_block(const signed_block &block);
+
+    void index_irreversible_blocks();
+
+    void index_transactions(uint32_t block_num, const std::vector<transaction_id_type> &transactions);
+
+    fc::optional<annotated_signed_transaction> find_transaction(const transaction_id_type &id) const;
+
+    struct reversible_block {
+        uint32_t num = 0;
+        std::vector<transaction_id_type> transactions;
+    };
+
+    position_table table;
+    std::deque<reversible_block> reversible_blocks;
+    uint32_t indexed_block = 0;
+
+    // the table is flushed to disk every commit_interval blocks and on shutdown
+    uint32_t commit_interval = 1000;
+    // a big backlog (e.g. after enabling the plugin) is indexed by parts
+    uint32_t max_blocks_per_call = 10000;
+
+private:
+    golos::chain::database &db_;
+};
+
+void plugin::plugin_impl::on_applied_block(const signed_block &block) {
+    const auto num = block.block_num();
+
+    // blocks popped by a fork switch
+    while (!reversible_blocks.empty() && reversible_blocks.back().num >= num) {
+        reversible_blocks.pop_back();
+    }
+
+    if (num > indexed_block) {
+        reversible_block b;
+        b.num = num;
+        b.transactions.reserve(block.transactions.size());
+        for (const auto &trx: block.transactions) {
+            b.transactions.push_back(trx.id());
+        }
+        reversible_blocks.push_back(std::move(b));
+    }
+
+    index_irreversible_blocks();
+}
+
+void plugin::plugin_impl::index_irreversible_blocks() {
+    const auto last_irreversible_block = db_.last_non_undoable_block_num();
+
+    for (uint32_t n = 0; indexed_block < last_irreversible_block && n < max_blocks_per_call; ++n) {
+        const auto next = indexed_block + 1;
+
+        while (!reversible_blocks.empty() && reversible_blocks.front().num < next) {
+            reversible_blocks.pop_front();
+        }
+
+        if (!reversible_blocks.empty() && reversible_blocks.front().num == next) {
+            index_transactions(next, reversible_blocks.front().transactions);
+            reversible_blocks.pop_front();
+        } else {
+            // blocks applied before the plugin was enabled
+            auto block = db_.fetch_block_by_number(next);
+            if (!block) {
+                break;
+            }
+            std::vector<transaction_id_type> transactions;
+            transactions.reserve(block->transactions.size());
+            for (const auto &trx: block->transactions) {
+                transactions.push_back(trx.id());
+            }
+            index_transactions(next, transactions);
+        }
+        indexed_block = next;
+    }
+
+    if (indexed_block >= table.head_block() + commit_interval) {
+        table.commit(indexed_block);
+    }
+}
+
+void plugin::plugin_impl::index_transactions(
+    uint32_t block_num, const std::vector<transaction_id_type> &transactions
+) {
+    for (uint32_t i = 0; i < transactions.size(); ++i) {
+        table.insert(transactions[i], {block_num, i});
+    }
+}
+
+fc::optional<annotated_signed_transaction> plugin::plugin_impl::find_transaction(const transaction_id_type &id) const {
+    std::vector<trx_position> candidates;
+    for (const auto &b: reversible_blocks) {
+        for (uint32_t i = 0; i < b.transactions.size(); ++i) {
+            if (b.transactions[i] == id) {
+                candidates.push_back({b.num, i});
+            }
+        }
+    }
+    auto positions = table.find(id);
+    candidates.insert(candidates.end(), positions.begin(), positions.end());
+
+    // the table keeps only a part of the id, so check the transactions in blocks
+    for (const auto &position: candidates) {
+        auto block = db_.fetch_block_by_number(position.block);
+        if (!block || position.trx_in_block >= block->transactions.size()) {
+            continue;
+        }
+        const auto &trx = block->transactions[position.trx_in_block];
+        if (trx.id() == id) {
+            annotated_signed_transaction result = trx;
+            result.block_num = position.block;
+            result.transaction_num = position.trx_in_block;
+            return result;
+        }
+    }
+    return fc::optional<annotated_signed_transaction>();
+}
+
+DEFINE_API(plugin, get_transaction) {
+    FC_ASSERT(args.args->size() == 1, "Expected 1 argument, was ${n}", ("n", args.args->size()));
+    auto id = args.args->at(0).as<transaction_id_type>();
+
+    auto &db = my->database();
+    auto result = db.with_weak_read_lock([&]() {
+        return my->find_transaction(id);
+    });
+    FC_ASSERT(result.valid(), "Unknown Transaction ${t}", ("t", id));
+    return *result;
+}
+
+fc::optional<annotated_signed_transaction> plugin::find_transaction(const transaction_id_type &id) const {
+    return my->find_transaction(id);
+}
+
+plugin::plugin() {
+}
+
+plugin::~plugin() {
+}
+
+void plugin::set_program_options(
+    boost::program_options::options_description &cli,
+    boost::program_options::options_description &cfg
+) {
+    cfg.add_options()
+        ("transaction-lookup-file",
+            boost::program_options::value<boost::filesystem::path>()->default_value("transaction-lookup.bin"),
+            "the location of the transaction index file (absolute path or relative to application data dir)");
+}
+
+void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
+    ilog("Initializing transaction lookup plugin");
+
+    my.reset(new plugin_impl);
+
+    auto file = options.at("transaction-lookup-file").as<boost::filesystem::path>();
+    if (file.is_relative()) {
+        file = appbase::app().data_dir() / file;
+    }
+    my->table.open(file);
+    my->indexed_block = my->table.head_block();
+
+    my->database().applied_block.connect([&](const signed_block &block) {
+        try {
+            my->on_applied_block(block);
+        } FC_CAPTURE_AND_LOG((block.block_num()))
+    });
+
+    JSON_RPC_REGISTER_API(name());
+}
+
+void plugin::plugin_startup() {
+}
+
+void plugin::plugin_shutdown() {
+    if (my->table.is_open()) {
+        my->table.commit(my->indexed_block);
+        my->table.close();
+    }
+}
+
+} } } // golos::plugins::transaction_lookup
@@ -0,0 +1,191 @@
+#include <golos/plugins/transaction_lookup/position_table.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+
+namespace golos {
+namespace plugins {
+namespace transaction_lookup {
+
+namespace bip = boost::interprocess;
+
+static const uint64_t table_magic = 0x70756b6f6f6c7874; // "txlookup"
+static const uint32_t table_version = 1;
+static const uint64_t initial_capacity = 1 << 20;
+
+struct position_table::header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t head_block;
+    uint64_t capacity;
+    uint64_t size;
+};
+
+struct position_table::slot {
+    uint64_t key;
+    uint32_t block;
+    uint32_t trx_in_block;
+};
+
+static uint64_t key_of(const transaction_id_type &id) {
+    uint64_t key;
+    std::memcpy(&key, id.data(), sizeof(key));
+    // zero marks an empty slot
+    return key ? key : 1;
+}
+
+static void create_file(const fc::path &file, uint64_t file_size) {
+    {
+        std::ofstream out(file.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        FC_ASSERT(out, "Can't create transaction index file ${f}", ("f", file));
+    }
+    // the file is zero-filled, zero key marks an empty slot
+    boost::filesystem::resize_file(file, file_size);
+}
+
+position_table::position_table() {
+}
+
+position_table::~position_table() {
+    close();
+}
+
+void position_table::open(const fc::path &file) {
+    close();
+
+    _file = file;
+    if (!fc::exists(_file)) {
+        if (_file.parent_path() != fc::path()) {
+            fc::create_directories(_file.parent_path());
+        }
+        create_file(_file, sizeof(header) + initial_capacity * sizeof(slot));
+    }
+    map(_file);
+
+    if (_header->magic == 0) {
+        _header->magic = table_magic;
+        _header->version = table_version;
+        _header->head_block = 0;
+        _header->capacity = initial_capacity;
+        _header->size = 0;
+    }
+    FC_ASSERT(_header->magic == table_magic && _header->version == table_version,
+        "Transaction index file ${f} has unknown format", ("f", _file));
+    FC_ASSERT(_region->get_size() == sizeof(header) + _header->capacity * sizeof(slot),
+        "Transaction index file ${f} has wrong size", ("f", _file));
+
+    ilog("Transaction index opened at block ${b} with ${n} transactions", ("b", _header->head_block)("n", _header->size));
+}
+
+void position_table::close() {
+    if (!is_open()) {
+        return;
+    }
+    _region->flush();
+    unmap();
+}
+
+void position_table::map(const fc::path &file) {
+    _mapping.reset(new bip::file_mapping(file.generic_string().c_str(), bip::read_write));
+    _region.reset(new bip::mapped_region(*_mapping, bip::read_write));
+    _header = reinterpret_cast<header *>(_region->get_address());
+    _slots = reinterpret_cast<slot *>(_header + 1);
+}
+
+void position_table::unmap() {
+    _header = nullptr;
+    _slots = nullptr;
+    _region.reset();
+    _mapping.reset();
+}
+
+uint32_t position_table::head_block() const {
+    return _header->head_block;
+}
+
+uint64_t position_table::size() const {
+    return _header->size;
+}
+
+void position_table::insert(const transaction_id_type &id, const trx_position &position) {
+    if ((_header->size + 1) * 2 > _header->capacity) {
+        grow();
+    }
+
+    const auto key = key_of(id);
+    const auto mask = _header->capacity - 1;
+    for (auto i = key & mask;; i = (i + 1) & mask) {
+        auto &s = _slots[i];
+        if (s.key == 0) {
+            s.key = key;
+            s.block = position.block;
+            s.trx_in_block = position.trx_in_block;
+            ++_header->size;
+            return;
+        }
+        if (s.key == key && s.block == position.block && s.trx_in_block == position.trx_in_block) {
+            return;
+        }
+    }
+}
+
+std::vector<trx_position> position_table::find(const transaction_id_type &id) const {
+    std::vector<trx_position> result;
+
+    const auto key = key_of(id);
+    const auto mask = _header->capacity - 1;
+    for (auto i = key & mask; _slots[i].key != 0; i = (i + 1) & mask) {
+        if (_slots[i].key == key) {
+            result.push_back({_slots[i].block, _slots[i].trx_in_block});
+        }
+    }
+    return result;
+}
+
+void position_table::commit(uint32_t block) {
+    _region->flush();
+    _header->head_block = block;
+    _region->flush(0, sizeof(header));
+}
+
+void position_table::grow() {
+    const auto old_capacity = _header->capacity;
+    const auto new_capacity = old_capacity * 2;
+    ilog("Growing transaction index to ${n} slots", ("n", new_capacity));
+
+    fc::path tmp_file = _file.generic_string() + ".tmp";
+    create_file(tmp_file, sizeof(header) + new_capacity * sizeof(slot));
+
+    bip::file_mapping mapping(tmp_file.generic_string().c_str(), bip::read_write);
+    bip::mapped_region region(mapping, bip::read_write);
+    auto *new_header = reinterpret_cast<header *>(region.get_address());
+    auto *new_slots = reinterpret_cast<slot *>(new_header + 1);
+
+    *new_header = *_header;
+    new_header->capacity = new_capacity;
+
+    const auto mask = new_capacity - 1;
+    for (uint64_t i = 0; i < old_capacity; ++i) {
+        if (_slots[i].key == 0) {
+            continue;
+        }
+        auto j = _slots[i].key & mask;
+        while (new_slots[j].key != 0) {
+            j = (j + 1) & mask;
+        }
+        new_slots[j] = _slots[i];
+    }
+    region.flush();
+
+    unmap();
+    fc::rename(tmp_file, _file);
+    map(_file);
+}
+
+} } } // golos::plugins::transaction_lookup
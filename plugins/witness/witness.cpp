@@ -429,9 +429,8 @@ namespace golos {
                 int retry = 0;
                 do {
                     try {
-                        // TODO: the same thread as used in chain-plugin,
-                        //       but in the future it should refactored to calling of a chain-plugin function
-                        auto block = db.generate_block(
+                        // TODO: the same thread as used in chain-plugin
+                        auto block = chain().generate_block(
                                 scheduled_time,
                                 scheduled_witness,
                                 private_key_itr->second,
@@ -20,6 +20,9 @@
 #include <golos/plugins/debug_node/plugin.hpp>
 #include <golos/plugins/raw_block/plugin.hpp>
 #include <golos/plugins/block_info/plugin.hpp>
+#include <golos/plugins/search/plugin.hpp>
+#include <golos/plugins/transaction_lookup/plugin.hpp>
+#include <golos/plugins/state_history/plugin.hpp>
 
 #include <fc/interprocess/signals.hpp>
 #include <fc/log/console_appender.hpp>
@@ -69,6 +72,9 @@ namespace golos {
             appbase::app().register_plugin<golos::plugins::auth_util::plugin>();
             appbase::app().register_plugin<golos::plugins::raw_block::plugin>();
             appbase::app().register_plugin<golos::plugins::block_info::plugin>();
+            appbase::app().register_plugin<golos::plugins::search::plugin>();
+            appbase::app().register_plugin<golos::plugins::transaction_lookup::plugin>();
+            appbase::app().register_plugin<golos::plugins::state_history::plugin>();
             appbase::app().register_plugin<golos::plugins::debug_node::plugin>();
             ///plugins
         };
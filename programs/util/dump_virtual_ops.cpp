@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <golos/chain/virtual_op_log.hpp>
+
+struct dumped_operation {
+    uint32_t block = 0;
+    uint32_t trx_in_block = 0;
+    uint16_t op_in_trx = 0;
+    golos::protocol::operation op;
+};
+
+FC_REFLECT((dumped_operation), (block)(trx_in_block)(op_in_trx)(op))
+
+// prints virtual operations of a range of blocks from the virtual_op_log, one json object per line
+int main(int argc, char **argv, char **envp) {
+    try {
+        if (argc < 2 || argc > 4) {
+            std::cerr << "Usage: " << argv[0] << " <path to virtual_op_log> [first block] [last block]" << std::endl;
+            return 1;
+        }
+
+        golos::chain::virtual_op_log log;
+        // the log can be read while golosd appends to it
+        log.open(fc::path(argv[1]), true);
+
+        uint32_t first_block = argc > 2 ? boost::lexical_cast<uint32_t>(argv[2]) : 1;
+        uint32_t last_block = argc > 3 ? boost::lexical_cast<uint32_t>(argv[3]) : log.head_block_num();
+
+        // blocks are read by parts to limit the memory
+        const uint32_t blocks_per_read = 10000;
+        dumped_operation dumped;
+        for (uint32_t first = first_block; first <= last_block && first <= log.head_block_num();) {
+            uint32_t last = first + std::min(blocks_per_read - 1, last_block - first);
+            for (const auto &b: log.read_range(first, last)) {
+                dumped.block = b.block_num;
+                for (const auto &vop: b.operations) {
+                    dumped.trx_in_block = vop.trx_in_block;
+                    dumped.op_in_trx = vop.op_in_trx;
+                    dumped.op = vop.op;
+                    std::cout << fc::json::to_string(dumped) << "\n";
+                }
+            }
+            if (last == last_block) {
+                break;
+            }
+            first = last + 1;
+        }
+        std::cout.flush();
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,441 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/program_options.hpp>
+#include <boost/range/adaptor/reversed.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <golos/network/core_messages.hpp>
+#include <golos/network/exceptions.hpp>
+#include <golos/network/node.hpp>
+
+namespace bpo = boost::program_options;
+
+using namespace golos::network;
+using golos::protocol::block_header;
+using golos::protocol::block_id_type;
+using golos::protocol::custom_operation;
+using golos::protocol::signed_block;
+using golos::protocol::signed_transaction;
+
+/// The chain all simulated nodes follow, each node has a prefix of it
+struct simulated_chain {
+    std::vector<signed_block> blocks; ///< block #n is blocks[n - 1]
+    std::vector<block_id_type> ids;
+    std::vector<fc::time_point> broadcast_times; ///< zero for blocks which existed before the start
+    std::unordered_map<item_hash_t, fc::time_point> transaction_broadcast_times; ///< by message hash
+
+    void push_block(const signed_block &block, fc::time_point broadcast_time) {
+        blocks.push_back(block);
+        ids.push_back(block.id());
+        broadcast_times.push_back(broadcast_time);
+    }
+
+    bool has_block(uint32_t head, const item_hash_t &id) const {
+        auto num = block_header::num_from_id(id);
+        return num > 0 && num <= head && ids[num - 1] == id;
+    }
+};
+
+/// Delays of items reaching nodes after they were broadcast
+struct latency_samples {
+    std::vector<fc::microseconds> samples;
+
+    void print(const std::string &name) const {
+        std::cout << name << ": " << samples.size() << " deliveries";
+        if (!samples.empty()) {
+            auto sorted = samples;
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&](double p) {
+                return sorted[size_t(p * (sorted.size() - 1))].count() / 1000;
+            };
+            std::cout << ", latency ms p50 " << percentile(0.5) << " p90 " << percentile(0.9)
+                      << " p99 " << percentile(0.99) << " max " << sorted.back().count() / 1000;
+        }
+        std::cout << std::endl;
+    }
+};
+
+/**
+ *  A node of the simulated network: the real p2p node with a delegate which keeps
+ *  its chain as a number of blocks of the simulated chain.
+ *
+ *  Handling of each block and transaction takes handle_delay, which stands for
+ *  validation and link latency, the loopback connections themselves have none.
+ */
+class simulated_node final : public node_delegate {
+public:
+    simulated_node(simulated_chain &chain, fc::microseconds handle_delay,
+            latency_samples &block_latency, latency_samples &transaction_latency)
+            : chain(chain), handle_delay(handle_delay),
+              block_latency(block_latency), transaction_latency(transaction_latency) {
+    }
+
+    simulated_chain &chain;
+    fc::microseconds handle_delay;
+    latency_samples &block_latency;
+    latency_samples &transaction_latency;
+
+    uint32_t head = 0;
+    std::unordered_set<item_hash_t> transactions; ///< message hashes of known transactions
+    std::unique_ptr<node> p2p;
+
+    bool has_item(const item_id &id) override {
+        if (id.item_type == block_message_type) {
+            return chain.has_block(head, id.item_hash);
+        }
+        return transactions.count(id.item_hash) != 0;
+    }
+
+    bool handle_block(const block_message &blk_msg, bool sync_mode,
+            std::vector<fc::uint160_t> &contained_transaction_message_ids) override {
+        if (handle_delay.count()) {
+            fc::usleep(handle_delay);
+        }
+
+        auto num = blk_msg.block.block_num();
+        if (num <= head) {
+            FC_ASSERT(chain.ids[num - 1] == blk_msg.block_id, "Block ${n} is on a fork", ("n", num));
+            return false;
+        }
+        FC_ASSERT(num == head + 1 && blk_msg.block.previous == get_head_block_id(),
+                "Block ${n} doesn't link to head block ${h}", ("n", num)("h", head));
+        head = num;
+
+        for (const auto &trx : blk_msg.block.transactions) {
+            auto id = message(trx_message(trx)).id();
+            transactions.insert(id);
+            contained_transaction_message_ids.push_back(id);
+        }
+        if (chain.broadcast_times[num - 1] != fc::time_point()) {
+            block_latency.samples.push_back(fc::time_point::now() - chain.broadcast_times[num - 1]);
+        }
+        return false;
+    }
+
+    void handle_transaction(const trx_message &trx_msg) override {
+        if (handle_delay.count()) {
+            fc::usleep(handle_delay);
+        }
+
+        auto id = message(trx_msg).id();
+        FC_ASSERT(transactions.insert(id).second, "Duplicate transaction");
+        auto itr = chain.transaction_broadcast_times.find(id);
+        if (itr != chain.transaction_broadcast_times.end()) {
+            transaction_latency.samples.push_back(fc::time_point::now() - itr->second);
+        }
+    }
+
+    void handle_message(const message &) override {
+        FC_THROW("Invalid Message Type");
+    }
+
+    std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t> &blockchain_synopsis,
+            uint32_t &remaining_item_count, uint32_t limit) override {
+        std::vector<item_hash_t> result;
+        remaining_item_count = 0;
+
+        uint32_t last_known_block_num = 0;
+        if (!blockchain_synopsis.empty()) {
+            bool found_a_block_in_synopsis = false;
+            for (const item_hash_t &id : boost::adaptors::reverse(blockchain_synopsis)) {
+                if (id == item_hash_t() || chain.has_block(head, id)) {
+                    last_known_block_num = block_header::num_from_id(id);
+                    found_a_block_in_synopsis = true;
+                    break;
+                }
+            }
+            if (!found_a_block_in_synopsis) {
+                FC_THROW_EXCEPTION(peer_is_on_an_unreachable_fork, "Unable to provide a list of blocks starting at any of the blocks in peer's synopsis");
+            }
+        }
+
+        for (uint32_t num = std::max<uint32_t>(last_known_block_num, 1); num <= head && result.size() < limit; ++num) {
+            result.push_back(chain.ids[num - 1]);
+        }
+        if (!result.empty() && block_header::num_from_id(result.back()) < head) {
+            remaining_item_count = head - block_header::num_from_id(result.back());
+        }
+        return result;
+    }
+
+    message get_item(const item_id &id) override {
+        if (id.item_type == block_message_type && chain.has_block(head, id.item_hash)) {
+            return block_message(chain.blocks[block_header::num_from_id(id.item_hash) - 1]);
+        }
+        FC_THROW_EXCEPTION(fc::key_not_found_exception, "Item not found");
+    }
+
+    std::vector<item_hash_t> get_blockchain_synopsis(const item_hash_t &reference_point,
+            uint32_t number_of_blocks_after_reference_point) override {
+        std::vector<item_hash_t> synopsis;
+        uint32_t high_block_num = head;
+        if (reference_point != item_hash_t()) {
+            FC_ASSERT(chain.has_block(head, reference_point), "Unknown reference point");
+            high_block_num = block_header::num_from_id(reference_point);
+        }
+        if (high_block_num == 0) {
+            return synopsis;
+        }
+
+        // the same spacing as the chain uses: halving the distance to the end each time
+        uint32_t true_high_block_num = high_block_num + number_of_blocks_after_reference_point;
+        uint32_t low_block_num = 1;
+        do {
+            synopsis.push_back(chain.ids[low_block_num - 1]);
+            low_block_num += (true_high_block_num - low_block_num + 2) / 2;
+        } while (low_block_num <= high_block_num);
+        return synopsis;
+    }
+
+    void sync_status(uint32_t, uint32_t) override {
+    }
+
+    void connection_count_changed(uint32_t) override {
+    }
+
+    uint32_t get_block_number(const item_hash_t &block_id) override {
+        return block_header::num_from_id(block_id);
+    }
+
+    fc::time_point_sec get_block_time(const item_hash_t &block_id) override {
+        if (chain.has_block(head, block_id)) {
+            return chain.blocks[block_header::num_from_id(block_id) - 1].timestamp;
+        }
+        return fc::time_point_sec::min();
+    }
+
+    fc::time_point_sec get_blockchain_now() override {
+        return fc::time_point::now();
+    }
+
+    item_hash_t get_head_block_id() const override {
+        return head ? chain.ids[head - 1] : block_id_type();
+    }
+
+    uint32_t estimate_last_known_fork_from_git_revision_timestamp(uint32_t) const override {
+        return 0;
+    }
+
+    void error_encountered(const std::string &, const fc::oexception &) override {
+    }
+};
+
+static signed_block make_block(const simulated_chain &chain, fc::time_point_sec timestamp,
+        std::vector<signed_transaction> transactions) {
+    signed_block block;
+    block.previous = chain.ids.empty() ? block_id_type() : chain.ids.back();
+    block.timestamp = timestamp;
+    block.witness = "simulator";
+    block.transactions = std::move(transactions);
+    block.transaction_merkle_root = block.calculate_merkle_root();
+    return block;
+}
+
+static signed_transaction make_transaction(uint64_t number, uint32_t size) {
+    custom_operation op;
+    op.required_auths.insert("simulator");
+    op.data.resize(std::max<uint32_t>(size, sizeof(number)));
+    memcpy(op.data.data(), &number, sizeof(number));
+
+    signed_transaction trx;
+    trx.expiration = fc::time_point_sec(fc::time_point::now()) + 60;
+    trx.operations.push_back(op);
+    return trx;
+}
+
+/// Bytes received by all nodes from the peers they are connected to now
+static uint64_t total_bytes_received(const std::vector<std::unique_ptr<simulated_node>> &nodes) {
+    uint64_t result = 0;
+    for (const auto &n : nodes) {
+        for (const auto &peer : n->p2p->get_connected_peers()) {
+            result += peer.info["bytesrecv"].as_uint64();
+        }
+    }
+    return result;
+}
+
+/// Waits until all nodes have the block, @return false on timeout
+static bool wait_for_head(const std::vector<std::unique_ptr<simulated_node>> &nodes, uint32_t head,
+        fc::time_point deadline) {
+    while (fc::time_point::now() < deadline) {
+        if (std::all_of(nodes.begin(), nodes.end(), [&](const std::unique_ptr<simulated_node> &n) {
+                return n->head >= head;
+            })) {
+            return true;
+        }
+        fc::usleep(fc::milliseconds(50));
+    }
+    return false;
+}
+
+/**
+ *  Runs a network of p2p nodes over loopback in one process: the first node has a chain
+ *  the others sync, then it produces blocks while random nodes broadcast transactions.
+ *  Prints sync throughput, propagation latency percentiles and traffic compared to
+ *  the size of the data delivered.
+ */
+int main(int argc, char **argv, char **envp) {
+    try {
+        bpo::options_description options("Options");
+        options.add_options()
+                ("help,h", "Print this help message and exit.")
+                ("nodes", bpo::value<uint32_t>()->default_value(20), "Number of nodes.")
+                ("connections", bpo::value<uint32_t>()->default_value(8), "Desired number of connections of each node.")
+                ("port", bpo::value<uint16_t>()->default_value(31000), "Nodes listen on 127.0.0.1 on ports starting from this one.")
+                ("sync-blocks", bpo::value<uint32_t>()->default_value(2000), "Number of blocks the nodes sync at the start.")
+                ("blocks", bpo::value<uint32_t>()->default_value(20), "Number of blocks produced after the sync.")
+                ("block-interval-ms", bpo::value<uint32_t>()->default_value(1000), "Interval between produced blocks.")
+                ("transactions-per-block", bpo::value<uint32_t>()->default_value(50), "Number of transactions broadcast between blocks.")
+                ("transaction-size", bpo::value<uint32_t>()->default_value(200), "Size of data in each transaction.")
+                ("handle-delay-ms", bpo::value<uint32_t>()->default_value(0), "Time each node takes to handle a block or a transaction, stands for validation and link latency.")
+                ("bandwidth", bpo::value<uint32_t>()->default_value(0), "Upload and download limit of each node in bytes per second, 0 is unlimited.")
+                ("timeout", bpo::value<uint32_t>()->default_value(300), "Seconds to wait for each phase.")
+                ("data-dir", bpo::value<std::string>(), "Directory for node configurations, they are kept in its p2p-simulator subdirectory, the temporary directory by default.");
+
+        bpo::variables_map args;
+        bpo::store(bpo::parse_command_line(argc, argv, options), args);
+        if (args.count("help")) {
+            std::cout << options << std::endl;
+            return 0;
+        }
+
+        fc::logger::get("default").set_log_level(fc::log_level::warn);
+        fc::logger::get("p2p").set_log_level(fc::log_level::warn);
+        fc::logger::get("sync").set_log_level(fc::log_level::warn);
+
+        auto node_count = std::max<uint32_t>(args["nodes"].as<uint32_t>(), 2);
+        auto connections = args["connections"].as<uint32_t>();
+        auto sync_blocks = args["sync-blocks"].as<uint32_t>();
+        auto blocks = args["blocks"].as<uint32_t>();
+        auto block_interval = fc::milliseconds(args["block-interval-ms"].as<uint32_t>());
+        auto transactions_per_block = args["transactions-per-block"].as<uint32_t>();
+        auto transaction_size = args["transaction-size"].as<uint32_t>();
+        auto timeout = fc::seconds(args["timeout"].as<uint32_t>());
+        auto bandwidth = args["bandwidth"].as<uint32_t>();
+
+        // only the subdirectory is removed, the given directory can hold anything else
+        fc::path data_dir = (args.count("data-dir") ? fc::path(args["data-dir"].as<std::string>())
+                                                    : fc::temp_directory_path()) / "p2p-simulator";
+        // peer databases of previous runs would mislead the nodes
+        fc::remove_all(data_dir);
+
+        simulated_chain chain;
+        latency_samples block_latency;
+        latency_samples transaction_latency;
+
+        auto start_time = fc::time_point_sec(fc::time_point::now()) - sync_blocks;
+        for (uint32_t i = 0; i < sync_blocks; ++i) {
+            chain.push_block(make_block(chain, start_time + i, {}), fc::time_point());
+        }
+
+        std::mt19937 random(node_count);
+        std::vector<std::unique_ptr<simulated_node>> nodes;
+        for (uint32_t i = 0; i < node_count; ++i) {
+            nodes.emplace_back(new simulated_node(chain, fc::milliseconds(args["handle-delay-ms"].as<uint32_t>()),
+                    block_latency, transaction_latency));
+            auto &n = *nodes.back();
+            if (i == 0) {
+                n.head = sync_blocks;
+            }
+
+            n.p2p.reset(new node("p2p_simulator"));
+            n.p2p->load_configuration(data_dir / std::to_string(i));
+            n.p2p->listen_on_endpoint(fc::ip::endpoint(fc::ip::address("127.0.0.1"), args["port"].as<uint16_t>() + i), false);
+            n.p2p->accept_incoming_connections(true);
+            fc::mutable_variant_object params;
+            params["desired_number_of_connections"] = connections;
+            params["maximum_number_of_connections"] = connections * 2;
+            n.p2p->set_advanced_node_parameters(params);
+            if (bandwidth) {
+                n.p2p->set_total_bandwidth_limit(bandwidth, bandwidth);
+            }
+            n.p2p->set_node_delegate(&n);
+            n.p2p->listen_to_p2p_network();
+
+            // a few random seeds, the rest of the network is found through address exchange
+            for (uint32_t seed = 0; seed < std::min(i, std::max<uint32_t>(connections / 2, 1)); ++seed) {
+                auto &seed_node = *nodes[random() % i];
+                n.p2p->add_node(seed_node.p2p->get_actual_listening_endpoint());
+            }
+            n.p2p->connect_to_p2p_network();
+            n.p2p->sync_from(item_id(block_message_type, n.get_head_block_id()), std::vector<uint32_t>());
+        }
+
+        std::cout << "Started " << node_count << " nodes" << std::endl;
+
+        // sync
+        auto sync_start = fc::time_point::now();
+        bool synced = wait_for_head(nodes, sync_blocks, sync_start + timeout);
+        auto sync_time = fc::time_point::now() - sync_start;
+        std::cout << "Sync of " << sync_blocks << " blocks " << (synced ? "finished" : "timed out") << " in "
+                  << sync_time.count() / 1000 << " ms, "
+                  << std::fixed << std::setprecision(1)
+                  << double(sync_blocks) * 1000000 / std::max<int64_t>(sync_time.count(), 1) << " blocks/s per node" << std::endl;
+
+        // live blocks and transactions
+        auto bytes_before = total_bytes_received(nodes);
+        uint64_t delivered_bytes = 0;
+        uint64_t transaction_number = 0;
+        for (uint32_t b = 0; b < blocks; ++b) {
+            std::vector<signed_transaction> transactions;
+            for (uint32_t t = 0; t < transactions_per_block; ++t) {
+                transactions.push_back(make_transaction(transaction_number++, transaction_size));
+                message msg(trx_message(transactions.back()));
+                delivered_bytes += msg.size * (node_count - 1);
+
+                auto &origin = *nodes[random() % node_count];
+                origin.transactions.insert(msg.id());
+                chain.transaction_broadcast_times[msg.id()] = fc::time_point::now();
+                origin.p2p->broadcast(msg);
+                fc::usleep(block_interval / std::max<uint32_t>(transactions_per_block, 1));
+            }
+            if (!transactions_per_block) {
+                fc::usleep(block_interval);
+            }
+
+            auto &producer = *nodes[0];
+            chain.push_block(make_block(chain, fc::time_point::now(), std::move(transactions)), fc::time_point::now());
+            producer.head = chain.blocks.size();
+            message msg(block_message(chain.blocks.back()));
+            delivered_bytes += msg.size * (node_count - 1);
+            producer.p2p->broadcast(msg);
+        }
+        bool propagated = wait_for_head(nodes, chain.blocks.size(), fc::time_point::now() + timeout);
+        // let the last transactions and inventory settle
+        fc::usleep(fc::seconds(1));
+        auto received_bytes = total_bytes_received(nodes) - bytes_before;
+
+        std::cout << "Propagation of " << blocks << " blocks " << (propagated ? "finished" : "timed out") << std::endl;
+        block_latency.print("Blocks");
+        transaction_latency.print("Transactions");
+        std::cout << "Transactions delivered separately: "
+                  << double(transaction_latency.samples.size()) * 100 /
+                     std::max<uint64_t>(transaction_number * (node_count - 1), 1) << "%" << std::endl;
+        std::cout << "Traffic: " << received_bytes << " bytes received for " << delivered_bytes
+                  << " bytes of blocks and transactions, "
+                  << double(received_bytes) / std::max<uint64_t>(delivered_bytes, 1) << "x" << std::endl;
+
+        for (auto &n : nodes) {
+            n->p2p->close();
+        }
+        nodes.clear();
+        fc::remove_all(data_dir);
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -45,6 +45,11 @@ if [[ ! -z "$STEEMD_PRIVATE_KEY" ]]; then
     ARGS+=" --private-key=$STEEMD_PRIVATE_KEY"
 fi
 
+# blocks exported from another node, applied before connecting to the network
+if [[ ! -z "$STEEMD_IMPORT_BLOCKS" ]]; then
+    ARGS+=" --import-blocks=$STEEMD_IMPORT_BLOCKS"
+fi
+
 # overwrite local config with image one
 cp /etc/golosd/config.ini $HOME/config.ini
 
@@ -108,7 +108,7 @@ namespace golos {
             return "anon-acct-x" + std::to_string(anon_acct_count++);
         }
 
-        void database_fixture::initialize() {
+        void database_fixture::initialize(const std::vector<std::string> &args) {
             int argc = boost::unit_test::framework::master_test_suite().argc;
             char **argv = boost::unit_test::framework::master_test_suite().argv;
             for (int i = 1; i < argc; i++) {
@@ -127,11 +127,16 @@ namespace golos {
             ah_plugin = &appbase::app().register_plugin<account_history::plugin>();
             db_plugin = &appbase::app().register_plugin<debug_node::plugin>();
 
+            std::vector<char *> all_args(argv, argv + argc);
+            for (const auto &arg: args) {
+                all_args.push_back(const_cast<char *>(arg.c_str()));
+            }
+
             appbase::app().initialize<
                     golos::plugins::chain::plugin,
                     account_history::plugin,
                     debug_node::plugin
-            >( argc, argv );
+            >( all_args.size(), all_args.data() );
 
             db_plugin->set_logging(false);
 
@@ -446,6 +451,14 @@ namespace golos {
             trx.sign(key, db->get_chain_id());
         }
 
+        void database_fixture::push_operation(const operation &op, const fc::ecc::private_key &key, uint32_t expiration) {
+            signed_transaction tx;
+            tx.operations.push_back(op);
+            tx.set_expiration(db->head_block_time() + expiration);
+            tx.sign(key, db->get_chain_id());
+            db->push_transaction(tx, 0);
+        }
+
         vector<operation> database_fixture::get_last_operations(uint32_t num_ops) {
             vector<operation> ops;
             const auto &acc_hist_idx = db->get_index<account_history_index>().indices().get<by_id>();
@@ -7,6 +7,8 @@
 #include <fc/io/json.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <boost/program_options.hpp>
+
 #include <golos/plugins/debug_node/plugin.hpp>
 #include <golos/plugins/account_history/plugin.hpp>
 
@@ -180,7 +182,11 @@ namespace golos {
 
             string generate_anon_acct_name();
 
-            void initialize();
+            /**
+             * @brief Initializes the chain, account_history and debug_node plugins
+             * @param args arguments added to the command line of the test runner, e.g. options of account_history
+             */
+            void initialize(const std::vector<std::string> &args = std::vector<std::string>());
             void startup(bool generate_hardfork = true);
 
             void open_database();
@@ -252,6 +258,28 @@ namespace golos {
 
             void sign(signed_transaction &trx, const fc::ecc::private_key &key);
 
+            /// Signs a transaction with the single operation and pushes it
+            void push_operation(const operation &op, const fc::ecc::private_key &key,
+                    uint32_t expiration = STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+
+            /**
+             * @brief Registers a plugin and initializes it with the command line arguments
+             *
+             * Should be called after initialize() and before open_database(),
+             * the plugin is started by plugin_startup() after startup()
+             */
+            template<typename Plugin>
+            Plugin *initialize_plugin(const std::vector<std::string> &args = std::vector<std::string>()) {
+                auto *plugin = &appbase::app().register_plugin<Plugin>();
+                boost::program_options::options_description cli, cfg;
+                plugin->set_program_options(cli, cfg);
+                boost::program_options::variables_map options;
+                boost::program_options::store(
+                        boost::program_options::command_line_parser(args).options(cfg).run(), options);
+                plugin->plugin_initialize(options);
+                return plugin;
+            }
+
             vector<operation> get_last_operations(uint32_t ops);
 
             void validate_database(void);
@@ -0,0 +1,102 @@
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/account_history/plugin.hpp>
+#include <golos/plugins/account_history/history_objects.hpp>
+
+#include "database_fixture.hpp"
+
+using namespace golos::chain;
+using namespace golos::protocol;
+using namespace golos::plugins::account_history;
+
+struct account_history_archive_fixture : public database_fixture {
+    fc::path archive_dir = fc::temp_directory_path() / "account-history-plugin-test";
+
+    account_history_archive_fixture() {
+        fc::remove_all(archive_dir);
+        initialize({"--history-archive=true", "--history-archive-dir=" + archive_dir.generic_string()});
+        open_database();
+        startup();
+    }
+
+    ~account_history_archive_fixture() {
+        ah_plugin->plugin_shutdown();
+        fc::remove_all(archive_dir);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(account_history_plugin, account_history_archive_fixture)
+
+    BOOST_AUTO_TEST_CASE(archive_restart_query) {
+        try {
+            ACTORS((alice)(bob))
+            fund("alice", 100000);
+            generate_block();
+
+            const uint32_t transfers = 20;
+            for (uint32_t i = 0; i < transfers; ++i) {
+                transfer("alice", "bob", i + 1);
+                generate_block();
+            }
+            auto last_transfer_block = db->head_block_num();
+            for (uint32_t i = 0; i < 100 && db->last_non_undoable_block_num() < last_transfer_block; ++i) {
+                generate_block();
+            }
+            BOOST_REQUIRE_GE(db->last_non_undoable_block_num(), last_transfer_block);
+
+            const uint64_t transfer_mask = uint64_t(1) << operation::tag<transfer_operation>::value;
+            auto history = ah_plugin->get_account_history("alice", uint64_t(-1), 1000);
+            auto transfer_history = ah_plugin->get_account_history("alice", uint64_t(-1), 1000, transfer_mask);
+            BOOST_REQUIRE_EQUAL(transfer_history.size(), transfers);
+
+            // entries of archived operations are removed with them
+            const auto &hist_idx = db->get_index<account_history_index>().indices().get<by_id>();
+            for (const auto &entry: hist_idx) {
+                BOOST_CHECK(db->find(entry.op) != nullptr);
+            }
+            const auto &aop_idx = db->get_index<account_operation_index>().indices().get<by_id>();
+            for (const auto &entry: aop_idx) {
+                BOOST_CHECK(db->find(entry.op) != nullptr);
+            }
+            const auto &op_idx = db->get_index<operation_index>().indices().get<by_id>();
+            for (const auto &op: op_idx) {
+                BOOST_CHECK_GT(op.block, last_transfer_block);
+            }
+
+            // as after a restart of the node
+            ah_plugin->plugin_shutdown();
+            history_archive archive;
+            archive.open(archive_dir);
+            BOOST_REQUIRE_GE(archive.head_block(), last_transfer_block);
+
+            auto sequences = archive.find("alice", uint32_t(-1), 1000, transfer_mask);
+            BOOST_REQUIRE_EQUAL(sequences.size(), transfers);
+            for (auto sequence: sequences) {
+                BOOST_REQUIRE(transfer_history.count(sequence));
+                archived_operation op;
+                BOOST_REQUIRE(archive.get("alice", sequence, op));
+                BOOST_CHECK_EQUAL(op.block, transfer_history[sequence].block);
+                BOOST_CHECK(op.trx_id == transfer_history[sequence].trx_id);
+                auto transfer = fc::raw::unpack<operation>(op.serialized_op).get<transfer_operation>();
+                BOOST_CHECK_EQUAL(transfer.to, "bob");
+            }
+
+            for (const auto &entry: history) {
+                if (entry.second.block > archive.head_block()) {
+                    continue;
+                }
+                archived_operation op;
+                BOOST_REQUIRE(archive.get("alice", entry.first, op));
+                BOOST_CHECK_EQUAL(op.block, entry.second.block);
+                BOOST_CHECK(op.serialized_op == entry.second.serialized_op);
+            }
+            archive.close();
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -0,0 +1,114 @@
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/account_history/history_archive.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <algorithm>
+
+using namespace golos::plugins::account_history;
+
+BOOST_AUTO_TEST_SUITE(account_history_archive)
+
+    BOOST_AUTO_TEST_CASE(entries_over_several_pages) {
+        auto dir = fc::temp_directory_path() / "account-history-archive-pages-test";
+        fc::remove_all(dir);
+
+        // alice gets more entries than fit a page, pages of bob go between them,
+        // type 9 is only in the first 10 entries of alice, so the other pages of alice are skipped
+        const uint32_t count = 3000;
+        {
+            history_archive archive;
+            archive.open(dir);
+            for (uint32_t i = 0; i < count; ++i) {
+                archived_operation op;
+                op.block = i + 1;
+                std::vector<account_name_type> accounts = {"alice"};
+                if (i % 3 == 0) {
+                    accounts.push_back("bob");
+                }
+                archive.append(op, i < 10 ? 9 : i % 4, accounts);
+                if (i % 1000 == 999) {
+                    archive.commit(i + 1);
+                }
+            }
+        }
+
+        history_archive archive;
+        archive.open(dir);
+        BOOST_CHECK_EQUAL(archive.head_block(), count);
+        BOOST_REQUIRE_EQUAL(archive.size("alice"), count);
+        BOOST_REQUIRE_EQUAL(archive.size("bob"), count / 3);
+
+        archived_operation op;
+        for (uint32_t sequence: {0u, 509u, 510u, 511u, 1020u, count - 1}) {
+            BOOST_REQUIRE(archive.get("alice", sequence, op));
+            BOOST_CHECK_EQUAL(op.block, sequence + 1);
+        }
+        BOOST_REQUIRE(archive.get("bob", count / 3 - 1, op));
+        BOOST_CHECK_EQUAL(op.block, count - 2);
+
+        auto sequences = archive.find("alice", uint32_t(-1), 20, uint64_t(1) << 9);
+        BOOST_REQUIRE_EQUAL(sequences.size(), 10);
+        BOOST_CHECK_EQUAL(sequences.front(), 9);
+        BOOST_CHECK_EQUAL(sequences.back(), 0);
+
+        // the newest entries of type 1 not newer than an entry on the border of pages
+        sequences = archive.find("alice", 1021, 4, uint64_t(1) << 1);
+        BOOST_CHECK(sequences == std::vector<uint32_t>({1021, 1017, 1013, 1009}));
+
+        archive.close();
+        fc::remove_all(dir);
+    }
+
+    BOOST_AUTO_TEST_CASE(append_find_reopen) {
+        auto dir = fc::temp_directory_path() / "account-history-archive-test";
+        fc::remove_all(dir);
+
+        {
+            history_archive archive;
+            archive.open(dir);
+
+            for (uint32_t i = 0; i < 200; ++i) {
+                archived_operation op;
+                op.block = i + 1;
+                op.serialized_op.assign(i % 7 + 1, char(i));
+                // alice gets every operation, bob every other, types alternate between 2 and 5
+                std::vector<account_name_type> accounts = {"alice"};
+                if (i % 2 == 0) {
+                    accounts.push_back("bob");
+                }
+                archive.append(op, i % 3 ? 2 : 5, accounts);
+            }
+            archive.commit(200);
+
+            // not committed, dropped on reopen
+            archive.append(archived_operation(), 2, {"alice"});
+        }
+
+        history_archive archive;
+        archive.open(dir);
+        BOOST_CHECK_EQUAL(archive.head_block(), 200);
+        BOOST_CHECK_EQUAL(archive.size("alice"), 200);
+        BOOST_CHECK_EQUAL(archive.size("bob"), 100);
+        BOOST_CHECK_EQUAL(archive.size("sam"), 0);
+
+        archived_operation op;
+        BOOST_REQUIRE(archive.get("bob", 10, op));
+        BOOST_CHECK_EQUAL(op.block, 21);
+        BOOST_CHECK_EQUAL(op.serialized_op.size(), 20 % 7 + 1);
+        BOOST_CHECK(!archive.get("bob", 100, op));
+
+        auto sequences = archive.find("alice", 100, 5, uint64_t(1) << 5);
+        BOOST_CHECK(sequences == std::vector<uint32_t>({99, 96, 93, 90, 87}));
+
+        sequences = archive.find("alice", uint32_t(-1), 3, (uint64_t(1) << 2) | (uint64_t(1) << 5));
+        BOOST_CHECK(sequences == std::vector<uint32_t>({199, 198, 197}));
+
+        BOOST_CHECK(archive.find("bob", 1000, 10, uint64_t(1) << 7).empty());
+
+        archive.close();
+        fc::remove_all(dir);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/chain/block_consumer.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace golos::plugins::chain;
+
+struct block_consumer_fixture {
+    std::mutex mutex;
+    std::vector<uint32_t> processed;
+    std::vector<bool> on_consumer_thread;
+
+    // the handler waits for the gate before processing a block
+    std::promise<void> gate_promise;
+    std::shared_future<void> gate = gate_promise.get_future().share();
+
+    block_consumer_handler handler(bool gated = false) {
+        return [this, gated](const applied_block_notification &block) {
+            if (gated) {
+                gate.wait();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            processed.push_back(block.block_num);
+            on_consumer_thread.push_back(block_consumer::in_consumer_thread());
+        };
+    }
+
+    static std::shared_ptr<const applied_block_notification> block(uint32_t block_num) {
+        auto result = std::make_shared<applied_block_notification>();
+        result->block_num = block_num;
+        return result;
+    }
+
+    std::vector<uint32_t> processed_blocks() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return processed;
+    }
+
+    static std::vector<uint32_t> blocks(uint32_t from, uint32_t to) {
+        std::vector<uint32_t> result;
+        for (uint32_t i = from; i <= to; ++i) {
+            result.push_back(i);
+        }
+        return result;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(block_consumer_tests, block_consumer_fixture)
+
+    BOOST_AUTO_TEST_CASE(blocks_in_push_order) {
+        block_consumer consumer("test", handler(), 1000);
+        for (uint32_t i = 1; i <= 100; ++i) {
+            consumer.push(block(i));
+        }
+        consumer.wait();
+
+        BOOST_CHECK(processed_blocks() == blocks(1, 100));
+        for (bool on_thread: on_consumer_thread) {
+            BOOST_CHECK(on_thread);
+        }
+        BOOST_CHECK(!block_consumer::in_consumer_thread());
+    }
+
+    BOOST_AUTO_TEST_CASE(failed_block_does_not_stop_consumer) {
+        block_consumer consumer("test", [this](const applied_block_notification &b) {
+            if (b.block_num == 2) {
+                throw std::runtime_error("failed");
+            }
+            handler()(b);
+        }, 10);
+        for (uint32_t i = 1; i <= 3; ++i) {
+            consumer.push(block(i));
+        }
+        consumer.wait();
+
+        BOOST_CHECK(processed_blocks() == std::vector<uint32_t>({1, 3}));
+    }
+
+    BOOST_AUTO_TEST_CASE(wait_for_capacity_of_bounded_queue) {
+        const uint32_t max_queue_size = 2;
+        block_consumer consumer("test", handler(true), max_queue_size);
+
+        // a block is processed by the handler, the others wait in the queue
+        for (uint32_t i = 1; i <= max_queue_size + 1; ++i) {
+            consumer.push(block(i));
+        }
+        auto capacity = std::async(std::launch::async, [&]() {
+            consumer.wait_for_capacity();
+        });
+        BOOST_CHECK(capacity.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout);
+        BOOST_CHECK(processed_blocks().empty());
+
+        gate_promise.set_value();
+        BOOST_REQUIRE(capacity.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        consumer.wait();
+        BOOST_CHECK(processed_blocks() == blocks(1, max_queue_size + 1));
+
+        // with the free queue it doesn't wait
+        consumer.wait_for_capacity();
+    }
+
+    BOOST_AUTO_TEST_CASE(stop_processes_pushed_blocks) {
+        block_consumer consumer("test", handler(true), 1);
+        for (uint32_t i = 1; i <= 10; ++i) {
+            consumer.push(block(i));
+        }
+
+        // the stopped consumer doesn't hold the writer
+        auto stopped = std::async(std::launch::async, [&]() {
+            consumer.stop();
+        });
+        auto capacity = std::async(std::launch::async, [&]() {
+            consumer.wait_for_capacity();
+        });
+        BOOST_CHECK(capacity.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+        gate_promise.set_value();
+        BOOST_REQUIRE(stopped.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        BOOST_CHECK(processed_blocks() == blocks(1, 10));
+
+        // blocks pushed after the stop are dropped
+        consumer.push(block(11));
+        consumer.wait();
+        consumer.stop();
+        BOOST_CHECK(processed_blocks() == blocks(1, 10));
+    }
+
+    BOOST_AUTO_TEST_CASE(set_calls_handlers_until_started) {
+        block_consumer_set consumers;
+        consumers.add("test", handler());
+        BOOST_CHECK(!consumers.empty());
+
+        consumers.notify(block(1), false);
+        BOOST_CHECK(processed_blocks() == std::vector<uint32_t>({1}));
+        BOOST_CHECK(!on_consumer_thread.back());
+
+        consumers.start(10);
+        BOOST_CHECK(consumers.started());
+        BOOST_CHECK_THROW(consumers.add("late", handler()), fc::exception);
+
+        consumers.notify(block(2), false);
+        consumers.wait();
+        BOOST_CHECK(processed_blocks() == blocks(1, 2));
+        BOOST_CHECK(on_consumer_thread.back());
+
+        // after the stop the handlers are called on the caller's thread again
+        consumers.stop();
+        consumers.notify(block(3), false);
+        BOOST_CHECK(processed_blocks() == blocks(1, 3));
+        BOOST_CHECK(!on_consumer_thread.back());
+    }
+
+    BOOST_AUTO_TEST_CASE(set_replay_fallback_keeps_order) {
+        block_consumer_set consumers;
+        consumers.add("test", handler(true));
+        consumers.start(100);
+
+        for (uint32_t i = 1; i <= 10; ++i) {
+            consumers.notify(block(i), false);
+        }
+
+        // as in a replay: the queued blocks are processed before the synchronous call of the handler
+        auto replayed = std::async(std::launch::async, [&]() {
+            consumers.notify(block(11), true);
+        });
+        BOOST_CHECK(replayed.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout);
+
+        gate_promise.set_value();
+        BOOST_REQUIRE(replayed.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        BOOST_CHECK(processed_blocks() == blocks(1, 11));
+        BOOST_CHECK(!on_consumer_thread.back());
+        for (uint32_t i = 0; i < 10; ++i) {
+            BOOST_CHECK(on_consumer_thread[i]);
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
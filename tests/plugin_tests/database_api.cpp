@@ -0,0 +1,337 @@
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/database_api/plugin.hpp>
+#include <golos/plugins/database_api/witness_votes_object.hpp>
+#include <golos/chain/history_object.hpp>
+
+#include "database_fixture.hpp"
+
+#include <algorithm>
+#include <map>
+
+using namespace golos::chain;
+using namespace golos::protocol;
+using golos::plugins::database_api::applied_operation;
+using golos::plugins::database_api::account_witness_votes_object;
+using golos::plugins::database_api::account_witness_votes_index;
+
+struct database_api_fixture : public database_fixture {
+    golos::plugins::database_api::plugin *api_plugin = nullptr;
+
+    database_api_fixture(const std::vector<std::string> &args = std::vector<std::string>()) {
+        initialize();
+
+        api_plugin = initialize_plugin<golos::plugins::database_api::plugin>(args);
+
+        db->set_store_virtual_operations(true);
+        open_database();
+        startup();
+        api_plugin->plugin_startup();
+    }
+
+    void limit_order(const std::string &owner, const fc::ecc::private_key &key, asset sell, asset receive) {
+        limit_order_create_operation op;
+        op.owner = owner;
+        op.orderid = 1;
+        op.amount_to_sell = sell;
+        op.min_to_receive = receive;
+        op.expiration = db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION;
+        push_operation(op, key);
+    }
+
+    std::vector<applied_operation> get_ops_in_block(uint32_t block_num, bool only_virtual) {
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(block_num), fc::variant(only_virtual)});
+        return api_plugin->get_ops_in_block(msg);
+    }
+
+    std::vector<applied_operation> get_virtual_ops_in_range(uint32_t from_block, uint32_t block_count) {
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(from_block), fc::variant(block_count)});
+        return api_plugin->get_virtual_ops_in_range(msg);
+    }
+
+    std::vector<std::string> get_account_names(const std::vector<std::string> &names) {
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(names)});
+        std::vector<std::string> result;
+        for (const auto &account: api_plugin->get_accounts(msg)) {
+            BOOST_CHECK_EQUAL(account.balance.amount.value, db->get_account(account.name).balance.amount.value);
+            result.push_back(account.name);
+        }
+        return result;
+    }
+
+    // accounts with names in the reverse order of creation, so the index order differs from the request
+    std::vector<std::string> create_accounts(uint32_t count) {
+        std::vector<std::string> names;
+        for (uint32_t i = 0; i < count; ++i) {
+            names.push_back("z" + std::to_string(count - i) + "-account");
+            account_create(names.back(), init_account_pub_key);
+            fund(names.back(), i + 1);
+        }
+        generate_block();
+        return names;
+    }
+
+    void witness_vote(const std::string &account, const fc::ecc::private_key &key, const std::string &witness, bool approve) {
+        account_witness_vote_operation op;
+        op.account = account;
+        op.witness = witness;
+        op.approve = approve;
+        push_operation(op, key);
+    }
+
+    // witnesses of the account in the cache of the plugin
+    std::vector<std::string> cached_witness_votes(const std::string &account) const {
+        std::vector<std::string> result;
+        const auto *votes = db->find<account_witness_votes_object, by_account>(account);
+        if (votes != nullptr) {
+            for (const auto &witness: votes->witnesses) {
+                result.push_back(std::string(witness));
+            }
+        }
+        return result;
+    }
+
+    // witnesses of all accounts in the cache of the plugin
+    std::map<std::string, std::vector<std::string>> cached_witness_votes() const {
+        std::map<std::string, std::vector<std::string>> result;
+        for (const auto &votes: db->get_index<account_witness_votes_index>().indices()) {
+            result[std::string(votes.account)] = cached_witness_votes(std::string(votes.account));
+        }
+        return result;
+    }
+};
+
+struct get_accounts_threads_fixture : public database_api_fixture {
+    get_accounts_threads_fixture() : database_api_fixture({"--get-accounts-threads=4"}) {
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(database_api_plugin, database_api_fixture)
+
+    BOOST_AUTO_TEST_CASE(get_ops_in_block_without_operation_index) {
+        try {
+            ACTORS((alice)(bob))
+            fund("alice", ASSET("10.000 GBG"));
+            fund("bob", ASSET("10.000 GOLOS"));
+            generate_block();
+
+            // the second order fills the first one, which gives a fill_order virtual operation
+            limit_order("alice", alice_private_key, ASSET("10.000 GBG"), ASSET("10.000 GOLOS"));
+            limit_order("bob", bob_private_key, ASSET("10.000 GOLOS"), ASSET("10.000 GBG"));
+            generate_block();
+            auto block_num = db->head_block_num();
+
+            std::vector<applied_operation> indexed;
+            const auto &idx = db->get_index<operation_index>().indices().get<by_location>();
+            for (auto itr = idx.lower_bound(block_num); itr != idx.end() && itr->block == block_num;) {
+                indexed.emplace_back(*itr);
+                db->remove(*itr++);
+            }
+            auto fill_order = std::find_if(indexed.begin(), indexed.end(), [](const applied_operation &o) {
+                return o.op.which() == operation::tag<fill_order_operation>::value;
+            });
+            BOOST_REQUIRE(fill_order != indexed.end());
+
+            auto restored = get_ops_in_block(block_num, false);
+            BOOST_REQUIRE_EQUAL(restored.size(), indexed.size());
+            for (size_t i = 0; i < indexed.size(); ++i) {
+                BOOST_CHECK(restored[i].trx_id == indexed[i].trx_id);
+                BOOST_CHECK_EQUAL(restored[i].block, indexed[i].block);
+                BOOST_CHECK_EQUAL(restored[i].trx_in_block, indexed[i].trx_in_block);
+                BOOST_CHECK_EQUAL(restored[i].op_in_trx, indexed[i].op_in_trx);
+                BOOST_CHECK(restored[i].timestamp == indexed[i].timestamp);
+                BOOST_CHECK(restored[i].op.which() == indexed[i].op.which());
+            }
+
+            // restored virtual operations are numbered by their position in the log of the block
+            auto restored_virtual = get_ops_in_block(block_num, true);
+            BOOST_REQUIRE(!restored_virtual.empty());
+            for (size_t i = 0; i < restored_virtual.size(); ++i) {
+                BOOST_CHECK(is_virtual_operation(restored_virtual[i].op));
+                BOOST_CHECK_EQUAL(restored_virtual[i].virtual_op, i + 1);
+            }
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(get_virtual_ops_in_range_from_first_stored_block) {
+        try {
+            ACTORS((alice)(bob))
+            fund("alice", ASSET("10.000 GBG"));
+            fund("bob", ASSET("10.000 GOLOS"));
+            generate_block();
+
+            limit_order("alice", alice_private_key, ASSET("10.000 GBG"), ASSET("10.000 GOLOS"));
+            limit_order("bob", bob_private_key, ASSET("10.000 GOLOS"), ASSET("10.000 GBG"));
+            generate_block();
+            auto block_num = db->head_block_num();
+
+            BOOST_CHECK_EQUAL(db->first_stored_virtual_operations_block(), 1);
+            BOOST_CHECK_THROW(get_virtual_ops_in_range(0, 1), fc::exception);
+
+            auto ops = get_virtual_ops_in_range(block_num, 1);
+            auto fill_order = std::find_if(ops.begin(), ops.end(), [](const applied_operation &o) {
+                return o.op.which() == operation::tag<fill_order_operation>::value;
+            });
+            BOOST_REQUIRE(fill_order != ops.end());
+            BOOST_CHECK_EQUAL(fill_order->block, block_num);
+            BOOST_CHECK_NE(fill_order->virtual_op, 0);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(get_accounts_keeps_order_and_repeats) {
+        try {
+            auto names = create_accounts(5);
+
+            std::vector<std::string> request = {names[3], "nobody", names[0], names[3], names[4], names[0]};
+            std::vector<std::string> expected = {names[3], names[0], names[3], names[4], names[0]};
+            BOOST_CHECK(get_account_names(request) == expected);
+
+            BOOST_CHECK(get_account_names({}).empty());
+            BOOST_CHECK(get_account_names({"nobody"}).empty());
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(witness_votes_follow_votes_and_proxies) {
+        try {
+            ACTORS((alice)(bob)(sam)(dave))
+            generate_block();
+            witness_create("sam", sam_private_key, "foo.bar", sam_private_key.get_public_key(), 1000);
+            witness_create("dave", dave_private_key, "foo.bar", dave_private_key.get_public_key(), 1000);
+            generate_block();
+
+            BOOST_CHECK(cached_witness_votes("alice").empty());
+
+            // the witnesses are kept sorted by name, not in the order of votes
+            witness_vote("alice", alice_private_key, "sam", true);
+            witness_vote("alice", alice_private_key, "dave", true);
+            generate_block();
+            BOOST_CHECK(cached_witness_votes("alice") == std::vector<std::string>({"dave", "sam"}));
+
+            witness_vote("alice", alice_private_key, "sam", false);
+            generate_block();
+            BOOST_CHECK(cached_witness_votes("alice") == std::vector<std::string>({"dave"}));
+
+            // a proxy clears the votes of the account, so its entry is removed
+            witness_vote("bob", bob_private_key, "sam", true);
+            generate_block();
+            BOOST_CHECK(cached_witness_votes("bob") == std::vector<std::string>({"sam"}));
+            proxy("bob", "alice");
+            generate_block();
+            BOOST_CHECK(cached_witness_votes("bob").empty());
+            BOOST_CHECK(db->find<account_witness_votes_object, by_account>("bob") == nullptr);
+            BOOST_CHECK(cached_witness_votes("alice") == std::vector<std::string>({"dave"}));
+
+            // votes are accepted again once the proxy is removed
+            proxy("bob", "");
+            witness_vote("bob", bob_private_key, "dave", true);
+            generate_block();
+            BOOST_CHECK(cached_witness_votes("bob") == std::vector<std::string>({"dave"}));
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(witness_votes_of_declining_account) {
+        try {
+            ACTORS((alice)(sam))
+            generate_block();
+            witness_create("sam", sam_private_key, "foo.bar", sam_private_key.get_public_key(), 1000);
+            witness_vote("alice", alice_private_key, "sam", true);
+            generate_block();
+            BOOST_CHECK(cached_witness_votes("alice") == std::vector<std::string>({"sam"}));
+
+            decline_voting_rights_operation op;
+            op.account = "alice";
+            push_operation(op, alice_private_key);
+            generate_block();
+
+            // the account keeps its votes until the decline becomes effective
+            const auto &alice = db->get_account("alice");
+            generate_blocks(db->head_block_time() + STEEMIT_OWNER_AUTH_RECOVERY_PERIOD - fc::seconds(STEEMIT_BLOCK_INTERVAL), true);
+            BOOST_REQUIRE(alice.can_vote);
+            BOOST_CHECK(cached_witness_votes("alice") == std::vector<std::string>({"sam"}));
+
+            // votes are removed by the chain without an operation of the account
+            generate_blocks(2);
+            BOOST_REQUIRE(!alice.can_vote);
+            BOOST_CHECK(cached_witness_votes("alice").empty());
+            BOOST_CHECK(db->find<account_witness_votes_object, by_account>("alice") == nullptr);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(witness_votes_rebuild_equals_incremental) {
+        try {
+            ACTORS((alice)(bob)(carol)(sam)(dave))
+            generate_block();
+            witness_create("sam", sam_private_key, "foo.bar", sam_private_key.get_public_key(), 1000);
+            witness_create("dave", dave_private_key, "foo.bar", dave_private_key.get_public_key(), 1000);
+            witness_vote("alice", alice_private_key, "sam", true);
+            witness_vote("alice", alice_private_key, "dave", true);
+            witness_vote("bob", bob_private_key, "dave", true);
+            witness_vote("carol", carol_private_key, "sam", true);
+            generate_block();
+            proxy("carol", "alice");
+            generate_block();
+
+            auto incremental = cached_witness_votes();
+            BOOST_REQUIRE_EQUAL(incremental.size(), 2);
+
+            // as if the plugin was disabled while votes changed: a missing, a stale and a needless entry
+            const auto &cache_idx = db->get_index<account_witness_votes_index>().indices().get<by_account>();
+            db->remove(*cache_idx.find("alice"));
+            db->modify(*cache_idx.find("bob"), [&](account_witness_votes_object &o) {
+                o.witnesses.clear();
+                o.witnesses.push_back("sam");
+            });
+            db->create<account_witness_votes_object>([&](account_witness_votes_object &o) {
+                o.account = "carol";
+                o.witnesses.push_back("sam");
+            });
+            BOOST_REQUIRE(cached_witness_votes() != incremental);
+
+            // the startup of the plugin rebuilds the cache from the votes
+            api_plugin->plugin_startup();
+            BOOST_CHECK(cached_witness_votes() == incremental);
+
+            // and a rebuild of a valid cache changes nothing
+            api_plugin->plugin_startup();
+            BOOST_CHECK(cached_witness_votes() == incremental);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(database_api_plugin_threads, get_accounts_threads_fixture)
+
+    BOOST_AUTO_TEST_CASE(get_accounts_on_worker_threads) {
+        try {
+            // enough accounts for all four threads
+            auto names = create_accounts(100);
+
+            std::vector<std::string> request;
+            std::vector<std::string> expected;
+            for (uint32_t i = 0; i < 3 * names.size(); ++i) {
+                const auto &name = names[(i * 7) % names.size()];
+                request.push_back(name);
+                expected.push_back(name);
+                if (i % 10 == 0) {
+                    request.push_back("nobody");
+                }
+            }
+            BOOST_CHECK(get_account_names(request) == expected);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
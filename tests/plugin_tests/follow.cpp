@@ -0,0 +1,112 @@
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/follow/plugin.hpp>
+#include <golos/plugins/follow/follow_operations.hpp>
+
+#include <fc/io/json.hpp>
+
+#include "database_fixture.hpp"
+
+using namespace golos::chain;
+using namespace golos::protocol;
+using namespace golos::plugins::follow;
+
+struct computed_feed_fixture : public database_fixture {
+    golos::plugins::follow::plugin *follow_plugin = nullptr;
+
+    computed_feed_fixture() {
+        initialize();
+
+        follow_plugin = initialize_plugin<golos::plugins::follow::plugin>({"--follow-store-feeds=false"});
+
+        open_database();
+        startup();
+        follow_plugin->plugin_startup();
+    }
+
+    void push_follow_operation(const std::string &account, const fc::ecc::private_key &key, const follow_plugin_operation &op) {
+        custom_json_operation cop;
+        cop.id = "follow";
+        cop.required_posting_auths.insert(account);
+        cop.json = fc::json::to_string(op);
+        push_operation(cop, key);
+    }
+
+    void post(const std::string &author, const fc::ecc::private_key &key) {
+        comment_operation op;
+        op.author = author;
+        op.permlink = "post";
+        op.parent_author = STEEMIT_ROOT_POST_PARENT;
+        op.parent_permlink = "test";
+        op.title = "title";
+        op.body = "body";
+        push_operation(op, key);
+    }
+
+    // pages through the feed as a client does
+    std::vector<feed_entry> get_feed_entries(const std::string &account, uint32_t limit) {
+        std::vector<feed_entry> result;
+        uint32_t start_entry_id = 0;
+        while (true) {
+            golos::plugins::json_rpc::msg_pack msg;
+            msg.args = std::vector<fc::variant>({fc::variant(account), fc::variant(start_entry_id), fc::variant(limit)});
+            auto page = follow_plugin->get_feed_entries(msg);
+            result.insert(result.end(), page.begin(), page.end());
+            if (page.size() < limit) {
+                return result;
+            }
+            start_entry_id = page.back().entry_id - 1;
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(computed_feed_test, computed_feed_fixture)
+
+    BOOST_AUTO_TEST_CASE(page_through_reblogs_and_same_second_entries) {
+        ACTORS((alice)(bob)(carol)(dave)(sam))
+        generate_block();
+
+        for (const auto &following: {"alice", "bob", "carol", "dave"}) {
+            follow_operation op;
+            op.follower = "sam";
+            op.following = following;
+            op.what = {"blog"};
+            push_follow_operation("sam", sam_private_key, op);
+        }
+        generate_block();
+
+        // posts of the same block have the same time
+        post("alice", alice_private_key);
+        post("bob", bob_private_key);
+        post("carol", carol_private_key);
+        generate_block();
+
+        // the reblog gets into the feed after the post of the same second
+        post("dave", dave_private_key);
+        reblog_operation reblog;
+        reblog.account = "dave";
+        reblog.author = "alice";
+        reblog.permlink = "post";
+        push_follow_operation("dave", dave_private_key, reblog);
+        generate_block();
+
+        for (uint32_t limit: {1u, 2u, 3u, 10u}) {
+            BOOST_TEST_MESSAGE("--- limit " << limit);
+            auto feed = get_feed_entries("sam", limit);
+            BOOST_REQUIRE_EQUAL(feed.size(), 4);
+            BOOST_CHECK_EQUAL(feed[0].author, "alice");
+            BOOST_CHECK(feed[0].reblog_by == std::vector<std::string>({"dave"}));
+            BOOST_CHECK_EQUAL(feed[1].author, "dave");
+            BOOST_CHECK_EQUAL(feed[2].author, "carol");
+            BOOST_CHECK_EQUAL(feed[3].author, "bob");
+            for (std::size_t i = 1; i < feed.size(); ++i) {
+                BOOST_CHECK_LT(feed[i].entry_id, feed[i - 1].entry_id);
+            }
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -0,0 +1,186 @@
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/search/inverted_index.hpp>
+
+#include <fc/filesystem.hpp>
+
+using namespace golos::plugins::search;
+
+BOOST_AUTO_TEST_SUITE(search_index)
+
+    BOOST_AUTO_TEST_CASE(tokenize_text) {
+        auto terms = tokenize("Hello, WORLD! a 42 <b>Голос</b> Привет-мир");
+
+        std::vector<std::string> expected = {"hello", "world", "42", "голос", "привет", "мир"};
+        BOOST_CHECK(terms == expected);
+    }
+
+    BOOST_AUTO_TEST_CASE(rank_update_remove) {
+        inverted_index index;
+        index.update("alice", "post", "en", "Golos blockchain", "a blog about the blockchain");
+        index.update("bob", "post", "ru", "Cats", "a story about cats and the blockchain");
+        index.update("sam", "post", "en", "Dogs", "nothing to see here");
+
+        auto hits = index.search("blockchain", 10, {});
+        BOOST_REQUIRE_EQUAL(hits.size(), 2);
+        BOOST_CHECK_EQUAL(index.get_document(hits[0].id).author, "alice");
+        BOOST_CHECK_EQUAL(index.get_document(hits[1].id).author, "bob");
+
+        hits = index.search("blockchain", 10, [](const search_document &doc) {
+            return doc.language == "ru";
+        });
+        BOOST_REQUIRE_EQUAL(hits.size(), 1);
+        BOOST_CHECK_EQUAL(index.get_document(hits[0].id).author, "bob");
+
+        index.update("alice", "post", "en", "Edited", "no more chains");
+        hits = index.search("blockchain", 10, {});
+        BOOST_REQUIRE_EQUAL(hits.size(), 1);
+        BOOST_CHECK_EQUAL(index.get_document(hits[0].id).author, "bob");
+
+        index.remove("bob", "post");
+        BOOST_CHECK(index.search("blockchain", 10, {}).empty());
+        BOOST_CHECK_EQUAL(index.size(), 2);
+    }
+
+    BOOST_AUTO_TEST_CASE(save_load) {
+        auto file = fc::temp_directory_path() / "search-index-test.bin";
+
+        inverted_index index;
+        index.update("alice", "post", "en", "Golos", "blockchain");
+        index.save(file, 42);
+
+        inverted_index loaded;
+        BOOST_CHECK_EQUAL(loaded.load(file), 42);
+        BOOST_CHECK_EQUAL(loaded.size(), 1);
+
+        auto hits = loaded.search("golos", 10, {});
+        BOOST_REQUIRE_EQUAL(hits.size(), 1);
+        BOOST_CHECK_EQUAL(loaded.get_document(hits[0].id).permlink, "post");
+
+        fc::remove_all(file);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <golos/plugins/search/plugin.hpp>
+
+#include "database_fixture.hpp"
+
+#include <algorithm>
+
+using namespace golos::chain;
+using namespace golos::protocol;
+
+struct search_plugin_fixture : public database_fixture {
+    golos::plugins::search::plugin *search_plugin = nullptr;
+    fc::path index_file = fc::temp_directory_path() / "search-plugin-test.bin";
+
+    search_plugin_fixture() {
+        initialize();
+
+        fc::remove_all(index_file);
+        search_plugin = initialize_plugin<golos::plugins::search::plugin>({"--search-index-file=" + index_file.string()});
+
+        open_database();
+        startup();
+        search_plugin->plugin_startup();
+    }
+
+    ~search_plugin_fixture() {
+        fc::remove_all(index_file);
+    }
+
+    std::vector<std::string> search(const std::string &query) {
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(query)});
+        std::vector<std::string> result;
+        for (const auto &hit: search_plugin->search_content(msg)) {
+            result.push_back(hit.author + "/" + hit.permlink);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    void post(const std::string &author, const fc::ecc::private_key &key, const std::string &title) {
+        comment_operation op;
+        op.author = author;
+        op.permlink = "post";
+        op.parent_author = STEEMIT_ROOT_POST_PARENT;
+        op.parent_permlink = "test";
+        op.title = title;
+        op.body = "a post about " + title;
+        push_operation(op, key);
+    }
+
+    void delete_post(const std::string &author, const fc::ecc::private_key &key, uint32_t expiration) {
+        delete_comment_operation op;
+        op.author = author;
+        op.permlink = "post";
+        push_operation(op, key, expiration);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(search_plugin, search_plugin_fixture)
+
+    BOOST_AUTO_TEST_CASE(index_applied_operations) {
+        ACTORS((alice)(bob))
+        generate_block();
+
+        post("alice", alice_private_key, "Golos blockchain");
+        post("bob", bob_private_key, "Golos cats");
+        BOOST_CHECK(search("golos").empty());
+
+        generate_block();
+        BOOST_CHECK(search("golos") == std::vector<std::string>({"alice/post", "bob/post"}));
+        BOOST_CHECK(search("cats") == std::vector<std::string>({"bob/post"}));
+
+        comment_operation edit;
+        edit.author = "bob";
+        edit.permlink = "post";
+        edit.parent_author = STEEMIT_ROOT_POST_PARENT;
+        edit.parent_permlink = "test";
+        edit.title = "Golos dogs";
+        edit.body = "no more cats";
+        push_operation(edit, bob_private_key);
+        generate_block();
+        BOOST_CHECK(search("cats").empty());
+        BOOST_CHECK(search("dogs") == std::vector<std::string>({"bob/post"}));
+
+        delete_post("alice", alice_private_key, STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+        generate_block();
+        BOOST_CHECK(search("golos") == std::vector<std::string>({"bob/post"}));
+    }
+
+    BOOST_AUTO_TEST_CASE(delete_in_popped_block) {
+        ACTORS((bob))
+        generate_block();
+
+        post("bob", bob_private_key, "Golos cats");
+        generate_block();
+        BOOST_CHECK(search("cats") == std::vector<std::string>({"bob/post"}));
+
+        // the transaction expires before it could be applied again after the pop
+        delete_post("bob", bob_private_key, STEEMIT_BLOCK_INTERVAL);
+        generate_block();
+        auto deleted_in_block = db->head_block_num();
+        BOOST_CHECK(search("cats").empty());
+
+        db->pop_block();
+        BOOST_CHECK(search("cats") == std::vector<std::string>({"bob/post"}));
+
+        generate_block(0, init_account_priv_key, 1);
+        for (uint32_t i = 0; i < 100 && db->last_non_undoable_block_num() < deleted_in_block; ++i) {
+            generate_block();
+        }
+        BOOST_REQUIRE_GE(db->last_non_undoable_block_num(), deleted_in_block);
+        BOOST_REQUIRE(db->find_comment("bob", "post") != nullptr);
+
+        // the removal of the popped block isn't applied when the block number becomes irreversible
+        BOOST_CHECK(search("cats") == std::vector<std::string>({"bob/post"}));
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
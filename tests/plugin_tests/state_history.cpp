@@ -0,0 +1,367 @@
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/state_history/state_journal.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <limits>
+#include <string>
+
+using namespace golos::plugins::state_history;
+
+BOOST_AUTO_TEST_SUITE(state_history_journal)
+
+    BOOST_AUTO_TEST_CASE(append_find_truncate) {
+        auto dir = fc::temp_directory_path() / "state-history-test";
+        fc::remove_all(dir);
+
+        auto data_of = [](const std::string &s) {
+            return std::vector<char>(s.begin(), s.end());
+        };
+
+        std::vector<char> data;
+        {
+            state_journal journal;
+            journal.open(dir);
+            journal.append(1, 10, data_of("a10"));
+            journal.append(2, 10, data_of("b10"));
+            // the same state isn't recorded again
+            journal.append(1, 20, data_of("a10"));
+            journal.append(1, 30, data_of("a30"));
+
+            BOOST_CHECK_EQUAL(journal.find(1, 9, data), 0);
+            BOOST_CHECK_EQUAL(journal.find(1, 25, data), 10);
+            BOOST_CHECK_EQUAL(std::string(data.begin(), data.end()), "a10");
+            journal.commit(30);
+
+            // not committed, so it is dropped on open
+            journal.append(2, 40, data_of("b40"));
+            BOOST_CHECK_EQUAL(journal.find(2, 40, data), 40);
+        }
+
+        state_journal journal;
+        journal.open(dir);
+        BOOST_CHECK_EQUAL(journal.head_block(), 30);
+        BOOST_CHECK_EQUAL(journal.size(), 2);
+
+        BOOST_CHECK_EQUAL(journal.find(1, 30, data), 30);
+        BOOST_CHECK_EQUAL(std::string(data.begin(), data.end()), "a30");
+        BOOST_CHECK_EQUAL(journal.find(2, 100, data), 10);
+        BOOST_CHECK_EQUAL(std::string(data.begin(), data.end()), "b10");
+        BOOST_CHECK_EQUAL(journal.find(3, 100, data), 0);
+
+        // the last state is known after reopening
+        journal.append(1, 50, data_of("a30"));
+        BOOST_CHECK_EQUAL(journal.find(1, 50, data), 30);
+
+        journal.wipe();
+        BOOST_CHECK_EQUAL(journal.head_block(), 0);
+        BOOST_CHECK_EQUAL(journal.size(), 0);
+
+        journal.close();
+        fc::remove_all(dir);
+    }
+
+    BOOST_AUTO_TEST_CASE(long_chains_and_many_objects) {
+        auto dir = fc::temp_directory_path() / "state-history-chains-test";
+        fc::remove_all(dir);
+
+        auto data_of = [](uint64_t key, uint32_t block) {
+            auto s = std::to_string(key) + "@" + std::to_string(block);
+            return std::vector<char>(s.begin(), s.end());
+        };
+        // key 1 changes in every third block, other keys once
+        const uint32_t blocks = 3000;
+        const uint64_t objects = 100000;
+        auto check = [&](state_journal &journal) {
+            std::vector<char> data;
+            for (uint32_t block = 1; block <= blocks; block += 7) {
+                uint32_t expected = block / 3 * 3;
+                BOOST_REQUIRE_EQUAL(journal.find(1, block, data), expected);
+                if (expected != 0) {
+                    BOOST_REQUIRE(data == data_of(1, expected));
+                }
+            }
+            for (uint64_t key = 2; key < objects; key += 997) {
+                BOOST_REQUIRE_EQUAL(journal.find(key, blocks + 1, data), blocks + 1);
+                BOOST_REQUIRE(data == data_of(key, blocks + 1));
+                BOOST_REQUIRE_EQUAL(journal.find(key, blocks, data), 0);
+            }
+        };
+
+        {
+            state_journal journal;
+            journal.open(dir);
+            for (uint32_t block = 3; block <= blocks; block += 3) {
+                journal.append(1, block, data_of(1, block));
+                if (block % 300 == 0) {
+                    journal.commit(block);
+                }
+            }
+            // more objects than the initial capacity of the table of heads
+            for (uint64_t key = 2; key < objects; ++key) {
+                journal.append(key, blocks + 1, data_of(key, blocks + 1));
+            }
+            journal.commit(blocks + 1);
+            BOOST_CHECK_EQUAL(journal.size(), objects - 1);
+        }
+
+        {
+            state_journal journal;
+            journal.open(dir);
+            BOOST_CHECK_EQUAL(journal.size(), objects - 1);
+            check(journal);
+        }
+
+        // the table of heads is rebuilt from index.log
+        fc::remove_all(dir / "heads.idx");
+        state_journal journal;
+        journal.open(dir);
+        BOOST_CHECK_EQUAL(journal.size(), objects - 1);
+        check(journal);
+
+        journal.close();
+        fc::remove_all(dir);
+    }
+
+    BOOST_AUTO_TEST_CASE(lost_blocks_are_saved_on_commit) {
+        auto dir = fc::temp_directory_path() / "state-history-lost-test";
+        fc::remove_all(dir);
+        {
+            state_journal journal;
+            journal.open(dir);
+            journal.add_lost_blocks({10, std::numeric_limits<uint32_t>::max()});
+            journal.commit(9);
+            // the same first block replaces the open range
+            journal.add_lost_blocks({10, 20});
+            journal.add_lost_blocks({30, 40});
+        }
+        {
+            state_journal journal;
+            journal.open(dir);
+            BOOST_REQUIRE_EQUAL(journal.lost_blocks().size(), 1);
+            BOOST_CHECK_EQUAL(journal.lost_blocks()[0].last, std::numeric_limits<uint32_t>::max());
+            journal.add_lost_blocks({10, 20});
+            journal.add_lost_blocks({30, 40});
+            journal.commit(50);
+        }
+        state_journal journal;
+        journal.open(dir);
+        BOOST_REQUIRE_EQUAL(journal.lost_blocks().size(), 2);
+        BOOST_CHECK_EQUAL(journal.lost_blocks()[0].first, 10);
+        BOOST_CHECK_EQUAL(journal.lost_blocks()[0].last, 20);
+        BOOST_CHECK_EQUAL(journal.lost_blocks()[1].first, 30);
+        BOOST_CHECK_EQUAL(journal.lost_blocks()[1].last, 40);
+
+        journal.close();
+        fc::remove_all(dir);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <golos/plugins/state_history/plugin.hpp>
+
+#include "database_fixture.hpp"
+
+using namespace golos::chain;
+using namespace golos::protocol;
+
+struct state_history_fixture : public database_fixture {
+    golos::plugins::state_history::plugin *history_plugin = nullptr;
+    fc::path journal_dir = fc::temp_directory_path() / "state-history-plugin-test";
+
+    // the plugin is started before the chain, otherwise the blocks before its start are lost as on a restart
+    state_history_fixture(bool start_before_chain = true) {
+        initialize();
+
+        fc::remove_all(journal_dir);
+        history_plugin = initialize_plugin<golos::plugins::state_history::plugin>({
+            "--state-history-dir=" + journal_dir.string(),
+            "--state-history-snapshot-interval=10",
+            "--state-history-snapshot-accounts-per-block=2"
+        });
+
+        open_database();
+        if (start_before_chain) {
+            history_plugin->plugin_startup();
+        }
+        startup();
+    }
+
+    ~state_history_fixture() {
+        history_plugin->plugin_shutdown();
+        fc::remove_all(journal_dir);
+    }
+
+    fc::optional<historical_account_state> account_at(const std::string &name, uint32_t block) {
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(std::vector<std::string>({name})), fc::variant(block)});
+        return history_plugin->get_accounts_at_block(msg).at(0);
+    }
+
+    fc::optional<historical_comment_state> content_at(const std::string &author, const std::string &permlink, uint32_t block) {
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(author), fc::variant(permlink), fc::variant(block)});
+        return history_plugin->get_content_at_block(msg);
+    }
+};
+
+struct state_history_restart_fixture : public state_history_fixture {
+    state_history_restart_fixture() : state_history_fixture(false) {
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(state_history_plugin, state_history_fixture)
+
+    BOOST_AUTO_TEST_CASE(balance_change_and_popped_block) {
+        try {
+            ACTORS((alice)(bob))
+            fund("alice", 10000);
+            generate_block();
+            auto before = db->head_block_num();
+            auto bob_before = account_at("bob", before);
+            BOOST_REQUIRE(bob_before);
+
+            transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = ASSET("1.000 GOLOS");
+            // the transaction expires before it could be applied again after the pop
+            push_operation(op, alice_private_key, STEEMIT_BLOCK_INTERVAL);
+            generate_block();
+            auto changed_in = db->head_block_num();
+
+            auto bob_after = account_at("bob", changed_in);
+            BOOST_REQUIRE(bob_after);
+            BOOST_CHECK_EQUAL(bob_after->block, changed_in);
+            BOOST_CHECK(bob_after->state.balance == bob_before->state.balance + ASSET("1.000 GOLOS"));
+            BOOST_CHECK(account_at("bob", changed_in - 1)->state.balance == bob_before->state.balance);
+
+            db->pop_block();
+            generate_block(0, init_account_priv_key, 1);
+            BOOST_REQUIRE_EQUAL(db->head_block_num(), changed_in);
+
+            // states recorded by the popped block are dropped
+            auto bob_forked = account_at("bob", changed_in);
+            BOOST_REQUIRE(bob_forked);
+            BOOST_CHECK(bob_forked->state.balance == bob_before->state.balance);
+            BOOST_CHECK_LT(bob_forked->block, changed_in);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(snapshot_records_changes_without_operations) {
+        try {
+            ACTORS((alice))
+            generate_block();
+            auto before = db->head_block_num();
+            auto alice_before = account_at("alice", before);
+            BOOST_REQUIRE(alice_before);
+
+            // a debug update changes the balance without an operation
+            fund("alice", ASSET("5.000 GOLOS"));
+            auto expected = alice_before->state.balance + ASSET("5.000 GOLOS");
+
+            fc::optional<historical_account_state> alice_after;
+            for (uint32_t i = 0; i < 100; ++i) {
+                generate_block();
+                alice_after = account_at("alice", db->head_block_num());
+                if (alice_after && alice_after->state.balance == expected) {
+                    break;
+                }
+            }
+            BOOST_REQUIRE(alice_after);
+            BOOST_CHECK(alice_after->state.balance == expected);
+            BOOST_CHECK_GT(alice_after->block, before);
+            BOOST_CHECK(account_at("alice", before)->state.balance == alice_before->state.balance);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(history_of_deleted_comment) {
+        try {
+            ACTORS((bob))
+            generate_block();
+
+            comment_operation post;
+            post.author = "bob";
+            post.permlink = "post";
+            post.parent_author = STEEMIT_ROOT_POST_PARENT;
+            post.parent_permlink = "test";
+            post.title = "title";
+            post.body = "body";
+            push_operation(post, bob_private_key);
+            generate_block();
+            auto posted_in = db->head_block_num();
+
+            delete_comment_operation del;
+            del.author = "bob";
+            del.permlink = "post";
+            push_operation(del, bob_private_key);
+            generate_block();
+            auto deleted_in = db->head_block_num();
+            BOOST_REQUIRE(db->find_comment("bob", "post") == nullptr);
+
+            auto posted = content_at("bob", "post", posted_in);
+            BOOST_REQUIRE(posted);
+            BOOST_CHECK_EQUAL(posted->block, posted_in);
+            BOOST_CHECK_EQUAL(posted->state.permlink, "post");
+            BOOST_CHECK(!content_at("bob", "post", deleted_in));
+            BOOST_CHECK(!content_at("bob", "other", deleted_in));
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(state_history_plugin_restart, state_history_restart_fixture)
+
+    BOOST_AUTO_TEST_CASE(lost_blocks_are_refused) {
+        try {
+            ACTORS((alice)(bob))
+            generate_block();
+
+            comment_operation post;
+            post.author = "bob";
+            post.permlink = "post";
+            post.parent_author = STEEMIT_ROOT_POST_PARENT;
+            post.parent_permlink = "test";
+            post.title = "title";
+            post.body = "body";
+            push_operation(post, bob_private_key);
+            generate_block();
+            auto lost_head = db->head_block_num();
+
+            // as after a restart, the journal is behind the chain
+            history_plugin->plugin_startup();
+            BOOST_CHECK_THROW(account_at("alice", lost_head), fc::exception);
+
+            // until the snapshot after the restart is finished and journaled, new blocks are refused too
+            generate_block();
+            BOOST_CHECK_THROW(account_at("alice", db->head_block_num()), fc::exception);
+
+            uint32_t recorded_since = 0;
+            for (uint32_t i = 0; i < 200 && recorded_since == 0; ++i) {
+                generate_block();
+                try {
+                    account_at("alice", db->head_block_num());
+                    recorded_since = db->head_block_num();
+                } catch (const fc::exception &) {
+                }
+            }
+            BOOST_REQUIRE_GT(recorded_since, lost_head);
+
+            BOOST_CHECK_THROW(account_at("alice", lost_head), fc::exception);
+            BOOST_CHECK_THROW(content_at("bob", "post", lost_head), fc::exception);
+            BOOST_CHECK(account_at("alice", recorded_since));
+            BOOST_CHECK(account_at("bob", recorded_since));
+            BOOST_CHECK(content_at("bob", "post", recorded_since));
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
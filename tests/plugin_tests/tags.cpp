@@ -0,0 +1,263 @@
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/social_network/social_network.hpp>
+#include <golos/plugins/social_network/tag/tags_object.hpp>
+#include <golos/plugins/social_network/api_object/discussion_query.hpp>
+
+#include "database_fixture.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace golos::chain;
+using namespace golos::protocol;
+using namespace golos::plugins::social_network;
+
+struct tags_fixture : public database_fixture {
+    social_network_t *social_plugin = nullptr;
+
+    tags_fixture(const std::vector<std::string> &args = std::vector<std::string>()) {
+        initialize();
+
+        social_plugin = initialize_plugin<social_network_t>(args);
+
+        open_database();
+        startup();
+        social_plugin->plugin_startup();
+    }
+
+    void post(const std::string &author, const fc::ecc::private_key &key) {
+        comment_operation op;
+        op.author = author;
+        op.permlink = "post";
+        op.parent_author = STEEMIT_ROOT_POST_PARENT;
+        op.parent_permlink = "test";
+        op.title = "title";
+        op.body = "body";
+        push_operation(op, key);
+    }
+
+    void vote(const std::string &voter, const fc::ecc::private_key &key, const std::string &author, int16_t weight) {
+        vote_operation op;
+        op.voter = voter;
+        op.author = author;
+        op.permlink = "post";
+        op.weight = weight;
+        push_operation(op, key);
+    }
+
+    // authors of the top level posts of the "test" tag in the order of the index
+    template<typename Order>
+    std::vector<std::string> posts_by() const {
+        std::vector<std::string> result;
+        const auto &idx = db->get_index<tags::tag_sort_index>().indices().get<Order>();
+        for (auto itr = idx.lower_bound(boost::make_tuple(std::string("test"), comment_object::id_type()));
+             itr != idx.end() && itr->name == std::string("test") && itr->parent == comment_object::id_type(); ++itr) {
+            result.push_back(std::string(db->get(itr->comment).author));
+        }
+        return result;
+    }
+
+    // the same order by the score formula: sign * log10(net_rshares / S) + created / T
+    template<int64_t S, int32_t T>
+    std::vector<std::string> posts_by_score(std::vector<std::string> authors) const {
+        auto score = [&](const std::string &author) {
+            const auto &c = db->get_comment(author, std::string("post"));
+            auto mod_score = c.net_rshares.value / S;
+            double order = std::log10(std::max<int64_t>(std::abs(mod_score), 1));
+            int sign = mod_score > 0 ? 1 : mod_score < 0 ? -1 : 0;
+            return sign * order + double(c.created.sec_since_epoch()) / double(T);
+        };
+        std::stable_sort(authors.begin(), authors.end(), [&](const std::string &a, const std::string &b) {
+            return score(a) > score(b);
+        });
+        return authors;
+    }
+
+    std::vector<discussion> get_discussions(const std::string &method, const std::string &tag) {
+        discussion_query query;
+        query.limit = 10;
+        query.select_tags.insert(tag);
+        golos::plugins::json_rpc::msg_pack msg;
+        msg.args = std::vector<fc::variant>({fc::variant(query)});
+        if (method == "trending") {
+            return social_plugin->get_discussions_by_trending(msg);
+        } else if (method == "created") {
+            return social_plugin->get_discussions_by_created(msg);
+        } else if (method == "active") {
+            return social_plugin->get_discussions_by_active(msg);
+        }
+        return social_plugin->get_discussions_by_votes(msg);
+    }
+};
+
+struct trending_only_fixture : public tags_fixture {
+    trending_only_fixture() : tags_fixture({"--tags-discussions-api=created,trending"}) {
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(tags_plugin, tags_fixture)
+
+    BOOST_AUTO_TEST_CASE(score_order_follows_votes_and_age) {
+        try {
+            ACTORS((alice)(bob)(carol)(dave)(eve))
+            vest("dave", ASSET("1000.000 GOLOS"));
+            vest("eve", ASSET("1000.000 GOLOS"));
+            generate_block();
+
+            post("alice", alice_private_key);
+            generate_block();
+            post("bob", bob_private_key);
+            generate_block();
+            post("carol", carol_private_key);
+            generate_block();
+
+            // without votes the newer post goes first
+            std::vector<std::string> by_age = {"carol", "bob", "alice"};
+            BOOST_CHECK(posts_by<tags::by_parent_trending>() == by_age);
+            BOOST_CHECK(posts_by<tags::by_parent_hot>() == by_age);
+
+            vote("dave", dave_private_key, "alice", STEEMIT_100_PERCENT);
+            vote("eve", eve_private_key, "bob", -STEEMIT_100_PERCENT);
+            generate_block();
+
+            // the rshares term outweighs a few seconds of age
+            BOOST_REQUIRE_GE(db->get_comment("alice", std::string("post")).net_rshares.value, 10 * 10000000);
+            BOOST_REQUIRE_LE(db->get_comment("bob", std::string("post")).net_rshares.value, -10 * 10000000);
+
+            std::vector<std::string> by_votes = {"alice", "carol", "bob"};
+            BOOST_CHECK(posts_by<tags::by_parent_trending>() == by_votes);
+            BOOST_CHECK(posts_by<tags::by_parent_hot>() == by_votes);
+
+            BOOST_CHECK(posts_by<tags::by_parent_trending>() == posts_by_score<10000000, 480000>(by_age));
+            BOOST_CHECK(posts_by<tags::by_parent_hot>() == posts_by_score<10000000, 10000>(by_age));
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(score_of_a_post_ignores_votes_for_replies) {
+        try {
+            ACTORS((alice)(bob)(dave))
+            vest("dave", ASSET("1000.000 GOLOS"));
+            generate_block();
+
+            post("alice", alice_private_key);
+            generate_block();
+
+            comment_operation reply;
+            reply.author = "bob";
+            reply.permlink = "post";
+            reply.parent_author = "alice";
+            reply.parent_permlink = "post";
+            reply.body = "reply";
+            push_operation(reply, bob_private_key);
+            generate_block();
+
+            const auto &post_obj = db->get_comment("alice", std::string("post"));
+            const auto &idx = db->get_index<tags::tag_sort_index>().indices().get<tags::by_comment>();
+            auto score_of_post = [&]() {
+                auto itr = idx.lower_bound(post_obj.id);
+                BOOST_REQUIRE(itr != idx.end() && itr->comment == post_obj.id);
+                return std::make_pair(itr->hot, itr->trending);
+            };
+            auto before = score_of_post();
+
+            vote("dave", dave_private_key, "bob", STEEMIT_100_PERCENT);
+            generate_block();
+
+            BOOST_CHECK(score_of_post() == before);
+
+            // the reply is ranked among the replies to the post
+            const auto &reply_obj = db->get_comment("bob", std::string("post"));
+            auto itr = idx.lower_bound(reply_obj.id);
+            BOOST_REQUIRE(itr != idx.end() && itr->comment == reply_obj.id);
+            BOOST_CHECK(itr->parent == post_obj.id);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(changed_tag_indices_need_replay) {
+        try {
+            generate_block();
+
+            const auto &settings = db->get<tags::tag_settings_object>();
+            BOOST_CHECK(settings.indices.scores);
+            BOOST_CHECK(settings.indices.sorting);
+
+            // as if the node was restarted with another tags-discussions-api
+            db->modify(settings, [&](tags::tag_settings_object &o) {
+                o.indices.sorting = false;
+            });
+            BOOST_CHECK_THROW(social_plugin->plugin_startup(), fc::exception);
+
+            db->modify(settings, [&](tags::tag_settings_object &o) {
+                o.indices.sorting = true;
+            });
+            social_plugin->plugin_startup();
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(tags_plugin_trending_only, trending_only_fixture)
+
+    BOOST_AUTO_TEST_CASE(disabled_methods_return_clear_error) {
+        try {
+            ACTORS((alice)(dave))
+            vest("dave", ASSET("1000.000 GOLOS"));
+            generate_block();
+
+            post("alice", alice_private_key);
+            vote("dave", dave_private_key, "alice", STEEMIT_100_PERCENT);
+            generate_block();
+
+            BOOST_CHECK_EQUAL(get_discussions("created", "test").size(), 1);
+            BOOST_CHECK_EQUAL(get_discussions("trending", "test").size(), 1);
+
+            for (const std::string method: {"active", "votes"}) {
+                try {
+                    get_discussions(method, "test");
+                    BOOST_ERROR("get_discussions_by_" + method + " should be disabled");
+                } catch (const fc::exception &e) {
+                    auto message = e.to_detail_string();
+                    BOOST_CHECK(message.find("get_discussions_by_" + method + " is disabled on this node") != std::string::npos);
+                    BOOST_CHECK(message.find("tags-discussions-api") != std::string::npos);
+                }
+            }
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(keys_of_disabled_methods_stay_zero) {
+        try {
+            ACTORS((alice)(dave))
+            vest("dave", ASSET("1000.000 GOLOS"));
+            generate_block();
+
+            post("alice", alice_private_key);
+            vote("dave", dave_private_key, "alice", STEEMIT_100_PERCENT);
+            generate_block();
+
+            const auto &post_obj = db->get_comment("alice", std::string("post"));
+            const auto &idx = db->get_index<tags::tag_sort_index>().indices().get<tags::by_comment>();
+            auto itr = idx.lower_bound(post_obj.id);
+            BOOST_REQUIRE(itr != idx.end() && itr->comment == post_obj.id);
+            BOOST_CHECK_GT(itr->trending, 0);
+            BOOST_CHECK_GT(itr->hot, 0);
+            BOOST_CHECK_EQUAL(itr->net_votes, 0);
+            BOOST_CHECK_EQUAL(itr->net_rshares, 0);
+            BOOST_CHECK(itr->active == fc::time_point_sec());
+
+            const auto &settings = db->get<tags::tag_settings_object>();
+            BOOST_CHECK(settings.indices.scores);
+            BOOST_CHECK(!settings.indices.sorting);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
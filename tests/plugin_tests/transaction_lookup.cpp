@@ -0,0 +1,51 @@
+#include <boost/test/unit_test.hpp>
+
+#include <golos/plugins/transaction_lookup/position_table.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/crypto/ripemd160.hpp>
+
+using namespace golos::plugins::transaction_lookup;
+
+BOOST_AUTO_TEST_SUITE(transaction_lookup_table)
+
+    BOOST_AUTO_TEST_CASE(insert_find_grow) {
+        auto file = fc::temp_directory_path() / "transaction-lookup-test.bin";
+        fc::remove_all(file);
+
+        auto id_of = [](uint32_t i) {
+            return fc::ripemd160::hash(std::to_string(i));
+        };
+
+        // enough transactions to grow the table from its initial 2^20 slots
+        const uint32_t count = 600000;
+        {
+            position_table table;
+            table.open(file);
+            for (uint32_t i = 0; i < count; ++i) {
+                table.insert(id_of(i), {i / 10 + 1, i % 10});
+            }
+            // inserting the same position again has no effect
+            table.insert(id_of(5), {1, 5});
+            BOOST_CHECK_EQUAL(table.size(), count);
+            table.commit(count / 10);
+        }
+
+        position_table table;
+        table.open(file);
+        BOOST_CHECK_EQUAL(table.head_block(), count / 10);
+        BOOST_CHECK_EQUAL(table.size(), count);
+
+        for (uint32_t i: {0u, 1u, 12345u, count - 1}) {
+            auto positions = table.find(id_of(i));
+            BOOST_REQUIRE_EQUAL(positions.size(), 1);
+            BOOST_CHECK_EQUAL(positions[0].block, i / 10 + 1);
+            BOOST_CHECK_EQUAL(positions[0].trx_in_block, i % 10);
+        }
+        BOOST_CHECK(table.find(id_of(count)).empty());
+
+        table.close();
+        fc::remove_all(file);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,6 +30,7 @@
 #include <golos/chain/database.hpp>
 #include <golos/chain/steem_objects.hpp>
 #include <golos/chain/history_object.hpp>
+#include <golos/chain/virtual_op_log.hpp>
 
 #include <golos/plugins/account_history/plugin.hpp>
 
@@ -104,6 +105,106 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         }
     }
 
+    BOOST_AUTO_TEST_CASE(import_blocks) {
+        try {
+            fc::temp_directory source_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            block_id_type last_block_id;
+            uint32_t last_block_num = 0;
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(source_dir.path(), source_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                while (db.get_dynamic_global_properties().last_irreversible_block_num < 50) {
+                    db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                }
+                // only irreversible blocks are in the block log
+                last_block_num = db.get_dynamic_global_properties().last_irreversible_block_num;
+                last_block_id = db.get_block_id_for_num(last_block_num);
+                db.close();
+            }
+
+            database db;
+            db._log_hardforks = false;
+            db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+            BOOST_CHECK_EQUAL(db.import_blocks(source_dir.path() / "block_log"), last_block_num);
+            BOOST_CHECK_EQUAL(db.head_block_num(), last_block_num);
+            BOOST_CHECK(db.head_block_id() == last_block_id);
+            BOOST_CHECK(db.fetch_block_by_number(last_block_num).valid());
+
+            // nothing new in the file
+            BOOST_CHECK_EQUAL(db.import_blocks(source_dir.path() / "block_log"), 0);
+
+            // the chain continues after the imported blocks
+            auto b = db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+            BOOST_CHECK_EQUAL(b.block_num(), last_block_num + 1);
+            BOOST_CHECK(db.head_block_id() == b.id());
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(import_blocks_with_bad_block) {
+        try {
+            fc::temp_directory source_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory bad_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            const uint32_t bad_block_num = 10;
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(source_dir.path(), source_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                while (db.get_dynamic_global_properties().last_irreversible_block_num < bad_block_num + 5) {
+                    db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                }
+                db.close();
+            }
+
+            // the blocks after the bad one are never applied
+            {
+                block_log source;
+                source.open(source_dir.path() / "block_log");
+                block_log bad;
+                bad.open(bad_dir.path() / "block_log");
+                for (uint32_t num = 1; num <= bad_block_num + 5; ++num) {
+                    auto block = source.read_block_by_num(num);
+                    BOOST_REQUIRE(block.valid());
+                    if (num == bad_block_num) {
+                        block->sign(fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("bad"))));
+                    }
+                    bad.append(*block);
+                }
+                bad.flush();
+            }
+
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                BOOST_CHECK_THROW(db.import_blocks(bad_dir.path() / "block_log"), fc::exception);
+                BOOST_CHECK_EQUAL(db.head_block_num(), bad_block_num - 1);
+                db.close();
+            }
+
+            // the partially imported state isn't opened, the blocks before the bad one are replayed
+            database db;
+            db._log_hardforks = false;
+            BOOST_CHECK_THROW(
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write),
+                fc::exception);
+            db.reindex(data_dir.path(), data_dir.path(), TEST_SHARED_MEM_SIZE);
+            BOOST_CHECK_EQUAL(db.head_block_num(), bad_block_num - 1);
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(undo_block) {
         try {
             fc::temp_directory data_dir(golos::utilities::temp_directory_path());
@@ -499,6 +600,52 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         } FC_LOG_AND_RETHROW()
     }
 
+    BOOST_FIXTURE_TEST_CASE(validate_transaction_before_push, clean_database_fixture) {
+        try {
+            generate_block();
+            ACTOR(bob);
+            fund("bob", 10000);
+
+            transfer_operation t;
+            t.from = "bob";
+            t.to = STEEMIT_INIT_MINER_NAME;
+            t.amount = asset(1000, STEEM_SYMBOL);
+            trx.operations.push_back(t);
+            trx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+            trx.set_reference_block(db->head_block_id());
+
+            BOOST_TEST_MESSAGE("Signatures are checked before the transaction is pushed");
+            STEEMIT_REQUIRE_THROW(db->validate_transaction(trx, database::skip_apply_transaction), fc::exception);
+            trx.sign(bob_private_key, db->get_chain_id());
+            trx.sign(bob_private_key, db->get_chain_id());
+            STEEMIT_REQUIRE_THROW(db->validate_transaction(trx, database::skip_apply_transaction), tx_duplicate_sig);
+            trx.signatures.pop_back();
+            trx.sign(generate_private_key("bogus"), db->get_chain_id());
+            STEEMIT_REQUIRE_THROW(db->validate_transaction(trx, database::skip_apply_transaction), tx_irrelevant_sig);
+            trx.signatures.pop_back();
+
+            BOOST_TEST_MESSAGE("Operations and TaPoS are checked too");
+            auto bad_trx = trx;
+            bad_trx.ref_block_prefix ^= 1;
+            bad_trx.signatures.clear();
+            bad_trx.sign(bob_private_key, db->get_chain_id());
+            STEEMIT_REQUIRE_THROW(db->validate_transaction(bad_trx, database::skip_apply_transaction), fc::exception);
+            bad_trx = trx;
+            bad_trx.operations[0].get<transfer_operation>().amount = asset(-1, STEEM_SYMBOL);
+            bad_trx.signatures.clear();
+            bad_trx.sign(bob_private_key, db->get_chain_id());
+            STEEMIT_REQUIRE_THROW(db->validate_transaction(bad_trx, database::skip_apply_transaction), fc::exception);
+
+            BOOST_TEST_MESSAGE("The validated transaction is pushed without checking it again");
+            auto skip = db->validate_transaction(trx, database::skip_apply_transaction);
+            BOOST_CHECK(skip & database::skip_transaction_signatures);
+            BOOST_CHECK(skip & database::skip_tapos_check);
+            BOOST_CHECK(skip & database::skip_validate_operations);
+            db->push_transaction(trx, skip);
+            BOOST_CHECK(db->is_known_transaction(trx.id()));
+        } FC_LOG_AND_RETHROW()
+    }
+
     BOOST_FIXTURE_TEST_CASE(pop_block_twice, clean_database_fixture) {
         try {
             uint32_t skip_flags = (
@@ -745,5 +892,80 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_AUTO_TEST_CASE(virtual_op_log_read_write) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto file = data_dir.path() / "virtual_op_log";
+
+            auto make_block = [](uint32_t num, uint32_t ops) {
+                block_virtual_operations b;
+                b.block_num = num;
+                for (uint32_t i = 0; i < ops; ++i) {
+                    logged_virtual_operation op;
+                    op.trx_in_block = i;
+                    op.op = interest_operation("alice", asset(num * 10 + i, SBD_SYMBOL));
+                    b.operations.push_back(op);
+                }
+                return b;
+            };
+
+            {
+                virtual_op_log log;
+                log.open(file);
+                BOOST_CHECK_EQUAL(log.head_block_num(), 0);
+                BOOST_CHECK(!log.read_block_by_num(1));
+
+                log.append(make_block(1, 2));
+                log.append(make_block(2, 0));
+                log.append(make_block(3, 1));
+                BOOST_CHECK_THROW(log.append(make_block(5, 1)), fc::exception);
+                log.flush();
+                BOOST_CHECK_EQUAL(log.head_block_num(), 3);
+            }
+
+            // the index is rebuilt from the log
+            fc::remove_all(fc::path(file.generic_string() + ".index"));
+
+            virtual_op_log log;
+            log.open(file);
+            BOOST_CHECK_EQUAL(log.head_block_num(), 3);
+
+            auto b1 = log.read_block_by_num(1);
+            BOOST_REQUIRE(b1);
+            BOOST_REQUIRE_EQUAL(b1->operations.size(), 2);
+            BOOST_CHECK_EQUAL(b1->operations[1].trx_in_block, 1);
+            BOOST_CHECK(b1->operations[1].op.get<interest_operation>().interest == asset(11, SBD_SYMBOL));
+
+            auto b2 = log.read_block_by_num(2);
+            BOOST_REQUIRE(b2);
+            BOOST_CHECK(b2->operations.empty());
+
+            auto b3 = log.read_block_by_num(3);
+            BOOST_REQUIRE(b3);
+            BOOST_REQUIRE_EQUAL(b3->operations.size(), 1);
+            BOOST_CHECK(b3->operations[0].op.get<interest_operation>().interest == asset(30, SBD_SYMBOL));
+
+            BOOST_CHECK(!log.read_block_by_num(4));
+
+            log.append(make_block(4, 1));
+            BOOST_CHECK_EQUAL(log.read_block_by_num(4)->block_num, 4);
+
+            auto range = log.read_range(2, 10);
+            BOOST_REQUIRE_EQUAL(range.size(), 3);
+            BOOST_CHECK_EQUAL(range[0].block_num, 2);
+            BOOST_CHECK_EQUAL(range[2].block_num, 4);
+            BOOST_CHECK(log.read_range(5, 10).empty());
+
+            // a reader sees the blocks appended before it opened the log
+            log.flush();
+            virtual_op_log reader;
+            reader.open(file, true);
+            BOOST_CHECK_EQUAL(reader.head_block_num(), 4);
+            BOOST_CHECK_EQUAL(reader.read_range(1, 4).size(), 4);
+            BOOST_CHECK_THROW(reader.append(make_block(5, 0)), fc::exception);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
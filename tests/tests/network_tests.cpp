@@ -0,0 +1,346 @@
+#include <boost/test/unit_test.hpp>
+
+#include <golos/network/inventory_filter.hpp>
+#include <golos/network/core_messages.hpp>
+#include <golos/network/message.hpp>
+#include <golos/network/message_reader.hpp>
+#include <golos/network/stcp_socket.hpp>
+#include <golos/network/transaction_fetch_throttle.hpp>
+
+#include <fc/crypto/elliptic.hpp>
+#include <fc/crypto/ripemd160.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace golos::network;
+using golos::protocol::transfer_operation;
+
+namespace {
+
+    signed_block block_with_transactions(uint32_t count) {
+        signed_block block;
+        block.witness = "initminer";
+        block.timestamp = fc::time_point_sec(1000000);
+        for (uint32_t i = 0; i < count; ++i) {
+            transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = golos::protocol::asset(i + 1, STEEM_SYMBOL);
+            op.memo = std::to_string(i);
+
+            signed_transaction trx;
+            trx.operations.push_back(op);
+            trx.expiration = block.timestamp + 60;
+            block.transactions.push_back(trx);
+        }
+        block.transaction_merkle_root = block.calculate_merkle_root();
+        return block;
+    }
+
+    message message_of_size(uint32_t size) {
+        message m;
+        m.msg_type = trx_message_type;
+        m.size = size;
+        m.data.resize(size);
+        for (uint32_t i = 0; i < size; ++i) {
+            m.data[i] = char(i * 7 + size);
+        }
+        return m;
+    }
+
+    // messages padded to blocks as they are sent
+    void append_message(std::vector<char> &stream, const message &m) {
+        size_t begin = stream.size();
+        size_t size = sizeof(message_header) + m.size;
+        stream.resize(begin + (size + message_reader::block_size - 1) / message_reader::block_size * message_reader::block_size);
+        memcpy(&stream[begin], (const char *)&m, sizeof(message_header));
+        std::copy(m.data.begin(), m.data.end(), stream.begin() + begin + sizeof(message_header));
+    }
+
+    // a compact block passed through the wire, as a peer receives it
+    compact_block_message received_compact_block(const block_message &block, const message_hash_type &block_message_hash) {
+        return message(compact_block_message(block_message_hash, block)).as<compact_block_message>();
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(network_tests)
+
+    BOOST_AUTO_TEST_CASE(inventory_filter_rotation) {
+        const uint32_t capacity = 1000;
+        auto transaction = [](uint32_t i) {
+            return item_id(trx_message_type, fc::ripemd160::hash(std::to_string(i)));
+        };
+
+        inventory_filter filter(capacity);
+        BOOST_CHECK(!filter.contains(transaction(0)));
+
+        // insert() returns false for an item that looks already known, new items only hit false positives
+        uint32_t known_on_insert = 0;
+        for (uint32_t i = 0; i < capacity; ++i) {
+            known_on_insert += !filter.insert(transaction(i));
+        }
+        BOOST_CHECK_LT(known_on_insert, capacity / 100);
+        BOOST_CHECK(!filter.insert(transaction(0)));
+
+        // the first generation becomes the previous one, its items are still remembered
+        for (uint32_t i = capacity; i < 2 * capacity; ++i) {
+            filter.insert(transaction(i));
+        }
+        for (uint32_t i = 0; i < 2 * capacity; ++i) {
+            BOOST_CHECK(filter.contains(transaction(i)));
+        }
+
+        // the first generation is dropped, only false positives of the others are left
+        filter.insert(transaction(2 * capacity));
+        uint32_t false_positives = 0;
+        for (uint32_t i = 0; i < capacity; ++i) {
+            false_positives += filter.contains(transaction(i));
+        }
+        BOOST_CHECK_LT(false_positives, capacity / 100);
+
+        filter.clear();
+        BOOST_CHECK(!filter.contains(transaction(2 * capacity)));
+    }
+
+    BOOST_AUTO_TEST_CASE(inventory_filter_no_false_negatives) {
+        const uint32_t capacity = 100;
+        inventory_filter filter(capacity);
+
+        // an item is remembered for at least capacity insertions of other items
+        for (uint32_t i = 0; i < 20 * capacity; ++i) {
+            filter.insert(item_id(trx_message_type, fc::ripemd160::hash(std::to_string(i))));
+            for (uint32_t j = (i >= capacity ? i - capacity : 0); j <= i; ++j) {
+                BOOST_REQUIRE(filter.contains(item_id(trx_message_type, fc::ripemd160::hash(std::to_string(j)))));
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(message_reader_partial_reads) {
+        // small ones, one larger than the read buffer and then enough to wrap the buffer many times
+        std::vector<uint32_t> sizes = {0, 1, 8, 9, 100, GRAPHENE_NET_READ_BUFFER_SIZE + 1000, 5};
+        for (uint32_t i = 0; i < 1000; ++i) {
+            sizes.push_back((i * 7919) % 3000);
+        }
+        std::vector<char> stream;
+        for (auto size: sizes) {
+            append_message(stream, message_of_size(size));
+        }
+
+        // reads end anywhere, including in the middle of a block near the end of the buffer
+        const std::vector<size_t> read_sizes = {1, 3, 16, 17, 5, 4096, 31, 65535, 12, 1000};
+        size_t position = 0;
+        uint32_t reads = 0;
+        message_reader reader([&](char *buffer, size_t length) {
+            BOOST_REQUIRE_GT(length, 0u);
+            BOOST_REQUIRE_EQUAL(length % message_reader::block_size, 0u);
+            BOOST_REQUIRE_LT(position, stream.size());
+            size_t bytes_read = std::min({length, read_sizes[reads++ % read_sizes.size()], stream.size() - position});
+            memcpy(buffer, &stream[position], bytes_read);
+            position += bytes_read;
+            return bytes_read;
+        });
+
+        for (auto size: sizes) {
+            message m;
+            reader.read_message(m);
+            auto expected = message_of_size(size);
+            BOOST_REQUIRE_EQUAL(m.size, size);
+            BOOST_REQUIRE_EQUAL(m.msg_type, expected.msg_type);
+            BOOST_REQUIRE(m.data == expected.data);
+        }
+        BOOST_CHECK_EQUAL(position, stream.size());
+        // the buffer grown for the large message isn't kept
+        BOOST_CHECK_LT(reader.buffer_size(), 2 * GRAPHENE_NET_READ_BUFFER_SIZE);
+    }
+
+    BOOST_AUTO_TEST_CASE(message_reader_whole_blocks) {
+        std::vector<char> stream;
+        for (uint32_t size = 0; size < 100; ++size) {
+            append_message(stream, message_of_size(size));
+        }
+
+        // as the encrypted socket, which reads all it's asked for
+        size_t position = 0;
+        message_reader reader([&](char *buffer, size_t length) {
+            BOOST_REQUIRE_GT(length, 0u);
+            BOOST_REQUIRE_EQUAL(length % message_reader::block_size, 0u);
+            size_t bytes_read = std::min(length, stream.size() - position);
+            memcpy(buffer, &stream[position], bytes_read);
+            position += bytes_read;
+            return bytes_read;
+        });
+        for (uint32_t size = 0; size < 100; ++size) {
+            message m;
+            reader.read_message(m);
+            BOOST_REQUIRE(m.data == message_of_size(size).data);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(message_reader_too_large_message) {
+        message m;
+        m.msg_type = trx_message_type;
+        m.size = MAX_MESSAGE_SIZE + 1;
+        std::vector<char> stream(message_reader::block_size);
+        memcpy(stream.data(), (const char *)&m, sizeof(message_header));
+
+        message_reader reader([&](char *buffer, size_t length) {
+            memcpy(buffer, stream.data(), stream.size());
+            return stream.size();
+        });
+        BOOST_CHECK_THROW(reader.read_message(m), fc::exception);
+    }
+
+    BOOST_AUTO_TEST_CASE(transaction_fetch_throttle_limit) {
+        const uint32_t limit = 3;
+        transaction_fetch_throttle throttle(limit);
+        BOOST_CHECK_EQUAL(throttle.transactions_to_fetch(), limit);
+
+        for (uint32_t i = 1; i <= limit; ++i) {
+            throttle.validation_started();
+            BOOST_CHECK_EQUAL(throttle.transactions_to_fetch(), limit - i);
+        }
+
+        // transactions requested before the limit was reached still arrive
+        throttle.validation_started();
+        BOOST_CHECK_EQUAL(throttle.being_validated(), limit + 1);
+        BOOST_CHECK_EQUAL(throttle.transactions_to_fetch(), 0u);
+
+        // fetching goes on only when the count drops below the limit, and the loop is retriggered once
+        BOOST_CHECK(!throttle.validation_finished());
+        BOOST_CHECK_EQUAL(throttle.transactions_to_fetch(), 0u);
+        BOOST_CHECK(throttle.validation_finished());
+        BOOST_CHECK_EQUAL(throttle.transactions_to_fetch(), 1u);
+        BOOST_CHECK(!throttle.validation_finished());
+        BOOST_CHECK(!throttle.validation_finished());
+        BOOST_CHECK_EQUAL(throttle.being_validated(), 0u);
+        BOOST_CHECK_EQUAL(throttle.transactions_to_fetch(), limit);
+    }
+
+    BOOST_AUTO_TEST_CASE(stcp_plaintext_negotiation) {
+        for (bool local_allowed: {false, true}) {
+            for (bool remote_allowed: {false, true}) {
+                auto local_key = fc::ecc::private_key::generate();
+                auto remote_key = fc::ecc::private_key::generate();
+
+                // each side takes the flag from the key it receives
+                auto received_by_local = stcp_socket::key_exchange_data(remote_key.get_public_key(), remote_allowed);
+                auto received_by_remote = stcp_socket::key_exchange_data(local_key.get_public_key(), local_allowed);
+                bool local_plaintext = stcp_socket::take_plaintext_flag(received_by_local) && local_allowed;
+                bool remote_plaintext = stcp_socket::take_plaintext_flag(received_by_remote) && remote_allowed;
+
+                // both sides agree, plaintext only if both allow it
+                BOOST_CHECK_EQUAL(local_plaintext, local_allowed && remote_allowed);
+                BOOST_CHECK_EQUAL(remote_plaintext, local_plaintext);
+
+                // the keys are restored, so the shared secret still authenticates the nodes
+                BOOST_CHECK(received_by_local == remote_key.get_public_key().serialize());
+                BOOST_CHECK(received_by_remote == local_key.get_public_key().serialize());
+                BOOST_CHECK(local_key.get_shared_secret(received_by_local) == remote_key.get_shared_secret(received_by_remote));
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(stcp_legacy_peer_interoperates) {
+        auto key = fc::ecc::private_key::generate();
+        auto legacy_key = fc::ecc::private_key::generate();
+
+        // without plaintext allowed the key is sent as by nodes without the flag support
+        BOOST_CHECK(stcp_socket::key_exchange_data(key.get_public_key(), false) == key.get_public_key().serialize());
+
+        // the key of a legacy peer never has the flag, so a node allowing plaintext keeps encryption with it
+        auto received = legacy_key.get_public_key().serialize();
+        BOOST_CHECK(!stcp_socket::take_plaintext_flag(received));
+        BOOST_CHECK(received == legacy_key.get_public_key().serialize());
+        BOOST_CHECK(key.get_shared_secret(received) == legacy_key.get_shared_secret(key.get_public_key().serialize()));
+
+        // a legacy peer can't use a flagged key, which is why only upgraded nodes are configured as plaintext peers
+        auto flagged = stcp_socket::key_exchange_data(key.get_public_key(), true);
+        BOOST_CHECK(flagged != key.get_public_key().serialize());
+        BOOST_CHECK_THROW(legacy_key.get_shared_secret(flagged), fc::exception);
+    }
+
+    BOOST_AUTO_TEST_CASE(compact_block_round_trip) {
+        block_message block(block_with_transactions(5));
+        const auto block_message_hash = message(block).id();
+        auto compact_block = received_compact_block(block, block_message_hash);
+
+        BOOST_CHECK(compact_block.block_message_hash == block_message_hash);
+        BOOST_CHECK(compact_block.block_id == block.block_id);
+        BOOST_REQUIRE_EQUAL(compact_block.short_ids.size(), block.block.transactions.size());
+
+        // all transactions are in the message cache of the peer
+        std::multimap<uint64_t, signed_transaction> cache;
+        for (const auto &trx : block.block.transactions) {
+            cache.emplace(transaction_short_id(trx.id()), trx);
+        }
+        compact_block_reconstruction reconstruction(compact_block, [&](uint64_t short_id) {
+            auto itr = cache.find(short_id);
+            return itr != cache.end() ? fc::optional<signed_transaction>(itr->second) : fc::optional<signed_transaction>();
+        });
+        BOOST_CHECK(reconstruction.missing_transactions().empty());
+        BOOST_CHECK(reconstruction.add_missing_transactions({}));
+
+        auto rebuilt = reconstruction.to_block_message();
+        BOOST_CHECK(message(rebuilt).id() == block_message_hash);
+        BOOST_CHECK(rebuilt.block_id == block.block_id);
+        BOOST_CHECK(rebuilt.block.id() == block.block_id);
+
+        // an empty block has no transactions to find
+        block_message empty_block(block_with_transactions(0));
+        compact_block_reconstruction empty(received_compact_block(empty_block, message(empty_block).id()),
+                [](uint64_t) { return fc::optional<signed_transaction>(); });
+        BOOST_CHECK(empty.missing_transactions().empty());
+        BOOST_CHECK(message(empty.to_block_message()).id() == message(empty_block).id());
+    }
+
+    BOOST_AUTO_TEST_CASE(compact_block_with_missing_transactions) {
+        block_message block(block_with_transactions(5));
+        const auto block_message_hash = message(block).id();
+        const auto &transactions = block.block.transactions;
+        auto compact_block = received_compact_block(block, block_message_hash);
+
+        // only the second and the fourth transactions are cached
+        auto find_transaction = [&](uint64_t short_id) {
+            for (uint32_t i: {1, 3}) {
+                if (transaction_short_id(transactions[i].id()) == short_id) {
+                    return fc::optional<signed_transaction>(transactions[i]);
+                }
+            }
+            return fc::optional<signed_transaction>();
+        };
+
+        compact_block_reconstruction reconstruction(compact_block, find_transaction);
+        BOOST_CHECK(reconstruction.missing_transactions() == std::vector<uint32_t>({0, 2, 4}));
+
+        // the reply must have exactly the requested transactions
+        auto too_few = reconstruction;
+        BOOST_CHECK(!too_few.add_missing_transactions({transactions[0], transactions[2]}));
+        auto too_many = reconstruction;
+        BOOST_CHECK(!too_many.add_missing_transactions({transactions[0], transactions[2], transactions[4], transactions[1]}));
+
+        // transactions in a wrong order give another block, which is fetched in full
+        auto wrong_order = reconstruction;
+        BOOST_REQUIRE(wrong_order.add_missing_transactions({transactions[2], transactions[0], transactions[4]}));
+        BOOST_CHECK(message(wrong_order.to_block_message()).id() != block_message_hash);
+
+        BOOST_REQUIRE(reconstruction.add_missing_transactions({transactions[0], transactions[2], transactions[4]}));
+        BOOST_CHECK(reconstruction.missing_transactions().empty());
+        auto rebuilt = reconstruction.to_block_message();
+        BOOST_CHECK(message(rebuilt).id() == block_message_hash);
+        BOOST_REQUIRE_EQUAL(rebuilt.block.transactions.size(), transactions.size());
+        for (uint32_t i = 0; i < transactions.size(); ++i) {
+            BOOST_CHECK(rebuilt.block.transactions[i].id() == transactions[i].id());
+        }
+
+        // nothing found, all transactions are requested
+        compact_block_reconstruction nothing_found(compact_block, [](uint64_t) { return fc::optional<signed_transaction>(); });
+        BOOST_CHECK_EQUAL(nothing_found.missing_transactions().size(), transactions.size());
+        BOOST_REQUIRE(nothing_found.add_missing_transactions(transactions));
+        BOOST_CHECK(message(nothing_found.to_block_message()).id() == block_message_hash);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()